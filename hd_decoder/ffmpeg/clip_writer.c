@@ -0,0 +1,537 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/***********************************************************************
+* FILE NAME: clip_writer.c
+*
+* PURPOSE: muxing of the event clips on an I/O thread, out of the demux
+*          jobs which share the workers of all the streams
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#include "clip_writer.h"
+#include "cpu_affinity.h"
+
+#define CLIP_PATH_SIZE   1024
+#define QUEUE_MIN_CMDS   256
+
+typedef enum {
+    CLIP_CMD_OPEN = 0,
+    CLIP_CMD_PACKET,
+    CLIP_CMD_CLOSE,
+} clip_cmd_type_t;
+
+typedef struct clip_cmd_t {
+    clip_cmd_type_t type;
+    clip_t          *clip;
+    AVPacket        pkt;        /*CLIP_CMD_PACKET*/
+} clip_cmd_t;
+
+struct clip_t {
+    int               id;
+    char              path[CLIP_PATH_SIZE];
+    AVCodecParameters *par;
+    AVRational        time_base;
+    clip_counters_t   *counters;
+    atomic_int        failed;       /*the producer stops writing it*/
+
+    /*only touched by the I/O thread*/
+    AVFormatContext   *oc;
+    int64_t           ts_offset;    /*of the first packet in the file*/
+    int64_t           last_dts;
+};
+
+/*
+The commands of all the clips are in one queue, in the order of the
+producers. It grows for the open and close commands, the packets are
+refused over max_bytes instead: a slow disk cuts the clips but never
+blocks a demux job.
+*/
+struct clip_writer_t {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;       /*signaled to the I/O thread*/
+    pthread_cond_t  idle_cond;  /*signaled when the queue is written*/
+    clip_cmd_t      *cmds;
+    int             size;
+    int             head;
+    int             count;
+    int             busy;       /*the I/O thread runs a command*/
+    int             quit;
+
+    pthread_t       thread;
+
+    int64_t         max_bytes;
+    int64_t         queued_bytes;
+    int64_t         max_queued_bytes;
+    uint64_t        nb_clips;
+    uint64_t        nb_refused;
+};
+
+static int64_t packet_ts(const AVPacket *pkt) {
+    return pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+}
+
+static void free_clip(clip_t *clip) {
+    avcodec_parameters_free(&clip->par);
+    free(clip);
+}
+
+static int open_file(clip_t *clip) {
+    AVDictionary *opts = NULL;
+    AVFormatContext *oc = NULL;
+    AVStream *st;
+    int ret;
+
+    ret = avformat_alloc_output_context2(&oc, NULL, NULL, clip->path);
+    if (ret < 0 || !oc) {
+        printf("[%d] no container for the clip %s(error: %s)\n",
+                clip->id, clip->path, av_err2str(ret));
+        return -1;
+    }
+
+    st = avformat_new_stream(oc, NULL);
+    if (!st || avcodec_parameters_copy(st->codecpar, clip->par) < 0) {
+        printf("[%d] failed to add the video stream to the clip %s\n", clip->id, clip->path);
+        avformat_free_context(oc);
+        return -1;
+    }
+
+    /*the tag of the input container may not be valid in the clip*/
+    st->codecpar->codec_tag = 0;
+    st->time_base = clip->time_base;
+
+    if (!(oc->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&oc->pb, clip->path, AVIO_FLAG_WRITE);
+        if (ret < 0) {
+            printf("[%d] failed to create the clip %s(error: %s)\n",
+                    clip->id, clip->path, av_err2str(ret));
+            avformat_free_context(oc);
+            return -1;
+        }
+    }
+
+    /*
+    fragmented mp4: the clip is playable even if it is not finished,
+    and there is no big index to write at the end
+    */
+    if (!strcmp(oc->oformat->name, "mp4") || !strcmp(oc->oformat->name, "mov")) {
+        av_dict_set(&opts, "movflags", "frag_keyframe+empty_moov", 0);
+    }
+
+    ret = avformat_write_header(oc, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        printf("[%d] failed to write the header of the clip %s(error: %s)\n",
+                clip->id, clip->path, av_err2str(ret));
+        if (!(oc->oformat->flags & AVFMT_NOFILE)) {
+            avio_closep(&oc->pb);
+        }
+        avformat_free_context(oc);
+        return -1;
+    }
+
+    clip->oc        = oc;
+    clip->ts_offset = AV_NOPTS_VALUE;
+    clip->last_dts  = AV_NOPTS_VALUE;
+
+    return 0;
+}
+
+/*the packet is moved into the muxer*/
+static int write_file(clip_t *clip, AVPacket *pkt) {
+    AVStream *st = clip->oc->streams[0];
+    int64_t ts = packet_ts(pkt);
+    int size = pkt->size;
+    int ret;
+
+    if (ts == AV_NOPTS_VALUE) {
+        /*the muxer can not place it*/
+        return 0;
+    }
+
+    if (clip->ts_offset == AV_NOPTS_VALUE) {
+        clip->ts_offset = ts;
+    }
+
+    if (pkt->pts != AV_NOPTS_VALUE) {
+        pkt->pts -= clip->ts_offset;
+    }
+    if (pkt->dts != AV_NOPTS_VALUE) {
+        pkt->dts -= clip->ts_offset;
+    }
+    pkt->stream_index = 0;
+    pkt->pos          = -1;
+    av_packet_rescale_ts(pkt, clip->time_base, st->time_base);
+
+    /*the timestamps of a live stream may jump back a little*/
+    if (pkt->dts != AV_NOPTS_VALUE && clip->last_dts != AV_NOPTS_VALUE && pkt->dts <= clip->last_dts) {
+        pkt->dts = clip->last_dts + 1;
+        if (pkt->pts != AV_NOPTS_VALUE && pkt->pts < pkt->dts) {
+            pkt->pts = pkt->dts;
+        }
+    }
+    if (pkt->dts != AV_NOPTS_VALUE) {
+        clip->last_dts = pkt->dts;
+    }
+
+    ret = av_write_frame(clip->oc, pkt);
+    if (ret >= 0) {
+        atomic_fetch_add_explicit(&clip->counters->nb_packets, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&clip->counters->nb_bytes, size, memory_order_relaxed);
+    }
+
+    return ret;
+}
+
+static int close_file(clip_t *clip) {
+    int ret;
+
+    if (!clip->oc) {
+        return -1;
+    }
+
+    ret = av_write_trailer(clip->oc);
+    if (ret < 0) {
+        printf("[%d] failed to finish the clip %s(error: %s)\n",
+                clip->id, clip->path, av_err2str(ret));
+        atomic_fetch_add_explicit(&clip->counters->nb_errors, 1, memory_order_relaxed);
+    } else {
+        printf("[%d] clip %s is finished\n", clip->id, clip->path);
+    }
+
+    if (!(clip->oc->oformat->flags & AVFMT_NOFILE)) {
+        avio_closep(&clip->oc->pb);
+    }
+    avformat_free_context(clip->oc);
+    clip->oc = NULL;
+
+    return ret < 0 ? -1 : 0;
+}
+
+/*a failed clip drops the rest of its packets until it is closed*/
+static void fail_clip(clip_t *clip) {
+    atomic_fetch_add_explicit(&clip->counters->nb_errors, 1, memory_order_relaxed);
+    atomic_store_explicit(&clip->failed, 1, memory_order_relaxed);
+}
+
+/*
+* The I/O thread only
+*   return 1 if a clip is finished, otherwise 0
+*/
+static int run_cmd(clip_cmd_t *cmd) {
+    clip_t *clip = cmd->clip;
+    int ret;
+
+    switch (cmd->type) {
+        case CLIP_CMD_OPEN:
+            if (open_file(clip) < 0) {
+                fail_clip(clip);
+            }
+            break;
+
+        case CLIP_CMD_PACKET:
+            if (clip->oc && !atomic_load_explicit(&clip->failed, memory_order_relaxed)) {
+                ret = write_file(clip, &cmd->pkt);
+                if (ret < 0) {
+                    printf("[%d] failed to write the clip %s(error: %s)\n",
+                            clip->id, clip->path, av_err2str(ret));
+                    fail_clip(clip);
+                }
+            }
+            av_packet_unref(&cmd->pkt);
+            break;
+
+        case CLIP_CMD_CLOSE:
+            ret = close_file(clip);
+            free_clip(clip);
+            return ret == 0;
+    }
+
+    return 0;
+}
+
+static void *clipWriterThreadEntry(void *priv) {
+    clip_writer_t *w = (clip_writer_t *)priv;
+    clip_cmd_t cmd;
+    int size;
+    int finished;
+
+    pthread_mutex_lock(&w->lock);
+
+    for (;;) {
+        while (!w->count && !w->quit) {
+            pthread_cond_wait(&w->cond, &w->lock);
+        }
+
+        if (!w->count) {
+            break;
+        }
+
+        /*the references move with the struct, the queue may grow meanwhile*/
+        cmd = w->cmds[w->head];
+        w->head = (w->head + 1) % w->size;
+        w->count--;
+        w->busy = 1;
+        pthread_mutex_unlock(&w->lock);
+
+        size     = cmd.type == CLIP_CMD_PACKET ? cmd.pkt.size : 0;
+        finished = run_cmd(&cmd);
+
+        pthread_mutex_lock(&w->lock);
+        w->queued_bytes -= size;
+        w->nb_clips     += finished;
+        w->busy = 0;
+        if (!w->count) {
+            pthread_cond_broadcast(&w->idle_cond);
+        }
+    }
+
+    pthread_mutex_unlock(&w->lock);
+
+    return NULL;
+}
+
+/*under the lock*/
+static clip_cmd_t *queue_grow(clip_writer_t *w) {
+    int size = w->size ? w->size * 2 : QUEUE_MIN_CMDS;
+    clip_cmd_t *cmds;
+    int i;
+
+    if (w->count < w->size) {
+        return &w->cmds[(w->head + w->count) % w->size];
+    }
+
+    cmds = (clip_cmd_t *)malloc(size * sizeof(clip_cmd_t));
+    if (!cmds) {
+        printf("failed to malloc the clip queue of %d commands\n", size);
+        return NULL;
+    }
+
+    for (i = 0; i < w->count; i++) {
+        cmds[i] = w->cmds[(w->head + i) % w->size];
+    }
+
+    free(w->cmds);
+    w->cmds = cmds;
+    w->size = size;
+    w->head = 0;
+
+    return &w->cmds[w->count];
+}
+
+/*under the lock*/
+static void queue_cmd(clip_writer_t *w) {
+    w->count++;
+    pthread_cond_signal(&w->cond);
+}
+
+clip_writer_t *clip_writer_create(int64_t max_bytes) {
+    clip_writer_t *w;
+    int ret;
+
+    if (max_bytes <= 0) {
+        printf("invalid memory of the clip writer: %lld bytes\n", (long long)max_bytes);
+        return NULL;
+    }
+
+    w = (clip_writer_t *)calloc(1, sizeof(clip_writer_t));
+    if (w == NULL) {
+        printf("failed to malloc clip_writer_t\n");
+        return NULL;
+    }
+
+    w->max_bytes = max_bytes;
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->cond, NULL);
+    pthread_cond_init(&w->idle_cond, NULL);
+
+    ret = pthread_create(&w->thread, NULL, clipWriterThreadEntry, (void *)w);
+    if (ret != 0) {
+        printf("Failed to create clip writer thread(res=%d, error=%s)\n",
+                ret, strerror(ret));
+        pthread_cond_destroy(&w->idle_cond);
+        pthread_cond_destroy(&w->cond);
+        pthread_mutex_destroy(&w->lock);
+        free(w);
+        return NULL;
+    }
+    pthread_setname_np(w->thread, "clip_writer");
+
+    return w;
+}
+
+void clip_writer_destroy(clip_writer_t *w) {
+    if (!w) {
+        return;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    w->quit = 1;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+
+    pthread_join(w->thread, NULL);
+
+    pthread_cond_destroy(&w->idle_cond);
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->lock);
+
+    free(w->cmds);
+    free(w);
+}
+
+int clip_writer_set_affinity(clip_writer_t *w, const char *cpus) {
+    return cpu_affinity_set(w->thread, cpus);
+}
+
+clip_t *clip_writer_open(clip_writer_t *w, const char *path, const AVCodecParameters *par,
+                         AVRational time_base, clip_counters_t *counters, int id) {
+    clip_cmd_t *cmd;
+    clip_t *clip;
+
+    clip = (clip_t *)calloc(1, sizeof(clip_t));
+    if (!clip) {
+        printf("[%d] failed to malloc clip_t\n", id);
+        return NULL;
+    }
+
+    clip->id        = id;
+    clip->time_base = time_base;
+    clip->counters  = counters;
+    snprintf(clip->path, sizeof(clip->path), "%s", path);
+    atomic_init(&clip->failed, 0);
+
+    clip->par = avcodec_parameters_alloc();
+    if (!clip->par || avcodec_parameters_copy(clip->par, par) < 0) {
+        printf("[%d] failed to copy the codec parameters of the clip %s\n", id, path);
+        free_clip(clip);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    cmd = queue_grow(w);
+    if (!cmd) {
+        pthread_mutex_unlock(&w->lock);
+        free_clip(clip);
+        return NULL;
+    }
+    cmd->type = CLIP_CMD_OPEN;
+    cmd->clip = clip;
+    queue_cmd(w);
+    pthread_mutex_unlock(&w->lock);
+
+    return clip;
+}
+
+int clip_writer_write(clip_writer_t *w, clip_t *clip, const AVPacket *pkt) {
+    clip_cmd_t *cmd;
+
+    if (atomic_load_explicit(&clip->failed, memory_order_relaxed)) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&w->lock);
+
+    if (w->queued_bytes + pkt->size > w->max_bytes) {
+        w->nb_refused++;
+        pthread_mutex_unlock(&w->lock);
+        printf("[%d] the disk is too slow for the clip %s, cut it\n", clip->id, clip->path);
+        fail_clip(clip);
+        return -1;
+    }
+
+    cmd = queue_grow(w);
+    if (!cmd) {
+        pthread_mutex_unlock(&w->lock);
+        fail_clip(clip);
+        return -1;
+    }
+
+    av_init_packet(&cmd->pkt);
+    if (av_packet_ref(&cmd->pkt, pkt) < 0) {
+        pthread_mutex_unlock(&w->lock);
+        printf("[%d] failed to reference the packet of the clip %s\n", clip->id, clip->path);
+        fail_clip(clip);
+        return -1;
+    }
+    cmd->type = CLIP_CMD_PACKET;
+    cmd->clip = clip;
+
+    w->queued_bytes += pkt->size;
+    if (w->queued_bytes > w->max_queued_bytes) {
+        w->max_queued_bytes = w->queued_bytes;
+    }
+    queue_cmd(w);
+
+    pthread_mutex_unlock(&w->lock);
+
+    return 0;
+}
+
+void clip_writer_close(clip_writer_t *w, clip_t *clip) {
+    clip_cmd_t *cmd;
+
+    pthread_mutex_lock(&w->lock);
+
+    cmd = queue_grow(w);
+    while (!cmd) {
+        /*the clip can not be leaked, the queue shrinks as it is written*/
+        pthread_cond_wait(&w->idle_cond, &w->lock);
+        cmd = queue_grow(w);
+    }
+    cmd->type = CLIP_CMD_CLOSE;
+    cmd->clip = clip;
+    queue_cmd(w);
+
+    pthread_mutex_unlock(&w->lock);
+}
+
+void clip_writer_flush(clip_writer_t *w) {
+    pthread_mutex_lock(&w->lock);
+
+    while (w->count || w->busy) {
+        pthread_cond_wait(&w->idle_cond, &w->lock);
+    }
+
+    pthread_mutex_unlock(&w->lock);
+}
+
+void clip_writer_get_stats(clip_writer_t *w, clip_writer_stats_t *stats) {
+    pthread_mutex_lock(&w->lock);
+
+    stats->max_bytes        = w->max_bytes;
+    stats->queued_bytes     = w->queued_bytes;
+    stats->max_queued_bytes = w->max_queued_bytes;
+    stats->nb_clips         = w->nb_clips;
+    stats->nb_refused       = w->nb_refused;
+
+    pthread_mutex_unlock(&w->lock);
+}
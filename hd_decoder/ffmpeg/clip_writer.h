@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/***********************************************************************
+* FILE NAME: clip_writer.h
+*
+* PURPOSE: asynchronous muxer of the event clips on an I/O thread, the
+*          demux jobs only queue references of the packets
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#ifndef __CLIP_WRITER_H_
+#define __CLIP_WRITER_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include <libavformat/avformat.h>
+
+typedef struct clip_writer_stats_t {
+    int64_t  max_bytes;
+    int64_t  queued_bytes;      /*packets waiting for the disk*/
+    int64_t  max_queued_bytes;
+    uint64_t nb_clips;          /*finished*/
+    uint64_t nb_refused;        /*packets over max_bytes, their clips are cut*/
+} clip_writer_stats_t;
+
+/*counters of the clips of one owner, updated on the I/O thread*/
+typedef struct clip_counters_t {
+    atomic_ullong nb_packets;   /*written into the files*/
+    atomic_ullong nb_bytes;
+    atomic_ullong nb_errors;
+} clip_counters_t;
+
+typedef struct clip_writer_t clip_writer_t;
+typedef struct clip_t clip_t;
+
+/*
+* Start the I/O thread, max_bytes of the packets may wait for the disk
+*/
+clip_writer_t *clip_writer_create(int64_t max_bytes);
+
+/*
+* Finish the queued clips, then stop the I/O thread and free the writer
+*/
+void clip_writer_destroy(clip_writer_t *w);
+
+/*
+* Run the I/O thread only on the cpus of the list like "0-3,6"
+*   return 0 on success, -1 on failure
+*/
+int clip_writer_set_affinity(clip_writer_t *w, const char *cpus);
+
+/*
+* Queue a new clip file of the stream, it is created on the I/O thread,
+* the extension of path picks the container
+*   counters: of the owner, used until clip_writer_flush() returns
+*   id:       stream index, for the log
+*   return NULL on failure
+*/
+clip_t *clip_writer_open(clip_writer_t *w, const char *path, const AVCodecParameters *par,
+                         AVRational time_base, clip_counters_t *counters, int id);
+
+/*
+* Queue a reference of the packet, in the time base of the clip, it never
+* blocks. The timestamps of the file start at 0
+*   return 0 if queued, -1 if the clip failed or max_bytes are queued:
+*          the clip is cut, close it
+*/
+int clip_writer_write(clip_writer_t *w, clip_t *clip, const AVPacket *pkt);
+
+/*
+* Queue the end of the clip, the I/O thread writes the trailer and frees it
+*/
+void clip_writer_close(clip_writer_t *w, clip_t *clip);
+
+/*
+* Wait until everything queued before is written
+*/
+void clip_writer_flush(clip_writer_t *w);
+
+void clip_writer_get_stats(clip_writer_t *w, clip_writer_stats_t *stats);
+
+#endif /* __CLIP_WRITER_H_ */
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: cpu_affinity.c
+*
+* PURPOSE: pin the threads to the cpus of a list like "0-3,6"
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#include "cpu_affinity.h"
+
+/*
+* "0-3,6" into the set
+*   return the number of cpus, -1 if the list is invalid
+*/
+static int parse_cpu_list(const char *cpus, cpu_set_t *set) {
+    int nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *p = cpus;
+    char *end;
+    long first;
+    long last;
+    long i;
+
+    CPU_ZERO(set);
+
+    while (*p) {
+        first = strtol(p, &end, 10);
+        if (end == p) {
+            return -1;
+        }
+        last = first;
+
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p) {
+                return -1;
+            }
+            p = end;
+        }
+
+        if (first < 0 || last < first || last >= nb_cpus || last >= CPU_SETSIZE) {
+            return -1;
+        }
+
+        for (i = first; i <= last; i++) {
+            CPU_SET(i, set);
+        }
+
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return -1;
+        }
+    }
+
+    return CPU_COUNT(set) ? CPU_COUNT(set) : -1;
+}
+
+int cpu_affinity_check(const char *cpus) {
+    cpu_set_t set;
+
+    return parse_cpu_list(cpus, &set);
+}
+
+int cpu_affinity_set(pthread_t thread, const char *cpus) {
+    cpu_set_t set;
+    int ret;
+
+    if (parse_cpu_list(cpus, &set) < 0) {
+        printf("invalid cpu list: %s\n", cpus);
+        return -1;
+    }
+
+    ret = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if (ret != 0) {
+        printf("failed to set the affinity to cpus %s(error: %s)\n", cpus, strerror(ret));
+        return -1;
+    }
+
+    return 0;
+}
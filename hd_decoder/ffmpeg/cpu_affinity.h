@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: cpu_affinity.h
+*
+* PURPOSE: pin the threads to the cpus of a list like "0-3,6"
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#ifndef __CPU_AFFINITY_H_
+#define __CPU_AFFINITY_H_
+
+#include <pthread.h>
+
+/*
+* Return the number of cpus in the list, -1 if it is invalid or names
+* a cpu which is not online
+*/
+int cpu_affinity_check(const char *cpus);
+
+/*
+* Run the thread only on the cpus of the list
+*   return 0 on success, -1 on failure
+*/
+int cpu_affinity_set(pthread_t thread, const char *cpus);
+
+#endif /* __CPU_AFFINITY_H_ */
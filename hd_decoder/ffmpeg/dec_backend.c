@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: dec_backend.c
+*
+* PURPOSE: select and open the Jetson hardware decoder or the libavcodec
+*          software decoder of a stream
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include <libavutil/pixdesc.h>
+
+#include "dec_backend.h"
+
+#define HW_DECODER_SUFFIX "_nvv4l2dec"
+
+static const struct {
+    enum AVCodecID codec_id;
+    const char     *name;
+} hw_decoders[] = {
+    { AV_CODEC_ID_H264,       "h264_nvv4l2dec"  },
+    { AV_CODEC_ID_HEVC,       "hevc_nvv4l2dec"  },
+    { AV_CODEC_ID_MPEG2VIDEO, "mpeg2_nvv4l2dec" },
+    { AV_CODEC_ID_MPEG4,      "mpeg4_nvv4l2dec" },
+    { AV_CODEC_ID_VP8,        "vp8_nvv4l2dec"   },
+    { AV_CODEC_ID_VP9,        "vp9_nvv4l2dec"   },
+};
+
+static const char *backend_names[DEC_BACKEND_MAX] = {
+    "auto", "hw", "sw"
+};
+
+/*hardware decoders opened by the process*/
+static atomic_int g_nb_hw_decoders = 0;
+
+const char *dec_backend_name(dec_backend_t backend) {
+    if (backend < 0 || backend >= DEC_BACKEND_MAX) {
+        return "unknown";
+    }
+
+    return backend_names[backend];
+}
+
+dec_backend_t dec_backend_from_name(const char *name) {
+    int i;
+
+    for (i = 0; i < DEC_BACKEND_MAX; i++) {
+        if (!strcmp(name, backend_names[i])) {
+            return (dec_backend_t)i;
+        }
+    }
+
+    return DEC_BACKEND_MAX;
+}
+
+int dec_backend_thread_type_from_name(const char *name) {
+    if (!strcmp(name, "frame")) {
+        return FF_THREAD_FRAME;
+    } else if (!strcmp(name, "slice")) {
+        return FF_THREAD_SLICE;
+    } else if (!strcmp(name, "frame+slice")) {
+        return FF_THREAD_FRAME | FF_THREAD_SLICE;
+    }
+
+    return -1;
+}
+
+static int is_hw_codec(const AVCodec *codec) {
+    int len = strlen(codec->name);
+    int suffix_len = strlen(HW_DECODER_SUFFIX);
+
+    return len > suffix_len && !strcmp(codec->name + len - suffix_len, HW_DECODER_SUFFIX);
+}
+
+int dec_backend_is_hw(const AVCodecContext *avctx) {
+    return avctx->codec && is_hw_codec(avctx->codec);
+}
+
+static AVCodec *find_hw_decoder(enum AVCodecID codec_id) {
+    AVCodec *codec;
+    int i;
+
+    for (i = 0; i < sizeof(hw_decoders) / sizeof(hw_decoders[0]); i++) {
+        if (hw_decoders[i].codec_id == codec_id) {
+            codec = avcodec_find_decoder_by_name(hw_decoders[i].name);
+            if (!codec) {
+                printf("Unknown decoder '%s'\n", hw_decoders[i].name);
+            }
+            return codec;
+        }
+    }
+
+    printf("[Vcodec: %s]: Unsupported for Jetson HW decoder\n", avcodec_get_name(codec_id));
+
+    return NULL;
+}
+
+static AVCodec *find_sw_decoder(enum AVCodecID codec_id) {
+    AVCodec *codec;
+
+    /*the native decoder is named after the codec, avcodec_find_decoder()
+      may return a hardware wrapper registered for the same codec*/
+    codec = avcodec_find_decoder_by_name(avcodec_get_name(codec_id));
+    if (codec && codec->id == codec_id && !is_hw_codec(codec)) {
+        return codec;
+    }
+
+    codec = avcodec_find_decoder(codec_id);
+    if (codec && is_hw_codec(codec)) {
+        return NULL;
+    }
+
+    return codec;
+}
+
+/*take a hardware decoder if the limit allows*/
+static int reserve_hw_decoder(const dec_backend_config_t *cfg) {
+    int nb = atomic_load(&g_nb_hw_decoders);
+
+    do {
+        if (cfg->max_hw > 0 && nb >= cfg->max_hw) {
+            return 0;
+        }
+    } while (!atomic_compare_exchange_weak(&g_nb_hw_decoders, &nb, nb + 1));
+
+    return 1;
+}
+
+static AVCodecContext *open_codec(const dec_backend_config_t *cfg, AVCodec *codec,
+                                  const AVCodecParameters *par, frame_pool_t *pool,
+                                  int id) {
+    AVDictionary *codec_dict = NULL;
+    AVCodecContext *avctx;
+    int ret;
+
+    avctx = avcodec_alloc_context3(codec);
+    if (! avctx) {
+        printf("Error allocating the video decoder context\n");
+        return NULL;
+    }
+
+    ret = avcodec_parameters_to_context(avctx, par);
+    if (ret < 0) {
+        printf("Error(%s) initializing the video decoder context.", av_err2str(ret));
+        avcodec_free_context(&avctx);
+        return NULL;
+    }
+
+    if (!is_hw_codec(codec)) {
+        avctx->thread_count = cfg->thread_count;
+        if (cfg->thread_type) {
+            avctx->thread_type = cfg->thread_type;
+        }
+    }
+
+    if (pool && frame_pool_attach(pool, avctx, par) < 0) {
+        printf("[%d] %s allocates its own pictures, they are not pooled\n",
+                id, codec->name);
+    }
+
+    ret = avcodec_open2(avctx, codec, &codec_dict);
+    av_dict_free(&codec_dict);
+    if (ret < 0) {
+        printf("[%d] Error(%s) opening the video codec %s\n", id, av_err2str(ret), codec->name);
+        avcodec_free_context(&avctx);
+        return NULL;
+    }
+
+    printf("[%d][%s - %s] Decoded vstream: w(%d), h(%d), bitrate(%ld)\n",
+            id,
+            codec->name,
+            codec->long_name,
+            par->width,
+            par->height,
+            (long)par->bit_rate);
+
+    if (codec->pix_fmts) {
+        /*it is an array of pixel formats, the codec chooses the
+          first element of the array which isn't a hardware-accel-only
+          pixel format*/
+        const enum AVPixelFormat *p = codec->pix_fmts;
+        const char *name = av_get_pix_fmt_name(*p);
+
+        printf("Decoded pixel format: %s\n", name);
+    }
+
+    if (!is_hw_codec(codec)) {
+        printf("[%d] software decoder: %d threads(%s)\n", id, avctx->thread_count,
+                avctx->active_thread_type == FF_THREAD_FRAME ? "frame" :
+                avctx->active_thread_type == FF_THREAD_SLICE ? "slice" : "none");
+    }
+
+    return avctx;
+}
+
+AVCodecContext *dec_backend_open(const dec_backend_config_t *cfg,
+                                 const AVCodecParameters *par,
+                                 frame_pool_t *pool, int id) {
+    AVCodecContext *avctx;
+    AVCodec *codec;
+
+    if (cfg->backend != DEC_BACKEND_SW) {
+        codec = find_hw_decoder(par->codec_id);
+
+        if (codec && reserve_hw_decoder(cfg)) {
+            avctx = open_codec(cfg, codec, par, pool, id);
+            if (avctx) {
+                return avctx;
+            }
+
+            atomic_fetch_sub(&g_nb_hw_decoders, 1);
+        } else if (codec) {
+            printf("[%d] all the %d hardware decoders are in use\n", id, cfg->max_hw);
+        }
+
+        if (cfg->backend == DEC_BACKEND_HW) {
+            printf("[%d] no hardware decoder for %s\n", id, avcodec_get_name(par->codec_id));
+            return NULL;
+        }
+
+        printf("[%d] fall back to the software decoder\n", id);
+    }
+
+    codec = find_sw_decoder(par->codec_id);
+    if (!codec) {
+        printf("Failed to get AVCodec for %s\n", avcodec_get_name(par->codec_id));
+        return NULL;
+    }
+
+    return open_codec(cfg, codec, par, pool, id);
+}
+
+void dec_backend_close(AVCodecContext **avctx) {
+    if (!*avctx) {
+        return;
+    }
+
+    if (dec_backend_is_hw(*avctx)) {
+        atomic_fetch_sub(&g_nb_hw_decoders, 1);
+    }
+
+    avcodec_close(*avctx);
+    avcodec_free_context(avctx);
+}
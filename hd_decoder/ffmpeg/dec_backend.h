@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: dec_backend.h
+*
+* PURPOSE: select and open the Jetson hardware decoder or the libavcodec
+*          software decoder of a stream
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#ifndef __DEC_BACKEND_H_
+#define __DEC_BACKEND_H_
+
+#include <libavcodec/avcodec.h>
+
+#include "frame_pool.h"
+
+typedef enum {
+    DEC_BACKEND_AUTO = 0,   /*hardware, software if it is missing, fails or is full*/
+    DEC_BACKEND_HW,         /**_nvv4l2dec only*/
+    DEC_BACKEND_SW,         /*libavcodec software decoders only*/
+
+    DEC_BACKEND_MAX
+} dec_backend_t;
+
+typedef struct dec_backend_config_t {
+    dec_backend_t backend;
+    int           max_hw;       /*hardware decoders opened at the same time, 0: no limit,
+                                  the others spill to software in auto mode*/
+
+    /*software decoders only*/
+    int           thread_count; /*0: one thread per cpu core, for a single stream: the
+                                  decoders of many streams take 1, or they oversubscribe
+                                  the cores*/
+    int           thread_type;  /*FF_THREAD_FRAME and/or FF_THREAD_SLICE, 0: default*/
+} dec_backend_config_t;
+
+const char *dec_backend_name(dec_backend_t backend);
+
+/*
+* return DEC_BACKEND_MAX for an unknown name
+*/
+dec_backend_t dec_backend_from_name(const char *name);
+
+/*
+* "frame", "slice" or "frame+slice" to FF_THREAD_*
+*   return -1 for an unknown name
+*/
+int dec_backend_thread_type_from_name(const char *name);
+
+/*
+* Open a decoder of the stream
+*   pool: pictures of the decoder, NULL for the default allocator
+*   id:   stream index, for the log
+*   return the opened decoder context, NULL on failure
+*/
+AVCodecContext *dec_backend_open(const dec_backend_config_t *cfg,
+                                 const AVCodecParameters *par,
+                                 frame_pool_t *pool, int id);
+
+/*
+* return 1 if the decoder context runs on the hardware decoder
+*/
+int dec_backend_is_hw(const AVCodecContext *avctx);
+
+/*
+* Close and free the decoder context opened by dec_backend_open()
+*/
+void dec_backend_close(AVCodecContext **avctx);
+
+#endif /* __DEC_BACKEND_H_ */
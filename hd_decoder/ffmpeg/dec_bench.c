@@ -0,0 +1,661 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: dec_bench.c
+*
+* PURPOSE: benchmark of the decoder throughput and latency on local files
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   One thread per software decoder with several instances
+************************************************************************/
+
+/*
+example:
+decode the file 10 times on 1 decoder:
+./dec_bench -i 1080p.h264.mp4 -l 10
+
+4 concurrent decoders for 30 seconds on the software backend,
+the results are written into sw.json:
+./dec_bench -i 1080p.h264.mp4 -i 4k.hevc.mkv -j 4 -d 30 -b sw -o sw.json
+
+The packets are read into memory before the benchmark, the numbers are of
+the decoder only. Latency is from avcodec_send_packet() of a packet to
+avcodec_receive_frame() of its frame, matched by pts.
+*/
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+
+#include "dec_backend.h"
+#include "frame_pool.h"
+#include "hdr_hist.h"
+
+#define MAX_FILES          16
+#define MAX_INSTANCES      256
+#define LATENCY_MAX_US     (60LL * 1000000)
+#define FRAME_POOL_FRAMES  16
+#define FRAME_POOL_BUFFERS 32
+
+typedef struct pts_index_t {
+    int64_t pts;
+    int     pkt_index;
+} pts_index_t;
+
+typedef struct bench_file_t {
+    char              *path;
+    AVCodecParameters *par;
+    AVPacket          **pkts;     /*video packets of the file in decoding order*/
+    int               nb_pkts;
+    pts_index_t       *pts_index; /*sorted by pts, to find the packet of a frame*/
+    int               nb_pts;
+} bench_file_t;
+
+typedef struct bench_t bench_t;
+
+typedef struct instance_t {
+    int            id;
+    bench_t        *bench;
+    bench_file_t   *file;
+    pthread_t      thread;
+
+    AVCodecContext *avctx;
+    frame_pool_t   *frame_pool;
+    char           decoder[64];
+    int64_t        *send_us;      /*send time of each packet*/
+
+    int            loops;
+    uint64_t       nb_frames;
+    uint64_t       nb_pixels;
+    uint64_t       nb_unmatched;  /*frames without the pts of a packet*/
+    uint64_t       nb_errors;
+    int64_t        elapsed_us;
+    hdr_hist_t     *latency;      /*us*/
+    int            failed;
+} instance_t;
+
+struct bench_t {
+    bench_file_t         files[MAX_FILES];
+    int                  nb_files;
+    instance_t           instances[MAX_INSTANCES];
+    int                  nb_instances;
+    int                  loops;
+    int                  duration;    /*seconds, 0: run the loops*/
+
+    dec_backend_config_t backend;
+    pthread_barrier_t    start;
+    int64_t              start_us;
+};
+
+
+static void usage(char *programname)
+{
+    printf("%s (compiled %s)\n", programname, __DATE__);
+    printf(("Usage %s [OPTION]\n"
+        " -i <video file>                        : H.264/HEVC file, repeat it for more files\n"
+        " -j <number of instances>(default: 1)   : concurrent decoders, they take the files in turn\n"
+        " -l <loops>(default: 1)                 : times every decoder decodes its file\n"
+        " -d <seconds>                           : decode for this time instead of the loops\n"
+        " -b <auto/hw/sw>(default: auto)         : decoder backend\n"
+        " -H <number of decoders>                : max hardware decoders, the others use software in auto mode\n"
+        " -n <number of threads>                 : threads of a software decoder, 0: number of cpu cores,\n"
+        "                                          default: 1 with several instances, else 0\n"
+        " -x <frame/slice>                       : threading of a software decoder\n"
+        " -o <json file>(default: dec_bench.json): results\n"
+        " -h, --help                             : print this help and exit\n"),
+        programname);
+}
+
+static int64_t get_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t get_cpu_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int compare_pts(const void *a, const void *b) {
+    const pts_index_t *pa = (const pts_index_t *)a;
+    const pts_index_t *pb = (const pts_index_t *)b;
+
+    return pa->pts < pb->pts ? -1 : pa->pts > pb->pts;
+}
+
+static int find_packet(const bench_file_t *file, int64_t pts) {
+    int lo = 0;
+    int hi = file->nb_pts - 1;
+    int mid;
+
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        if (file->pts_index[mid].pts == pts) {
+            return file->pts_index[mid].pkt_index;
+        } else if (file->pts_index[mid].pts < pts) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    return -1;
+}
+
+/*
+* Read all the video packets of the file into memory
+*/
+static int load_file(bench_file_t *file) {
+    AVFormatContext *ctx = NULL;
+    AVPacket pkt;
+    AVPacket **pkts;
+    int vstrm_index = -1;
+    int size = 0;
+    int ret;
+    int i;
+
+    ret = avformat_open_input(&ctx, file->path, NULL, NULL);
+    if (ret < 0) {
+        printf("%s: avformat_open_input() -- Failure(%s)!\n", file->path, av_err2str(ret));
+        return -1;
+    }
+
+    ret = avformat_find_stream_info(ctx, NULL);
+    if (ret < 0) {
+        printf("%s: could not find codec parameters\n", file->path);
+        avformat_close_input(&ctx);
+        return -1;
+    }
+
+    for (i = 0; i < ctx->nb_streams; i++) {
+        if (ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            vstrm_index = i;
+            break;
+        }
+    }
+
+    if (vstrm_index < 0) {
+        printf("%s: no video stream\n", file->path);
+        avformat_close_input(&ctx);
+        return -1;
+    }
+
+    file->par = avcodec_parameters_alloc();
+    if (!file->par ||
+        avcodec_parameters_copy(file->par, ctx->streams[vstrm_index]->codecpar) < 0) {
+        printf("failed to copy the codec parameters\n");
+        avformat_close_input(&ctx);
+        return -1;
+    }
+
+    av_init_packet(&pkt);
+    while ((ret = av_read_frame(ctx, &pkt)) >= 0) {
+        if (pkt.stream_index != vstrm_index) {
+            av_packet_unref(&pkt);
+            continue;
+        }
+
+        if (file->nb_pkts == size) {
+            size = size ? size * 2 : 1024;
+            pkts = (AVPacket **)realloc(file->pkts, size * sizeof(AVPacket *));
+            if (pkts == NULL) {
+                printf("failed to malloc %d packets\n", size);
+                av_packet_unref(&pkt);
+                break;
+            }
+            file->pkts = pkts;
+        }
+
+        file->pkts[file->nb_pkts] = av_packet_alloc();
+        if (!file->pkts[file->nb_pkts]) {
+            av_packet_unref(&pkt);
+            break;
+        }
+        av_packet_move_ref(file->pkts[file->nb_pkts], &pkt);
+        file->nb_pkts++;
+    }
+    avformat_close_input(&ctx);
+
+    if (ret != AVERROR_EOF) {
+        printf("%s: failed to read the packets(%s)\n", file->path, av_err2str(ret));
+        return -1;
+    }
+
+    if (!file->nb_pkts) {
+        printf("%s: no video packet\n", file->path);
+        return -1;
+    }
+
+    file->pts_index = (pts_index_t *)malloc(file->nb_pkts * sizeof(pts_index_t));
+    if (file->pts_index == NULL) {
+        printf("failed to malloc pts index\n");
+        return -1;
+    }
+
+    for (i = 0; i < file->nb_pkts; i++) {
+        if (file->pkts[i]->pts != AV_NOPTS_VALUE) {
+            file->pts_index[file->nb_pts].pts       = file->pkts[i]->pts;
+            file->pts_index[file->nb_pts].pkt_index = i;
+            file->nb_pts++;
+        }
+    }
+    qsort(file->pts_index, file->nb_pts, sizeof(pts_index_t), compare_pts);
+
+    printf("%s: %d packets of %s %dx%d\n", file->path, file->nb_pkts,
+            avcodec_get_name(file->par->codec_id), file->par->width, file->par->height);
+
+    return 0;
+}
+
+static void free_file(bench_file_t *file) {
+    int i;
+
+    for (i = 0; i < file->nb_pkts; i++) {
+        av_packet_free(&file->pkts[i]);
+    }
+
+    free(file->pkts);
+    free(file->pts_index);
+    avcodec_parameters_free(&file->par);
+}
+
+/*
+* Receive all the frames ready in the decoder
+*   return AVERROR(EAGAIN) when it needs more packets,
+*          AVERROR_EOF after the last frame of a drain
+*/
+static int receive_frames(instance_t *inst, AVFrame *frame) {
+    int64_t now_us;
+    int idx;
+    int ret;
+
+    for (;;) {
+        ret = avcodec_receive_frame(inst->avctx, frame);
+        if (ret < 0) {
+            if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+                inst->nb_errors++;
+            }
+            return ret;
+        }
+
+        now_us = get_time_us();
+        idx = frame->pts != AV_NOPTS_VALUE ? find_packet(inst->file, frame->pts) : -1;
+        if (idx >= 0 && inst->send_us[idx] > 0) {
+            hdr_hist_record(inst->latency, now_us - inst->send_us[idx]);
+            inst->send_us[idx] = 0;
+        } else {
+            inst->nb_unmatched++;
+        }
+
+        inst->nb_frames++;
+        inst->nb_pixels += (uint64_t)frame->width * frame->height;
+        av_frame_unref(frame);
+    }
+}
+
+static void *instanceThreadEntry(void *priv) {
+    instance_t *inst = (instance_t *)priv;
+    bench_t *bench = inst->bench;
+    bench_file_t *file = inst->file;
+    AVFrame *frame = NULL;
+    int64_t start_us;
+    int stop = 0;
+    int ret;
+    int i;
+
+    inst->avctx = dec_backend_open(&bench->backend, file->par, inst->frame_pool, inst->id);
+    frame = av_frame_alloc();
+    if (!inst->avctx || !frame) {
+        inst->failed = 1;
+    } else {
+        snprintf(inst->decoder, sizeof(inst->decoder), "%s", inst->avctx->codec->name);
+    }
+
+    /*all the decoders are opened before the clock starts*/
+    pthread_barrier_wait(&bench->start);
+    if (inst->failed) {
+        av_frame_free(&frame);
+        return NULL;
+    }
+
+    start_us = get_time_us();
+    while (!stop) {
+        for (i = 0; i < file->nb_pkts; i++) {
+            inst->send_us[i] = get_time_us();
+            ret = avcodec_send_packet(inst->avctx, file->pkts[i]);
+            if (ret < 0) {
+                inst->nb_errors++;
+            }
+
+            receive_frames(inst, frame);
+
+            if (bench->duration &&
+                get_time_us() - start_us >= bench->duration * 1000000LL) {
+                stop = 1;
+                break;
+            }
+        }
+
+        /*drain, then start the next loop from a clean decoder*/
+        avcodec_send_packet(inst->avctx, NULL);
+        receive_frames(inst, frame);
+        avcodec_flush_buffers(inst->avctx);
+
+        inst->loops++;
+        if (!bench->duration && inst->loops == bench->loops) {
+            stop = 1;
+        }
+    }
+    inst->elapsed_us = get_time_us() - start_us;
+
+    av_frame_free(&frame);
+
+    return NULL;
+}
+
+static void write_latency(FILE *fp, const hdr_hist_t *hist, const char *indent) {
+    fprintf(fp, "{\n");
+    fprintf(fp, "%s  \"count\": %llu,\n", indent, (unsigned long long)hdr_hist_count(hist));
+    fprintf(fp, "%s  \"min\": %lld,\n", indent, (long long)hdr_hist_min(hist));
+    fprintf(fp, "%s  \"mean\": %.1f,\n", indent, hdr_hist_mean(hist));
+    fprintf(fp, "%s  \"p50\": %lld,\n", indent, (long long)hdr_hist_percentile(hist, 50));
+    fprintf(fp, "%s  \"p99\": %lld,\n", indent, (long long)hdr_hist_percentile(hist, 99));
+    fprintf(fp, "%s  \"p999\": %lld,\n", indent, (long long)hdr_hist_percentile(hist, 99.9));
+    fprintf(fp, "%s  \"max\": %lld\n", indent, (long long)hdr_hist_max(hist));
+    fprintf(fp, "%s}", indent);
+}
+
+/*file paths in the json, only '"' and '\' are escaped*/
+static void write_string(FILE *fp, const char *str) {
+    fputc('"', fp);
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\') {
+            fputc('\\', fp);
+        }
+        fputc(*str, fp);
+    }
+    fputc('"', fp);
+}
+
+static int write_results(bench_t *bench, const char *path, int64_t elapsed_us,
+                         int64_t cpu_us, hdr_hist_t *latency) {
+    uint64_t nb_frames = 0;
+    uint64_t nb_pixels = 0;
+    double seconds = elapsed_us / 1000000.0;
+    FILE *fp;
+    int i;
+
+    for (i = 0; i < bench->nb_instances; i++) {
+        nb_frames += bench->instances[i].nb_frames;
+        nb_pixels += bench->instances[i].nb_pixels;
+    }
+
+    fp = fopen(path, "w");
+    if (!fp) {
+        printf("failed to create %s(error: %s)\n", path, strerror(errno));
+        return -1;
+    }
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"backend\": \"%s\",\n", dec_backend_name(bench->backend.backend));
+    fprintf(fp, "  \"instances\": %d,\n", bench->nb_instances);
+    fprintf(fp, "  \"threads\": %d,\n", bench->backend.thread_count);
+    fprintf(fp, "  \"seconds\": %.3f,\n", seconds);
+    fprintf(fp, "  \"frames\": %llu,\n", (unsigned long long)nb_frames);
+    fprintf(fp, "  \"fps\": %.1f,\n", seconds > 0 ? nb_frames / seconds : 0);
+    fprintf(fp, "  \"mpix_per_s\": %.1f,\n", seconds > 0 ? nb_pixels / seconds / 1e6 : 0);
+    fprintf(fp, "  \"cpu_us_per_frame\": %.1f,\n", nb_frames ? (double)cpu_us / nb_frames : 0);
+    fprintf(fp, "  \"latency_us\": ");
+    write_latency(fp, latency, "  ");
+    fprintf(fp, ",\n");
+
+    fprintf(fp, "  \"decoders\": [\n");
+    for (i = 0; i < bench->nb_instances; i++) {
+        instance_t *inst = &bench->instances[i];
+        double inst_seconds = inst->elapsed_us / 1000000.0;
+
+        fprintf(fp, "    {\n");
+        fprintf(fp, "      \"id\": %d,\n", inst->id);
+        fprintf(fp, "      \"file\": ");
+        write_string(fp, inst->file->path);
+        fprintf(fp, ",\n");
+        fprintf(fp, "      \"decoder\": \"%s\",\n", inst->failed ? "" : inst->decoder);
+        fprintf(fp, "      \"failed\": %s,\n", inst->failed ? "true" : "false");
+        fprintf(fp, "      \"loops\": %d,\n", inst->loops);
+        fprintf(fp, "      \"frames\": %llu,\n", (unsigned long long)inst->nb_frames);
+        fprintf(fp, "      \"fps\": %.1f,\n", inst_seconds > 0 ? inst->nb_frames / inst_seconds : 0);
+        fprintf(fp, "      \"errors\": %llu,\n", (unsigned long long)inst->nb_errors);
+        fprintf(fp, "      \"unmatched_frames\": %llu,\n", (unsigned long long)inst->nb_unmatched);
+        fprintf(fp, "      \"latency_us\": ");
+        write_latency(fp, inst->latency, "      ");
+        fprintf(fp, "\n    }%s\n", i + 1 < bench->nb_instances ? "," : "");
+    }
+    fprintf(fp, "  ]\n");
+    fprintf(fp, "}\n");
+
+    fclose(fp);
+
+    printf("%llu frames in %.2fs: %.1f fps, %.1f MPix/s, %.1f us cpu/frame, "
+           "latency p50 %lldus p99 %lldus p999 %lldus -> %s\n",
+            (unsigned long long)nb_frames, seconds,
+            seconds > 0 ? nb_frames / seconds : 0,
+            seconds > 0 ? nb_pixels / seconds / 1e6 : 0,
+            nb_frames ? (double)cpu_us / nb_frames : 0,
+            (long long)hdr_hist_percentile(latency, 50),
+            (long long)hdr_hist_percentile(latency, 99),
+            (long long)hdr_hist_percentile(latency, 99.9),
+            path);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int option;
+    int ret = 0;
+    int i;
+    int threads_set = 0;
+    char *json_path = "dec_bench.json";
+    int64_t elapsed_us, cpu_us;
+    hdr_hist_t *latency = NULL;
+
+    bench_t *bench = NULL;
+
+    bench = (bench_t *)malloc(sizeof(bench_t));
+    if (bench == NULL) {
+        printf("failed to  malloc bench_t\n");
+        return -1;
+    }
+
+    memset(bench, 0, sizeof(bench_t));
+    bench->nb_instances = 1;
+    bench->loops        = 1;
+
+    /* Process options with getopt */
+    while ((option = getopt(argc, argv,"i:j:l:d:b:H:n:x:o:h")) != -1) {
+        switch (option) {
+            case 'i':
+                if (bench->nb_files == MAX_FILES) {
+                    printf("too many files, the max is %d\n", MAX_FILES);
+                    return -1;
+                }
+                bench->files[bench->nb_files++].path = optarg;
+                break;
+
+            case 'j':
+                bench->nb_instances = atoi(optarg);
+                break;
+
+            case 'l':
+                bench->loops = atoi(optarg);
+                break;
+
+            case 'd':
+                bench->duration = atoi(optarg);
+                break;
+
+            case 'b':
+                bench->backend.backend = dec_backend_from_name(optarg);
+                break;
+
+            case 'H':
+                bench->backend.max_hw = atoi(optarg);
+                break;
+
+            case 'n':
+                bench->backend.thread_count = atoi(optarg);
+                threads_set = 1;
+                break;
+
+            case 'x':
+                bench->backend.thread_type = dec_backend_thread_type_from_name(optarg);
+                break;
+
+            case 'o':
+                json_path = optarg;
+                break;
+
+            case 'h':
+            default:
+                usage(argv[0]);
+                exit(0);
+                break;
+        }
+    }
+
+    if (!bench->nb_files || bench->nb_instances <= 0 || bench->nb_instances > MAX_INSTANCES ||
+        bench->loops <= 0 || bench->duration < 0 ||
+        bench->backend.backend == DEC_BACKEND_MAX || bench->backend.max_hw < 0 ||
+        bench->backend.thread_count < 0 || bench->backend.thread_type < 0) {
+        usage(argv[0]);
+        exit(0);
+    }
+
+    /*concurrent decoders with a set of frame threads each oversubscribe the cores*/
+    if (!threads_set) {
+        bench->backend.thread_count = bench->nb_instances > 1 ? 1 : 0;
+    }
+    printf("%d decoder instances, %d threads per software decoder\n", bench->nb_instances,
+            bench->backend.thread_count ? bench->backend.thread_count :
+                                          (int)sysconf(_SC_NPROCESSORS_ONLN));
+
+    for (i = 0; i < bench->nb_files; i++) {
+        if (load_file(&bench->files[i])) {
+            return -1;
+        }
+    }
+
+    latency = hdr_hist_alloc(LATENCY_MAX_US);
+    if (!latency) {
+        return -1;
+    }
+
+    for (i = 0; i < bench->nb_instances; i++) {
+        instance_t *inst = &bench->instances[i];
+
+        inst->id         = i;
+        inst->bench      = bench;
+        inst->file       = &bench->files[i % bench->nb_files];
+        inst->latency    = hdr_hist_alloc(LATENCY_MAX_US);
+        inst->frame_pool = frame_pool_alloc(FRAME_POOL_FRAMES, FRAME_POOL_BUFFERS);
+        inst->send_us    = (int64_t *)calloc(inst->file->nb_pkts, sizeof(int64_t));
+        if (!inst->latency || !inst->frame_pool || !inst->send_us) {
+            printf("failed to allocate decoder instance %d\n", i);
+            return -1;
+        }
+    }
+
+    pthread_barrier_init(&bench->start, NULL, bench->nb_instances + 1);
+
+    for (i = 0; i < bench->nb_instances; i++) {
+        ret = pthread_create(&bench->instances[i].thread, NULL, instanceThreadEntry,
+                             (void *)&bench->instances[i]);
+        if (ret != 0) {
+            printf("Failed to create decoder thread %d(res=%d, error=%s)\n",
+                    i, ret, strerror(ret));
+            return -1;
+        }
+    }
+
+    pthread_barrier_wait(&bench->start);
+    bench->start_us = get_time_us();
+    cpu_us = get_cpu_time_us();
+
+    for (i = 0; i < bench->nb_instances; i++) {
+        pthread_join(bench->instances[i].thread, NULL);
+    }
+
+    elapsed_us = get_time_us() - bench->start_us;
+    cpu_us = get_cpu_time_us() - cpu_us;
+
+    for (i = 0; i < bench->nb_instances; i++) {
+        instance_t *inst = &bench->instances[i];
+
+        if (inst->failed) {
+            printf("decoder instance %d failed to open\n", i);
+            ret = -1;
+        }
+        hdr_hist_merge(latency, inst->latency);
+    }
+
+    if (write_results(bench, json_path, elapsed_us, cpu_us, latency)) {
+        ret = -1;
+    }
+
+    for (i = 0; i < bench->nb_instances; i++) {
+        instance_t *inst = &bench->instances[i];
+
+        if (inst->avctx) {
+            dec_backend_close(&inst->avctx);
+        }
+        frame_pool_free(&inst->frame_pool);
+        hdr_hist_free(&inst->latency);
+        free(inst->send_us);
+    }
+
+    for (i = 0; i < bench->nb_files; i++) {
+        free_file(&bench->files[i]);
+    }
+
+    hdr_hist_free(&latency);
+    pthread_barrier_destroy(&bench->start);
+    free(bench);
+
+    return ret;
+}
@@ -0,0 +1,441 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: dec_ctx_pool.c
+*
+* PURPOSE: pre-opened decoder contexts, opened by a pool thread and taken
+*          by the streams
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Software decoders only, they take the extradata of a packet
+************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <libavutil/time.h>
+
+#include "dec_ctx_pool.h"
+
+#define MAX_CLASSES      8
+#define MAX_WARM         16     /*contexts of one class*/
+#define OPEN_RETRY_US    5000000
+#define POOL_LOG_ID      -1     /*the contexts do not belong to a stream yet*/
+
+/*streams up to the size are in the class, portrait ones are turned*/
+static const struct {
+    const char *name;
+    int        width;
+    int        height;
+} res_classes[] = {
+    { "sd",  720,  576  },
+    { "hd",  1920, 1088 },
+    { "4k",  4096, 2304 },
+    { "8k",  8192, 4352 },
+};
+
+#define NB_RES_CLASSES (int)(sizeof(res_classes) / sizeof(res_classes[0]))
+
+typedef struct ctx_class_t {
+    enum AVCodecID  codec_id;
+    int             res;            /*in res_classes[]*/
+    int             width;          /*of the warm contexts*/
+    int             height;
+    int             target;         /*kept warm*/
+    AVCodecContext  *warm[MAX_WARM];
+    int             nb_warm;
+    int             nb_opening;     /*by the pool thread now*/
+    int64_t         retry_us;       /*after a failed open*/
+} ctx_class_t;
+
+/*
+The pool thread opens the contexts until every class has its target,
+the streams take them and give them back under the lock. Opening and
+closing a decoder is slow, it is done out of the lock.
+*/
+struct dec_ctx_pool_t {
+    dec_backend_config_t cfg;
+    ctx_class_t     classes[MAX_CLASSES];
+    int             nb_classes;
+
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    int             quit;
+
+    uint64_t        nb_opened;
+    uint64_t        nb_hits;
+    uint64_t        nb_misses;
+    uint64_t        nb_returned;
+    uint64_t        nb_errors;
+};
+
+/*return -1 if the size is unknown or too big*/
+static int res_class(int width, int height) {
+    int tmp;
+    int i;
+
+    if (width <= 0 || height <= 0) {
+        return -1;
+    }
+
+    if (width < height) {
+        tmp    = width;
+        width  = height;
+        height = tmp;
+    }
+
+    for (i = 0; i < NB_RES_CLASSES; i++) {
+        if (width <= res_classes[i].width && height <= res_classes[i].height) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static ctx_class_t *find_class(dec_ctx_pool_t *pool, enum AVCodecID codec_id, int res) {
+    int i;
+
+    for (i = 0; i < pool->nb_classes; i++) {
+        if (pool->classes[i].codec_id == codec_id && pool->classes[i].res == res) {
+            return &pool->classes[i];
+        }
+    }
+
+    return NULL;
+}
+
+static AVCodecContext *open_warm(dec_ctx_pool_t *pool, const ctx_class_t *c) {
+    AVCodecParameters *par;
+    AVCodecContext *avctx;
+
+    par = avcodec_parameters_alloc();
+    if (!par) {
+        return NULL;
+    }
+
+    par->codec_type = AVMEDIA_TYPE_VIDEO;
+    par->codec_id   = c->codec_id;
+    par->width      = c->width;
+    par->height     = c->height;
+
+    avctx = dec_backend_open(&pool->cfg, par, NULL, POOL_LOG_ID);
+    avcodec_parameters_free(&par);
+
+    return avctx;
+}
+
+/*the class which is the most short of its target*/
+static ctx_class_t *next_to_open(dec_ctx_pool_t *pool, int64_t now_us) {
+    ctx_class_t *pick = NULL;
+    ctx_class_t *c;
+    int i;
+
+    for (i = 0; i < pool->nb_classes; i++) {
+        c = &pool->classes[i];
+        if (c->nb_warm + c->nb_opening >= c->target || c->retry_us > now_us) {
+            continue;
+        }
+
+        if (!pick || c->nb_warm + c->nb_opening < pick->nb_warm + pick->nb_opening) {
+            pick = c;
+        }
+    }
+
+    return pick;
+}
+
+static void *poolThreadEntry(void *priv) {
+    dec_ctx_pool_t *pool = (dec_ctx_pool_t *)priv;
+    AVCodecContext *avctx;
+    ctx_class_t *c;
+    struct timespec ts;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (!pool->quit) {
+        c = next_to_open(pool, av_gettime_relative());
+        if (!c) {
+            /*a failed class is tried again later*/
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += 1;
+            pthread_cond_timedwait(&pool->cond, &pool->lock, &ts);
+            continue;
+        }
+
+        c->nb_opening++;
+        pthread_mutex_unlock(&pool->lock);
+
+        avctx = open_warm(pool, c);
+
+        pthread_mutex_lock(&pool->lock);
+        c->nb_opening--;
+        if (avctx) {
+            c->warm[c->nb_warm++] = avctx;
+            pool->nb_opened++;
+        } else {
+            printf("failed to open a warm %s decoder(%s), try again in %d seconds\n",
+                    avcodec_get_name(c->codec_id), res_classes[c->res].name,
+                    OPEN_RETRY_US / 1000000);
+            c->retry_us = av_gettime_relative() + OPEN_RETRY_US;
+            pool->nb_errors++;
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+dec_ctx_pool_t *dec_ctx_pool_create(const dec_backend_config_t *cfg) {
+    dec_ctx_pool_t *pool;
+    int ret;
+
+    /*the hardware decoders, e.g. nvv4l2, ignore the extradata of the packets*/
+    if (cfg->backend != DEC_BACKEND_SW) {
+        printf("the decoder pool keeps software decoders only, it needs the sw backend\n");
+        return NULL;
+    }
+
+    pool = (dec_ctx_pool_t *)calloc(1, sizeof(dec_ctx_pool_t));
+    if (!pool) {
+        printf("failed to malloc dec_ctx_pool_t\n");
+        return NULL;
+    }
+
+    pool->cfg = *cfg;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+
+    ret = pthread_create(&pool->thread, NULL, poolThreadEntry, (void *)pool);
+    if (ret != 0) {
+        printf("Failed to create decoder pool thread(res=%d, error=%s)\n",
+                ret, strerror(ret));
+        pthread_cond_destroy(&pool->cond);
+        pthread_mutex_destroy(&pool->lock);
+        free(pool);
+        return NULL;
+    }
+    pthread_setname_np(pool->thread, "dec_ctx_pool");
+
+    return pool;
+}
+
+void dec_ctx_pool_destroy(dec_ctx_pool_t **pool) {
+    dec_ctx_pool_t *p = *pool;
+    int i;
+    int j;
+
+    if (!p) {
+        return;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    p->quit = 1;
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+
+    pthread_join(p->thread, NULL);
+
+    for (i = 0; i < p->nb_classes; i++) {
+        for (j = 0; j < p->classes[i].nb_warm; j++) {
+            dec_backend_close(&p->classes[i].warm[j]);
+        }
+    }
+
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+    free(p);
+    *pool = NULL;
+}
+
+int dec_ctx_pool_add(dec_ctx_pool_t *pool, const char *spec) {
+    enum AVCodecID codec_id;
+    ctx_class_t *c;
+    char codec[16];
+    int width, height, count;
+    int res;
+
+    if (sscanf(spec, "%15[^:]:%dx%d:%d", codec, &width, &height, &count) != 4) {
+        printf("invalid decoder pool '%s', <h264/hevc>:<width>x<height>:<count>\n", spec);
+        return -1;
+    }
+
+    if (!strcmp(codec, "h264")) {
+        codec_id = AV_CODEC_ID_H264;
+    } else if (!strcmp(codec, "hevc") || !strcmp(codec, "h265")) {
+        codec_id = AV_CODEC_ID_HEVC;
+    } else {
+        printf("no decoder pool for '%s', only h264 and hevc\n", codec);
+        return -1;
+    }
+
+    res = res_class(width, height);
+    if (res < 0 || count <= 0 || count > MAX_WARM) {
+        printf("invalid decoder pool '%s': up to %dx%d, 1 - %d contexts\n", spec,
+                res_classes[NB_RES_CLASSES - 1].width, res_classes[NB_RES_CLASSES - 1].height,
+                MAX_WARM);
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    c = find_class(pool, codec_id, res);
+    if (!c) {
+        if (pool->nb_classes == MAX_CLASSES) {
+            pthread_mutex_unlock(&pool->lock);
+            printf("too many decoder pools, the max is %d\n", MAX_CLASSES);
+            return -1;
+        }
+        c = &pool->classes[pool->nb_classes++];
+        c->codec_id = codec_id;
+        c->res      = res;
+    }
+    c->width  = width;
+    c->height = height;
+    c->target = count;
+    pthread_cond_signal(&pool->cond);
+
+    pthread_mutex_unlock(&pool->lock);
+
+    printf("decoder pool: %d %s contexts for the %s streams\n",
+            count, avcodec_get_name(codec_id), res_classes[res].name);
+
+    return 0;
+}
+
+AVCodecContext *dec_ctx_pool_get(dec_ctx_pool_t *pool, const AVCodecParameters *par,
+                                 frame_pool_t *frame_pool, int id) {
+    AVCodecContext *avctx = NULL;
+    ctx_class_t *c;
+    int res = res_class(par->width, par->height);
+
+    pthread_mutex_lock(&pool->lock);
+    c = find_class(pool, par->codec_id, res);
+    if (c && c->nb_warm > 0) {
+        avctx = c->warm[--c->nb_warm];
+        pool->nb_hits++;
+        /*open the next one*/
+        pthread_cond_signal(&pool->cond);
+    } else if (c) {
+        pool->nb_misses++;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (!avctx) {
+        return NULL;
+    }
+
+    /*the decoder takes it with the first packet*/
+    av_freep(&avctx->extradata);
+    avctx->extradata_size = 0;
+    if (par->extradata_size > 0) {
+        avctx->extradata = av_mallocz(par->extradata_size + AV_INPUT_BUFFER_PADDING_SIZE);
+        if (!avctx->extradata) {
+            printf("[%d] failed to malloc the extradata\n", id);
+            dec_backend_close(&avctx);
+            return NULL;
+        }
+        memcpy(avctx->extradata, par->extradata, par->extradata_size);
+        avctx->extradata_size = par->extradata_size;
+    }
+
+    if (frame_pool && frame_pool_attach(frame_pool, avctx, par) < 0) {
+        printf("[%d] %s allocates its own pictures, they are not pooled\n",
+                id, avctx->codec->name);
+    }
+
+    printf("[%d] take a warm %s decoder(%s)\n", id, avctx->codec->name, res_classes[res].name);
+
+    return avctx;
+}
+
+int dec_ctx_pool_prime(AVCodecContext *avctx, AVPacket *pkt) {
+    uint8_t *side;
+
+    if (!avctx->extradata_size) {
+        return 0;
+    }
+
+    side = av_packet_new_side_data(pkt, AV_PKT_DATA_NEW_EXTRADATA, avctx->extradata_size);
+    if (!side) {
+        return AVERROR(ENOMEM);
+    }
+    memcpy(side, avctx->extradata, avctx->extradata_size);
+
+    return 0;
+}
+
+void dec_ctx_pool_put(dec_ctx_pool_t *pool, AVCodecContext **avctx) {
+    AVCodecContext *ctx = *avctx;
+    ctx_class_t *c;
+
+    if (!ctx) {
+        return;
+    }
+    *avctx = NULL;
+
+    /*the pictures of the next stream come from its own pool*/
+    avcodec_flush_buffers(ctx);
+    ctx->skip_frame  = AVDISCARD_DEFAULT;
+    ctx->opaque      = NULL;
+    ctx->get_buffer2 = avcodec_default_get_buffer2;
+
+    pthread_mutex_lock(&pool->lock);
+    c = find_class(pool, ctx->codec_id, res_class(ctx->width, ctx->height));
+    if (c && c->nb_warm + c->nb_opening < c->target && !dec_backend_is_hw(ctx)) {
+        c->warm[c->nb_warm++] = ctx;
+        pool->nb_returned++;
+        ctx = NULL;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    dec_backend_close(&ctx);
+}
+
+void dec_ctx_pool_get_stats(dec_ctx_pool_t *pool, dec_ctx_pool_stats_t *stats) {
+    int i;
+
+    memset(stats, 0, sizeof(dec_ctx_pool_stats_t));
+
+    pthread_mutex_lock(&pool->lock);
+
+    for (i = 0; i < pool->nb_classes; i++) {
+        stats->nb_warm   += pool->classes[i].nb_warm;
+        stats->nb_target += pool->classes[i].target;
+    }
+    stats->nb_opened   = pool->nb_opened;
+    stats->nb_hits     = pool->nb_hits;
+    stats->nb_misses   = pool->nb_misses;
+    stats->nb_returned = pool->nb_returned;
+    stats->nb_errors   = pool->nb_errors;
+
+    pthread_mutex_unlock(&pool->lock);
+}
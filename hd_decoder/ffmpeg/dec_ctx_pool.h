@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: dec_ctx_pool.h
+*
+* PURPOSE: pool of pre-opened H.264/HEVC decoder contexts by codec and
+*          resolution class, a new stream takes a warm one instead of
+*          opening a decoder
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Software decoders only, they take the extradata of a packet
+************************************************************************/
+
+#ifndef __DEC_CTX_POOL_H_
+#define __DEC_CTX_POOL_H_
+
+#include <stdint.h>
+
+#include <libavcodec/avcodec.h>
+
+#include "dec_backend.h"
+#include "frame_pool.h"
+
+typedef struct dec_ctx_pool_stats_t {
+    int      nb_warm;           /*opened and not taken*/
+    int      nb_target;         /*kept warm by all the classes*/
+    uint64_t nb_opened;         /*by the pool thread*/
+    uint64_t nb_hits;           /*a stream took a warm context*/
+    uint64_t nb_misses;         /*a stream of a class had to open its own*/
+    uint64_t nb_returned;       /*kept warm after a stream closed it*/
+    uint64_t nb_errors;
+} dec_ctx_pool_stats_t;
+
+typedef struct dec_ctx_pool_t dec_ctx_pool_t;
+
+/*
+* The contexts are opened by the pool thread with the backend config.
+* They are opened before the extradata of a stream is known, it is given
+* to them as AV_PKT_DATA_NEW_EXTRADATA, which only the native libavcodec
+* decoders take: the pool needs the software backend
+*   return NULL on failure or for another backend
+*/
+dec_ctx_pool_t *dec_ctx_pool_create(const dec_backend_config_t *cfg);
+
+/*
+* Close the warm contexts, the taken ones are closed by dec_ctx_pool_put()
+* before it
+*/
+void dec_ctx_pool_destroy(dec_ctx_pool_t **pool);
+
+/*
+* Keep count contexts of the codec warm for the streams of the resolution
+* class of width x height
+*   spec: "<h264/hevc>:<width>x<height>:<count>"
+*   return 0 on success, -1 if the spec is invalid or the classes are full
+*/
+int dec_ctx_pool_add(dec_ctx_pool_t *pool, const char *spec);
+
+/*
+* Take a warm context of the class of the stream, the picture pool is
+* attached and the extradata of the stream is kept in avctx->extradata
+* for dec_ctx_pool_prime()
+*   return NULL if there is none, open a decoder then
+*/
+AVCodecContext *dec_ctx_pool_get(dec_ctx_pool_t *pool, const AVCodecParameters *par,
+                                 frame_pool_t *frame_pool, int id);
+
+/*
+* The first packet sent to a context from dec_ctx_pool_get() takes the
+* extradata of the stream as AV_PKT_DATA_NEW_EXTRADATA
+*   return 0 on success, AVERROR(ENOMEM)
+*/
+int dec_ctx_pool_prime(AVCodecContext *avctx, AVPacket *pkt);
+
+/*
+* Flush the context and keep it warm if its class has room, otherwise
+* close it, *avctx is set to NULL. Any context of dec_backend_open() may
+* be given back, a hardware one is closed
+*/
+void dec_ctx_pool_put(dec_ctx_pool_t *pool, AVCodecContext **avctx);
+
+/*
+* Safe from any thread
+*/
+void dec_ctx_pool_get_stats(dec_ctx_pool_t *pool, dec_ctx_pool_stats_t *stats);
+
+#endif /* __DEC_CTX_POOL_H_ */
@@ -0,0 +1,431 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: event_recorder.c
+*
+* PURPOSE: pre-event ring of the compressed video packets and stream copy
+*          of them into clip files
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   The clips are muxed by the clip writer out of the demux job
+************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#include "event_recorder.h"
+
+#define RING_MIN_PACKETS 256
+#define CLIP_PATH_SIZE   1024
+
+/*
+The packets are only touched by the demux job of the stream, the stats
+are atomic for the reporter. The ring holds references of the packets,
+the payload is shared with the decoder and the clip writer, which muxes
+the files on its I/O thread.
+*/
+struct event_recorder_t {
+    event_recorder_config_t cfg;
+    int               id;
+
+    AVCodecParameters *par;
+    AVRational        time_base;
+    int64_t           pre_ts;       /*pre_us in time_base*/
+
+    /*ring of the packets, the first one is a keyframe*/
+    AVPacket          *ring;
+    int               size;
+    int               head;
+    int               count;
+    int64_t           bytes;
+
+    /*event in progress*/
+    int64_t           end_us;       /*0: no event*/
+    clip_t            *clip;        /*NULL: waiting for a keyframe*/
+    int64_t           segment_start_us;
+    clip_counters_t   clips;
+
+    atomic_int        stat_ring_packets;
+    atomic_llong      stat_ring_bytes;
+    atomic_llong      stat_ring_us;
+    atomic_int        stat_recording;
+    atomic_ullong     nb_events;
+    atomic_ullong     nb_segments;
+};
+
+static int64_t packet_ts(const AVPacket *pkt) {
+    return pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+}
+
+static AVPacket *ring_at(event_recorder_t *rec, int i) {
+    return &rec->ring[(rec->head + i) % rec->size];
+}
+
+static int ring_grow(event_recorder_t *rec) {
+    int size = rec->size ? rec->size * 2 : RING_MIN_PACKETS;
+    AVPacket *ring;
+    int i;
+
+    ring = (AVPacket *)malloc(size * sizeof(AVPacket));
+    if (!ring) {
+        printf("[%d] failed to malloc the event ring of %d packets\n", rec->id, size);
+        return -1;
+    }
+
+    /*the references move with the structs*/
+    for (i = 0; i < rec->count; i++) {
+        ring[i] = *ring_at(rec, i);
+    }
+
+    free(rec->ring);
+    rec->ring = ring;
+    rec->size = size;
+    rec->head = 0;
+
+    return 0;
+}
+
+static void ring_pop(event_recorder_t *rec) {
+    AVPacket *pkt = ring_at(rec, 0);
+
+    rec->bytes -= pkt->size;
+    av_packet_unref(pkt);
+    rec->head = (rec->head + 1) % rec->size;
+    rec->count--;
+}
+
+static void ring_clear(event_recorder_t *rec) {
+    while (rec->count) {
+        ring_pop(rec);
+    }
+}
+
+/*index of the first keyframe after the head, 0 if there is none*/
+static int ring_next_key(event_recorder_t *rec) {
+    int i;
+
+    for (i = 1; i < rec->count; i++) {
+        if (ring_at(rec, i)->flags & AV_PKT_FLAG_KEY) {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+/*
+* Drop the oldest GOPs while the next GOPs still cover pre_us, or while
+* the ring is over max_bytes. A GOP bigger than max_bytes empties it
+* until the next keyframe.
+*/
+static void ring_trim(event_recorder_t *rec) {
+    int64_t last_ts = packet_ts(ring_at(rec, rec->count - 1));
+    int64_t key_ts;
+    int next;
+
+    while (rec->count) {
+        next = ring_next_key(rec);
+
+        if (rec->bytes > rec->cfg.max_bytes) {
+            next = next ? next : rec->count;
+        } else if (next) {
+            key_ts = packet_ts(ring_at(rec, next));
+            if (key_ts == AV_NOPTS_VALUE || last_ts == AV_NOPTS_VALUE ||
+                last_ts - key_ts < rec->pre_ts) {
+                break;
+            }
+        } else {
+            break;
+        }
+
+        while (next--) {
+            ring_pop(rec);
+        }
+    }
+}
+
+static void ring_push(event_recorder_t *rec, const AVPacket *pkt) {
+    AVPacket *slot;
+    int64_t first_ts, last_ts;
+
+    /*the ring starts at a keyframe*/
+    if (!rec->count && !(pkt->flags & AV_PKT_FLAG_KEY)) {
+        return;
+    }
+
+    if (rec->count == rec->size && ring_grow(rec)) {
+        return;
+    }
+
+    slot = &rec->ring[(rec->head + rec->count) % rec->size];
+    av_init_packet(slot);
+    if (av_packet_ref(slot, pkt) < 0) {
+        printf("[%d] failed to reference the packet in the event ring\n", rec->id);
+        return;
+    }
+
+    rec->count++;
+    rec->bytes += pkt->size;
+
+    ring_trim(rec);
+
+    atomic_store_explicit(&rec->stat_ring_packets, rec->count, memory_order_relaxed);
+    atomic_store_explicit(&rec->stat_ring_bytes, rec->bytes, memory_order_relaxed);
+
+    if (rec->count) {
+        first_ts = packet_ts(ring_at(rec, 0));
+        last_ts  = packet_ts(ring_at(rec, rec->count - 1));
+        if (first_ts != AV_NOPTS_VALUE && last_ts != AV_NOPTS_VALUE) {
+            atomic_store_explicit(&rec->stat_ring_us,
+                                  av_rescale_q(last_ts - first_ts, rec->time_base, AV_TIME_BASE_Q),
+                                  memory_order_relaxed);
+        }
+    } else {
+        atomic_store_explicit(&rec->stat_ring_us, 0, memory_order_relaxed);
+    }
+}
+
+/*
+"clips/cam.mp4" of the stream 2 is recorded into
+clips/cam_2_20261018-153000_1.mp4, clips/cam_2_20261018-153100_2.mp4 ...
+*/
+static void make_clip_path(event_recorder_t *rec, char *path, int size) {
+    const char *pattern = rec->cfg.path;
+    const char *ext = strrchr(pattern, '.');
+    char stamp[32];
+    struct tm tm;
+    time_t now = time(NULL);
+
+    localtime_r(&now, &tm);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+
+    if (!ext || strchr(ext, '/')) {
+        ext = pattern + strlen(pattern);
+    }
+
+    snprintf(path, size, "%.*s_%d_%s_%llu%s", (int)(ext - pattern), pattern, rec->id, stamp,
+             (unsigned long long)atomic_load_explicit(&rec->nb_segments, memory_order_relaxed) + 1,
+             ext);
+}
+
+static void close_segment(event_recorder_t *rec) {
+    if (!rec->clip) {
+        return;
+    }
+
+    clip_writer_close(rec->cfg.writer, rec->clip);
+    rec->clip = NULL;
+}
+
+/*the event is over or the file failed*/
+static void stop_recording(event_recorder_t *rec) {
+    close_segment(rec);
+    rec->end_us = 0;
+    atomic_store_explicit(&rec->stat_recording, 0, memory_order_relaxed);
+}
+
+static int open_segment(event_recorder_t *rec, int64_t now_us) {
+    char path[CLIP_PATH_SIZE];
+
+    make_clip_path(rec, path, sizeof(path));
+
+    rec->clip = clip_writer_open(rec->cfg.writer, path, rec->par, rec->time_base,
+                                 &rec->clips, rec->id);
+    if (!rec->clip) {
+        return -1;
+    }
+
+    rec->segment_start_us = now_us;
+    atomic_fetch_add_explicit(&rec->nb_segments, 1, memory_order_relaxed);
+
+    printf("[%d] record the event into %s\n", rec->id, path);
+
+    return 0;
+}
+
+/*
+* Open a file with the packets kept before the event
+*/
+static void start_segment(event_recorder_t *rec, int64_t now_us) {
+    int ret = 0;
+    int i;
+
+    if (open_segment(rec, now_us)) {
+        atomic_fetch_add_explicit(&rec->clips.nb_errors, 1, memory_order_relaxed);
+        stop_recording(rec);
+        return;
+    }
+
+    /*the kept packets count in the length of the file*/
+    rec->segment_start_us -= atomic_load_explicit(&rec->stat_ring_us, memory_order_relaxed);
+
+    for (i = 0; i < rec->count && ret >= 0; i++) {
+        ret = clip_writer_write(rec->cfg.writer, rec->clip, ring_at(rec, i));
+    }
+
+    if (ret < 0) {
+        stop_recording(rec);
+    }
+}
+
+event_recorder_t *event_recorder_alloc(const event_recorder_config_t *cfg, int id) {
+    event_recorder_t *rec;
+
+    if (!cfg->path || !cfg->writer || cfg->pre_us < 0 || cfg->post_us <= 0 ||
+        cfg->segment_us < 0 || cfg->max_bytes <= 0) {
+        printf("invalid config of the event recorder\n");
+        return NULL;
+    }
+
+    rec = (event_recorder_t *)malloc(sizeof(event_recorder_t));
+    if (rec == NULL) {
+        printf("failed to malloc event_recorder_t\n");
+        return NULL;
+    }
+
+    memset(rec, 0, sizeof(event_recorder_t));
+    rec->cfg       = *cfg;
+    rec->id        = id;
+    rec->time_base = AV_TIME_BASE_Q;
+    atomic_init(&rec->stat_ring_packets, 0);
+    atomic_init(&rec->stat_ring_bytes, 0);
+    atomic_init(&rec->stat_ring_us, 0);
+    atomic_init(&rec->stat_recording, 0);
+    atomic_init(&rec->nb_events, 0);
+    atomic_init(&rec->nb_segments, 0);
+    atomic_init(&rec->clips.nb_packets, 0);
+    atomic_init(&rec->clips.nb_bytes, 0);
+    atomic_init(&rec->clips.nb_errors, 0);
+
+    rec->par = avcodec_parameters_alloc();
+    if (!rec->par || ring_grow(rec)) {
+        event_recorder_free(&rec);
+        return NULL;
+    }
+
+    return rec;
+}
+
+void event_recorder_free(event_recorder_t **rec) {
+    event_recorder_t *r = *rec;
+
+    if (!r) {
+        return;
+    }
+
+    /*the clip writer counts the packets of the clips until they are written*/
+    close_segment(r);
+    clip_writer_flush(r->cfg.writer);
+    ring_clear(r);
+    free(r->ring);
+    avcodec_parameters_free(&r->par);
+    free(r);
+
+    *rec = NULL;
+}
+
+int event_recorder_set_stream(event_recorder_t *rec, const AVCodecParameters *par,
+                              AVRational time_base) {
+    close_segment(rec);
+    ring_clear(rec);
+
+    rec->time_base = time_base;
+    rec->pre_ts    = av_rescale_q(rec->cfg.pre_us, AV_TIME_BASE_Q, time_base);
+
+    if (avcodec_parameters_copy(rec->par, par) < 0) {
+        printf("[%d] failed to copy the codec parameters of the event recorder\n", rec->id);
+        stop_recording(rec);
+        return -1;
+    }
+
+    return 0;
+}
+
+void event_recorder_trigger(event_recorder_t *rec, int64_t now_us) {
+    atomic_fetch_add_explicit(&rec->nb_events, 1, memory_order_relaxed);
+
+    if (rec->end_us) {
+        printf("[%d] event, record %lld s longer\n",
+                rec->id, (long long)rec->cfg.post_us / 1000000);
+        rec->end_us = now_us + rec->cfg.post_us;
+        return;
+    }
+
+    rec->end_us = now_us + rec->cfg.post_us;
+    atomic_store_explicit(&rec->stat_recording, 1, memory_order_relaxed);
+
+    /*without a kept keyframe, the file starts at the next one*/
+    if (rec->count) {
+        start_segment(rec, now_us);
+    }
+}
+
+void event_recorder_add_packet(event_recorder_t *rec, const AVPacket *pkt, int64_t now_us) {
+    ring_push(rec, pkt);
+
+    if (!rec->end_us) {
+        return;
+    }
+
+    if (now_us >= rec->end_us) {
+        stop_recording(rec);
+        return;
+    }
+
+    if (rec->clip && rec->cfg.segment_us && (pkt->flags & AV_PKT_FLAG_KEY) &&
+        now_us - rec->segment_start_us >= rec->cfg.segment_us) {
+        close_segment(rec);
+    }
+
+    if (!rec->clip) {
+        if (!(pkt->flags & AV_PKT_FLAG_KEY)) {
+            return;
+        }
+
+        if (open_segment(rec, now_us)) {
+            atomic_fetch_add_explicit(&rec->clips.nb_errors, 1, memory_order_relaxed);
+            stop_recording(rec);
+            return;
+        }
+    }
+
+    /*the clip failed on the I/O thread or the disk is too slow*/
+    if (clip_writer_write(rec->cfg.writer, rec->clip, pkt) < 0) {
+        stop_recording(rec);
+    }
+}
+
+void event_recorder_get_stats(event_recorder_t *rec, event_recorder_stats_t *stats) {
+    stats->ring_packets = atomic_load_explicit(&rec->stat_ring_packets, memory_order_relaxed);
+    stats->ring_bytes   = atomic_load_explicit(&rec->stat_ring_bytes, memory_order_relaxed);
+    stats->ring_us      = atomic_load_explicit(&rec->stat_ring_us, memory_order_relaxed);
+    stats->recording    = atomic_load_explicit(&rec->stat_recording, memory_order_relaxed);
+    stats->nb_events    = atomic_load_explicit(&rec->nb_events, memory_order_relaxed);
+    stats->nb_segments  = atomic_load_explicit(&rec->nb_segments, memory_order_relaxed);
+    stats->nb_packets   = atomic_load_explicit(&rec->clips.nb_packets, memory_order_relaxed);
+    stats->nb_bytes     = atomic_load_explicit(&rec->clips.nb_bytes, memory_order_relaxed);
+    stats->nb_errors    = atomic_load_explicit(&rec->clips.nb_errors, memory_order_relaxed);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: event_recorder.h
+*
+* PURPOSE: keep the last seconds of the compressed video packets, and
+*          record them with the live packets into clip files on an event,
+*          by stream copy without decoding
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   The clips are muxed by the clip writer out of the demux job
+************************************************************************/
+
+#ifndef __EVENT_RECORDER_H_
+#define __EVENT_RECORDER_H_
+
+#include <stdint.h>
+
+#include <libavformat/avformat.h>
+
+#include "clip_writer.h"
+
+typedef struct event_recorder_config_t {
+    const char *path;       /*clip file, the extension picks the container: .mp4, .mkv ...,
+                              the stream index, the time and a number are inserted before it*/
+    int64_t    pre_us;      /*kept before the event*/
+    int64_t    post_us;     /*recorded after the last event*/
+    int64_t    segment_us;  /*start a new file at the first keyframe after it, 0: no limit*/
+    int64_t    max_bytes;   /*memory of the packets kept before the event*/
+    clip_writer_t *writer;  /*muxes the clips, shared by the recorders*/
+} event_recorder_config_t;
+
+typedef struct event_recorder_stats_t {
+    int      ring_packets;      /*kept before the event*/
+    int64_t  ring_bytes;
+    int64_t  ring_us;
+    int      recording;
+    uint64_t nb_events;
+    uint64_t nb_segments;       /*files opened*/
+    uint64_t nb_packets;        /*written into the files*/
+    uint64_t nb_bytes;
+    uint64_t nb_errors;
+} event_recorder_stats_t;
+
+typedef struct event_recorder_t event_recorder_t;
+
+/*
+*   id: stream index, for the file name and the log
+*/
+event_recorder_t *event_recorder_alloc(const event_recorder_config_t *cfg, int id);
+
+/*
+* Finish the file being recorded and free the packets, it waits for the
+* clip writer
+*/
+void event_recorder_free(event_recorder_t **rec);
+
+/*
+* The packets of a new input follow, in the time base: the file being
+* recorded is finished and the kept packets are dropped, an event in
+* progress goes on in a new file from the next keyframe
+*   return 0 on success, -1 on failure
+*/
+int event_recorder_set_stream(event_recorder_t *rec, const AVCodecParameters *par,
+                              AVRational time_base);
+
+/*
+* Start recording, or record post_us longer if it is recording
+*   now_us: monotonic time
+*/
+void event_recorder_trigger(event_recorder_t *rec, int64_t now_us);
+
+/*
+* Keep a reference of the packet and write it if recording. The packets
+* are kept from a keyframe, the oldest GOPs are dropped to stay in
+* pre_us and max_bytes
+*/
+void event_recorder_add_packet(event_recorder_t *rec, const AVPacket *pkt, int64_t now_us);
+
+/*
+* Safe from any thread
+*/
+void event_recorder_get_stats(event_recorder_t *rec, event_recorder_stats_t *stats);
+
+#endif /* __EVENT_RECORDER_H_ */
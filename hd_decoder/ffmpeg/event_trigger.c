@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: event_trigger.c
+*
+* PURPOSE: events of the recorder from a trigger file or a unix socket
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "event_trigger.h"
+
+#define FILE_PREFIX  "file:"
+#define UNIX_PREFIX  "unix:"
+#define MESSAGE_SIZE 64
+
+struct event_trigger_t {
+    char *path;
+    int  fd;        /*the socket, -1: the trigger file*/
+};
+
+/*"3\n" is an event of the stream 3, anything else of all the streams*/
+static int parse_stream(char *msg) {
+    char *p = msg;
+
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+
+    return isdigit((unsigned char)*p) ? atoi(p) : EVENT_ALL_STREAMS;
+}
+
+static int open_socket(event_trigger_t *trigger) {
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(trigger->path) >= sizeof(addr.sun_path)) {
+        printf("too long path of the trigger socket: %s\n", trigger->path);
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, trigger->path, sizeof(addr.sun_path) - 1);
+
+    fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        printf("failed to create the trigger socket(error: %s)\n", strerror(errno));
+        return -1;
+    }
+
+    /*left by the last run*/
+    unlink(trigger->path);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        printf("failed to bind the trigger socket %s(error: %s)\n",
+                trigger->path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    trigger->fd = fd;
+
+    return 0;
+}
+
+event_trigger_t *event_trigger_open(const char *target) {
+    event_trigger_t *trigger;
+    int is_socket;
+
+    if (!strncmp(target, UNIX_PREFIX, strlen(UNIX_PREFIX))) {
+        is_socket = 1;
+        target += strlen(UNIX_PREFIX);
+    } else if (!strncmp(target, FILE_PREFIX, strlen(FILE_PREFIX))) {
+        is_socket = 0;
+        target += strlen(FILE_PREFIX);
+    } else {
+        printf("unknown event trigger: %s\n", target);
+        return NULL;
+    }
+
+    trigger = (event_trigger_t *)malloc(sizeof(event_trigger_t));
+    if (trigger == NULL) {
+        printf("failed to malloc event_trigger_t\n");
+        return NULL;
+    }
+
+    trigger->fd   = -1;
+    trigger->path = strdup(target);
+    if (!trigger->path || (is_socket && open_socket(trigger))) {
+        event_trigger_close(&trigger);
+        return NULL;
+    }
+
+    return trigger;
+}
+
+void event_trigger_close(event_trigger_t **trigger) {
+    event_trigger_t *t = *trigger;
+
+    if (!t) {
+        return;
+    }
+
+    if (t->fd >= 0) {
+        close(t->fd);
+        unlink(t->path);
+    }
+
+    free(t->path);
+    free(t);
+
+    *trigger = NULL;
+}
+
+int event_trigger_poll(event_trigger_t *trigger, int *stream) {
+    char msg[MESSAGE_SIZE];
+    FILE *fp;
+    int len;
+
+    if (trigger->fd >= 0) {
+        len = recv(trigger->fd, msg, sizeof(msg) - 1, 0);
+        if (len < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                printf("failed to receive from the trigger socket(error: %s)\n", strerror(errno));
+            }
+            return 0;
+        }
+
+        msg[len] = '\0';
+        *stream = parse_stream(msg);
+
+        return 1;
+    }
+
+    fp = fopen(trigger->path, "r");
+    if (!fp) {
+        return 0;
+    }
+
+    if (!fgets(msg, sizeof(msg), fp)) {
+        msg[0] = '\0';
+    }
+    fclose(fp);
+
+    if (unlink(trigger->path) && errno != ENOENT) {
+        printf("failed to delete the trigger file %s(error: %s)\n", trigger->path, strerror(errno));
+    }
+
+    *stream = parse_stream(msg);
+
+    return 1;
+}
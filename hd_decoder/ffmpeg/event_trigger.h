@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: event_trigger.h
+*
+* PURPOSE: events of the recorder from a trigger file or a unix socket
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#ifndef __EVENT_TRIGGER_H_
+#define __EVENT_TRIGGER_H_
+
+#define EVENT_ALL_STREAMS (-1)
+
+typedef struct event_trigger_t event_trigger_t;
+
+/*
+* target: file:<path>, an event when the file is created, it is deleted then,
+*         or unix:<path> of a datagram socket which is created, an event
+*         per message.
+*         The file or the message may name the stream index, otherwise the
+*         event is of all the streams
+*/
+event_trigger_t *event_trigger_open(const char *target);
+
+void event_trigger_close(event_trigger_t **trigger);
+
+/*
+* Take the next event, it never blocks
+*   stream: the stream index or EVENT_ALL_STREAMS
+*   return 1 if there is an event, 0 if there is not
+*/
+int event_trigger_poll(event_trigger_t *trigger, int *stream);
+
+#endif /* __EVENT_TRIGGER_H_ */
@@ -0,0 +1,684 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: frame_archive.c
+*
+* PURPOSE: archive file of the decoded frames with their timestamps and
+*          an index, optionally compressed frame by frame, and the
+*          reader which maps it and gets any frame directly
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "frame_archive.h"
+
+#define FRAMEARC_ZSTD_LEVEL 1   /*fast, the frames are written in real time*/
+
+#define ALIGN_UP(x, a) (((x) + (a) - 1) & ~((uint64_t)(a) - 1))
+
+typedef struct frame_arc_t {
+    char             path[256];
+    int              writer;
+    int              fd;
+
+    /*writer*/
+    FrameArcCompression_t compression;
+    int              level;
+    uint64_t         offset;        /*end of the file*/
+    uint8_t          *raw;          /*packed picture*/
+    unsigned int     raw_size;
+    uint8_t          *comp;         /*compressed picture*/
+    unsigned int     comp_size;
+
+    /*reader*/
+    uint8_t          *base;
+    size_t           map_size;
+
+    FrameArcRecord_t *records;      /*the index, in the mapping if the archive was closed*/
+    int              own_records;
+    int              nb_records;
+    int              size;
+} frame_arc_t;
+
+static const char *compression_names[FRAMEARC_COMP_MAX] = {"none", "lz4", "zstd"};
+
+static const uint8_t zero_pad[FRAMEARC_ALIGN];
+
+static int pic_planes(int format, int width, int height, int *widths, int *heights) {
+    if (width <= 0 || height <= 0) {
+        return -1;
+    }
+
+    if (format == FRAMEARC_FMT_YUV420) {
+        widths[0]  = width;
+        heights[0] = height;
+        widths[1]  = widths[2]  = (width + 1) / 2;
+        heights[1] = heights[2] = (height + 1) / 2;
+        return 3;
+    } else if (format == FRAMEARC_FMT_NV12) {
+        widths[0]  = width;
+        heights[0] = height;
+        widths[1]  = (width + 1) / 2 * 2;
+        heights[1] = (height + 1) / 2;
+        return 2;
+    }
+
+    return -1;
+}
+
+static int compression_built(FrameArcCompression_t compression) {
+    switch (compression) {
+        case FRAMEARC_COMP_NONE:
+            return 1;
+#ifdef HAVE_LZ4
+        case FRAMEARC_COMP_LZ4:
+            return 1;
+#endif
+#ifdef HAVE_ZSTD
+        case FRAMEARC_COMP_ZSTD:
+            return 1;
+#endif
+        default:
+            return 0;
+    }
+}
+
+unsigned int FrameArcPicSize(FrameArcFormat_t format, int width, int height) {
+    int widths[FRAMEARC_MAX_PLANES];
+    int heights[FRAMEARC_MAX_PLANES];
+    unsigned int size = 0;
+    int nb_planes;
+    int i;
+
+    nb_planes = pic_planes(format, width, height, widths, heights);
+    for (i = 0; i < nb_planes; i++) {
+        size += widths[i] * heights[i];
+    }
+
+    return size;
+}
+
+FrameArcCompression_t FrameArcCompressionFromName(const char *name) {
+    int i;
+
+    for (i = 0; i < FRAMEARC_COMP_MAX; i++) {
+        if (!strcmp(name, compression_names[i])) {
+            return compression_built((FrameArcCompression_t)i) ?
+                   (FrameArcCompression_t)i : FRAMEARC_COMP_MAX;
+        }
+    }
+
+    return FRAMEARC_COMP_MAX;
+}
+
+const char *FrameArcCompressionName(FrameArcCompression_t compression) {
+    return compression >= 0 && compression < FRAMEARC_COMP_MAX ?
+           compression_names[compression] : "unknown";
+}
+
+static int write_all(int fd, const void *buf, size_t size, uint64_t offset) {
+    ssize_t ret;
+
+    while (size) {
+        ret = pwrite(fd, buf, size, offset);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf     = (const uint8_t *)buf + ret;
+        size   -= ret;
+        offset += ret;
+    }
+
+    return 0;
+}
+
+static int add_record(frame_arc_t *s, const FrameArcRecord_t *rec) {
+    FrameArcRecord_t *records;
+
+    if (s->nb_records == s->size) {
+        s->size = s->size ? s->size * 2 : 1024;
+        records = (FrameArcRecord_t *)realloc(s->records, s->size * sizeof(FrameArcRecord_t));
+        if (records == NULL) {
+            printf("failed to malloc the index of %d frames\n", s->size);
+            return -1;
+        }
+        s->records = records;
+    }
+
+    s->records[s->nb_records++] = *rec;
+
+    return 0;
+}
+
+FRAMEARC_HANDLE_t FrameArcCreate(const char *path, FrameArcCompression_t compression, int level) {
+    FrameArcHeader_t hdr;
+    frame_arc_t *s;
+
+    if (!compression_built(compression)) {
+        printf("frame archive compression %s is not supported\n",
+                FrameArcCompressionName(compression));
+        return NULL;
+    }
+
+    s = (frame_arc_t *)calloc(1, sizeof(frame_arc_t));
+    if (s == NULL) {
+        printf("failed to malloc frame_arc_t\n");
+        return NULL;
+    }
+
+    snprintf(s->path, sizeof(s->path), "%s", path);
+    s->writer      = 1;
+    s->compression = compression;
+    s->level       = level ? level : FRAMEARC_ZSTD_LEVEL;
+    s->own_records = 1;
+
+    s->fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (s->fd < 0) {
+        printf("failed to create frame archive %s(error: %s)\n", path, strerror(errno));
+        free(s);
+        return NULL;
+    }
+
+    /*index_offset stays 0 until the archive is closed*/
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic       = FRAMEARC_MAGIC;
+    hdr.version     = FRAMEARC_VERSION;
+    hdr.record_size = sizeof(FrameArcRecord_t);
+
+    if (write_all(s->fd, &hdr, sizeof(hdr), 0) < 0) {
+        printf("failed to write frame archive %s(error: %s)\n", path, strerror(errno));
+        close(s->fd);
+        free(s);
+        return NULL;
+    }
+    s->offset = sizeof(hdr);
+
+    return (FRAMEARC_HANDLE_t)s;
+}
+
+/*
+* Compress the packed picture into s->comp
+*   return the compressed bytes, 0 if it does not get smaller
+*/
+static unsigned int compress_pic(frame_arc_t *s, unsigned int size) {
+    unsigned int bound = 0;
+    uint8_t *comp;
+    long ret = 0;
+
+#ifdef HAVE_LZ4
+    if (s->compression == FRAMEARC_COMP_LZ4) {
+        bound = LZ4_compressBound(size);
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (s->compression == FRAMEARC_COMP_ZSTD) {
+        bound = ZSTD_compressBound(size);
+    }
+#endif
+    if (!bound) {
+        return 0;
+    }
+
+    if (bound > s->comp_size) {
+        comp = (uint8_t *)realloc(s->comp, bound);
+        if (comp == NULL) {
+            return 0;
+        }
+        s->comp      = comp;
+        s->comp_size = bound;
+    }
+
+#ifdef HAVE_LZ4
+    if (s->compression == FRAMEARC_COMP_LZ4) {
+        ret = LZ4_compress_default((const char *)s->raw, (char *)s->comp, size, bound);
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (s->compression == FRAMEARC_COMP_ZSTD) {
+        size_t bytes = ZSTD_compress(s->comp, bound, s->raw, size, s->level);
+
+        ret = ZSTD_isError(bytes) ? 0 : (long)bytes;
+    }
+#endif
+
+    return ret > 0 && ret < size ? (unsigned int)ret : 0;
+}
+
+int FrameArcAppend(FRAMEARC_HANDLE_t handle, const FrameArcPic_t *pic) {
+    frame_arc_t *s = (frame_arc_t *)handle;
+    int widths[FRAMEARC_MAX_PLANES];
+    int heights[FRAMEARC_MAX_PLANES];
+    FrameArcRecord_t rec;
+    struct iovec iov[3];
+    unsigned int size;
+    unsigned int offset = 0;
+    uint8_t *raw;
+    uint64_t pos;
+    ssize_t ret;
+    int nb_planes;
+    int i, j;
+
+    nb_planes = pic_planes(pic->format, pic->width, pic->height, widths, heights);
+    if (nb_planes < 0) {
+        return -1;
+    }
+
+    size = FrameArcPicSize(pic->format, pic->width, pic->height);
+    if (size > s->raw_size) {
+        raw = (uint8_t *)realloc(s->raw, size);
+        if (raw == NULL) {
+            printf("failed to malloc %u bytes\n", size);
+            return -1;
+        }
+        s->raw      = raw;
+        s->raw_size = size;
+    }
+
+    for (i = 0; i < nb_planes; i++) {
+        if (pic->linesize[i] == widths[i]) {
+            memcpy(s->raw + offset, pic->data[i], (size_t)widths[i] * heights[i]);
+        } else {
+            for (j = 0; j < heights[i]; j++) {
+                memcpy(s->raw + offset + j * widths[i],
+                       pic->data[i] + (ptrdiff_t)j * pic->linesize[i],
+                       widths[i]);
+            }
+        }
+        offset += widths[i] * heights[i];
+    }
+
+    memset(&rec, 0, sizeof(rec));
+    rec.magic         = FRAMEARC_RECORD_MAGIC;
+    rec.compression   = FRAMEARC_COMP_NONE;
+    rec.pts           = pic->pts;
+    rec.time_base_num = pic->time_base_num;
+    rec.time_base_den = pic->time_base_den;
+    rec.width         = pic->width;
+    rec.height        = pic->height;
+    rec.format        = pic->format;
+    rec.raw_size      = size;
+    rec.offset        = s->offset + sizeof(rec);
+    rec.size          = size;
+
+    iov[0].iov_base = &rec;
+    iov[0].iov_len  = sizeof(rec);
+    iov[1].iov_base = s->raw;
+    iov[1].iov_len  = size;
+
+    if (s->compression != FRAMEARC_COMP_NONE) {
+        rec.size = compress_pic(s, size);
+        if (rec.size) {
+            rec.compression = s->compression;
+            iov[1].iov_base = s->comp;
+            iov[1].iov_len  = rec.size;
+        } else {
+            rec.size = size;
+        }
+    }
+
+    iov[2].iov_base = (void *)zero_pad;
+    iov[2].iov_len  = ALIGN_UP(rec.offset + rec.size, FRAMEARC_ALIGN) - (rec.offset + rec.size);
+
+    /*a short write is finished with pwrite()*/
+    pos = s->offset;
+    ret = pwritev(s->fd, iov, 3, pos);
+    if (ret < 0 && errno != EINTR) {
+        printf("failed to write frame archive %s(error: %s)\n", s->path, strerror(errno));
+        return -1;
+    }
+    if (ret < 0) {
+        ret = 0;
+    }
+
+    for (i = 0; i < 3; i++) {
+        if ((size_t)ret >= iov[i].iov_len) {
+            ret -= iov[i].iov_len;
+            pos += iov[i].iov_len;
+            continue;
+        }
+
+        if (write_all(s->fd, (uint8_t *)iov[i].iov_base + ret, iov[i].iov_len - ret, pos + ret) < 0) {
+            printf("failed to write frame archive %s(error: %s)\n", s->path, strerror(errno));
+            return -1;
+        }
+        pos += iov[i].iov_len;
+        ret  = 0;
+    }
+
+    if (add_record(s, &rec) < 0) {
+        return -1;
+    }
+    s->offset = pos;
+
+    return 0;
+}
+
+static int valid_record(frame_arc_t *s, const FrameArcRecord_t *rec) {
+    int widths[FRAMEARC_MAX_PLANES];
+    int heights[FRAMEARC_MAX_PLANES];
+
+    return rec->magic == FRAMEARC_RECORD_MAGIC &&
+           rec->compression < FRAMEARC_COMP_MAX &&
+           pic_planes(rec->format, rec->width, rec->height, widths, heights) > 0 &&
+           rec->raw_size == FrameArcPicSize(rec->format, rec->width, rec->height) &&
+           rec->offset >= sizeof(FrameArcHeader_t) + sizeof(FrameArcRecord_t) &&
+           rec->offset <= s->map_size && rec->size <= s->map_size - rec->offset &&
+           (rec->compression != FRAMEARC_COMP_NONE || rec->size == rec->raw_size);
+}
+
+/*
+* Rebuild the index of an archive which was not closed from the records
+* in front of the frames, up to the first incomplete one
+*/
+static int scan_records(frame_arc_t *s) {
+    const FrameArcRecord_t *rec;
+    uint64_t offset = sizeof(FrameArcHeader_t);
+
+    s->own_records = 1;
+
+    while (offset + sizeof(FrameArcRecord_t) <= s->map_size) {
+        rec = (const FrameArcRecord_t *)(s->base + offset);
+        if (rec->offset != offset + sizeof(FrameArcRecord_t) || !valid_record(s, rec)) {
+            break;
+        }
+
+        if (add_record(s, rec) < 0) {
+            return -1;
+        }
+        offset = ALIGN_UP(rec->offset + rec->size, FRAMEARC_ALIGN);
+    }
+
+    printf("frame archive %s was not closed, %d frames are found\n", s->path, s->nb_records);
+
+    return 0;
+}
+
+FRAMEARC_HANDLE_t FrameArcOpen(const char *path) {
+    const FrameArcHeader_t *hdr;
+    frame_arc_t *s;
+    struct stat st;
+    int i;
+
+    s = (frame_arc_t *)calloc(1, sizeof(frame_arc_t));
+    if (s == NULL) {
+        printf("failed to malloc frame_arc_t\n");
+        return NULL;
+    }
+
+    snprintf(s->path, sizeof(s->path), "%s", path);
+
+    s->fd = open(path, O_RDONLY);
+    if (s->fd < 0) {
+        printf("failed to open frame archive %s(error: %s)\n", path, strerror(errno));
+        free(s);
+        return NULL;
+    }
+
+    if (fstat(s->fd, &st) < 0 || st.st_size < (off_t)sizeof(FrameArcHeader_t)) {
+        printf("%s is not a frame archive\n", path);
+        goto fail;
+    }
+
+    s->map_size = st.st_size;
+    s->base = (uint8_t *)mmap(NULL, s->map_size, PROT_READ, MAP_SHARED, s->fd, 0);
+    if (s->base == MAP_FAILED) {
+        printf("failed to map frame archive %s(error: %s)\n", path, strerror(errno));
+        s->base = NULL;
+        goto fail;
+    }
+
+    hdr = (const FrameArcHeader_t *)s->base;
+    if (hdr->magic != FRAMEARC_MAGIC) {
+        printf("%s is not a frame archive\n", path);
+        goto fail;
+    }
+
+    if (hdr->version != FRAMEARC_VERSION || hdr->record_size != sizeof(FrameArcRecord_t)) {
+        printf("unsupported frame archive %s(version %u)\n", path, hdr->version);
+        goto fail;
+    }
+
+    if (!hdr->index_offset) {
+        if (scan_records(s) < 0) {
+            goto fail;
+        }
+        return (FRAMEARC_HANDLE_t)s;
+    }
+
+    if (hdr->index_offset % FRAMEARC_ALIGN || hdr->index_offset > s->map_size ||
+        hdr->nb_frames > (s->map_size - hdr->index_offset) / sizeof(FrameArcRecord_t) ||
+        hdr->nb_frames > 0x7fffffff) {
+        printf("corrupt frame archive %s\n", path);
+        goto fail;
+    }
+
+    s->records    = (FrameArcRecord_t *)(s->base + hdr->index_offset);
+    s->nb_records = hdr->nb_frames;
+    for (i = 0; i < s->nb_records; i++) {
+        if (!valid_record(s, &s->records[i])) {
+            printf("corrupt record of frame %d in frame archive %s\n", i, path);
+            goto fail;
+        }
+    }
+
+    return (FRAMEARC_HANDLE_t)s;
+
+fail:
+    if (s->own_records) {
+        free(s->records);
+    }
+    if (s->base) {
+        munmap(s->base, s->map_size);
+    }
+    close(s->fd);
+    free(s);
+    return NULL;
+}
+
+int FrameArcCount(FRAMEARC_HANDLE_t handle) {
+    frame_arc_t *s = (frame_arc_t *)handle;
+
+    return s->nb_records;
+}
+
+static void fill_pic(const FrameArcRecord_t *rec, uint8_t *data, FrameArcPic_t *pic) {
+    int widths[FRAMEARC_MAX_PLANES];
+    int heights[FRAMEARC_MAX_PLANES];
+    unsigned int offset = 0;
+    int nb_planes;
+    int i;
+
+    pic->pts           = rec->pts;
+    pic->time_base_num = rec->time_base_num;
+    pic->time_base_den = rec->time_base_den;
+    pic->width         = rec->width;
+    pic->height        = rec->height;
+    pic->format        = (FrameArcFormat_t)rec->format;
+    pic->size          = rec->raw_size;
+
+    nb_planes = pic_planes(rec->format, rec->width, rec->height, widths, heights);
+    for (i = 0; i < FRAMEARC_MAX_PLANES; i++) {
+        if (i >= nb_planes) {
+            pic->data[i]     = NULL;
+            pic->linesize[i] = 0;
+            continue;
+        }
+
+        pic->data[i]     = data + offset;
+        pic->linesize[i] = widths[i];
+        offset += widths[i] * heights[i];
+    }
+}
+
+int FrameArcPeek(FRAMEARC_HANDLE_t handle, int n, FrameArcPic_t *pic) {
+    frame_arc_t *s = (frame_arc_t *)handle;
+    const FrameArcRecord_t *rec;
+
+    if (n < 0 || n >= s->nb_records) {
+        return -1;
+    }
+
+    rec = &s->records[n];
+    if (rec->compression != FRAMEARC_COMP_NONE) {
+        /*the picture is not in the mapping as is, but the caller gets its size*/
+        fill_pic(rec, NULL, pic);
+        return 1;
+    }
+
+    fill_pic(rec, s->base + rec->offset, pic);
+
+    return 0;
+}
+
+int FrameArcRead(FRAMEARC_HANDLE_t handle, int n, FrameArcPic_t *pic,
+                 void *buf, unsigned int size) {
+    frame_arc_t *s = (frame_arc_t *)handle;
+    const FrameArcRecord_t *rec;
+    const uint8_t *src;
+    long ret = -1;
+
+    if (n < 0 || n >= s->nb_records) {
+        return -1;
+    }
+
+    rec = &s->records[n];
+    if (rec->raw_size > size) {
+        printf("buffer of %u bytes is too small for the %u bytes frame\n", size, rec->raw_size);
+        return -1;
+    }
+
+    src = s->base + rec->offset;
+    switch (rec->compression) {
+        case FRAMEARC_COMP_NONE:
+            memcpy(buf, src, rec->raw_size);
+            ret = rec->raw_size;
+            break;
+#ifdef HAVE_LZ4
+        case FRAMEARC_COMP_LZ4:
+            ret = LZ4_decompress_safe((const char *)src, (char *)buf, rec->size, rec->raw_size);
+            break;
+#endif
+#ifdef HAVE_ZSTD
+        case FRAMEARC_COMP_ZSTD: {
+            size_t bytes = ZSTD_decompress(buf, rec->raw_size, src, rec->size);
+
+            ret = ZSTD_isError(bytes) ? -1 : (long)bytes;
+            break;
+        }
+#endif
+        default:
+            printf("frame %d of %s is compressed by %s, which is not supported\n",
+                    n, s->path, FrameArcCompressionName(rec->compression));
+            return -1;
+    }
+
+    if (ret != rec->raw_size) {
+        printf("corrupt frame %d in frame archive %s\n", n, s->path);
+        return -1;
+    }
+
+    fill_pic(rec, (uint8_t *)buf, pic);
+
+    return 0;
+}
+
+int FrameArcFind(FRAMEARC_HANDLE_t handle, int64_t pts) {
+    frame_arc_t *s = (frame_arc_t *)handle;
+    int lo = 0;
+    int hi = s->nb_records;
+    int mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (s->records[mid].pts < pts) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo < s->nb_records ? lo : -1;
+}
+
+void FrameArcRelease(FRAMEARC_HANDLE_t handle) {
+    frame_arc_t *s = (frame_arc_t *)handle;
+    FrameArcHeader_t hdr;
+    uint64_t index_offset;
+
+    if (!s) {
+        return;
+    }
+
+    if (s->writer) {
+        index_offset = ALIGN_UP(s->offset, FRAMEARC_ALIGN);
+
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.magic        = FRAMEARC_MAGIC;
+        hdr.version      = FRAMEARC_VERSION;
+        hdr.record_size  = sizeof(FrameArcRecord_t);
+        hdr.nb_frames    = s->nb_records;
+        hdr.index_offset = index_offset;
+
+        /*the header points at the index only once it is complete*/
+        if (write_all(s->fd, s->records, (size_t)s->nb_records * sizeof(FrameArcRecord_t),
+                      index_offset) < 0 ||
+            fdatasync(s->fd) < 0 ||
+            write_all(s->fd, &hdr, sizeof(hdr), 0) < 0) {
+            printf("failed to write the index of frame archive %s(error: %s)\n",
+                    s->path, strerror(errno));
+        }
+
+        free(s->raw);
+        free(s->comp);
+    } else {
+        munmap(s->base, s->map_size);
+    }
+
+    if (s->own_records) {
+        free(s->records);
+    }
+    close(s->fd);
+    free(s);
+}
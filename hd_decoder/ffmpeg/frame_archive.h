@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: frame_archive.h
+*
+* PURPOSE: archive file of the decoded frames with their timestamps and
+*          an index, optionally compressed frame by frame, and the
+*          reader which maps it and gets any frame directly
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#ifndef __FRAME_ARCHIVE_H_
+#define __FRAME_ARCHIVE_H_
+
+#include <sys/cdefs.h>
+#include <stdint.h>
+
+__BEGIN_DECLS
+
+#ifndef FRAMEARC_IN
+#define FRAMEARC_IN
+#endif
+
+#ifndef FRAMEARC_OUT
+#define FRAMEARC_OUT
+#endif
+
+#define FRAMEARC_MAGIC        0x43524146  /*"FARC"*/
+#define FRAMEARC_RECORD_MAGIC 0x43455246  /*"FREC"*/
+#define FRAMEARC_VERSION      1
+#define FRAMEARC_MAX_PLANES   3
+#define FRAMEARC_ALIGN        64          /*of the records and the picture data*/
+
+typedef void* FRAMEARC_HANDLE_t;
+
+typedef enum {
+    FRAMEARC_FMT_YUV420 = 0,  // YYYY.....U....V...
+    FRAMEARC_FMT_NV12,        // YYYY.....UV....
+
+    FRAMEARC_FMT_MAX
+} FrameArcFormat_t;
+
+/*the ones which are not built in(HAVE_LZ4, HAVE_ZSTD) can not be written or read*/
+typedef enum {
+    FRAMEARC_COMP_NONE = 0,
+    FRAMEARC_COMP_LZ4,
+    FRAMEARC_COMP_ZSTD,
+
+    FRAMEARC_COMP_MAX
+} FrameArcCompression_t;
+
+/*
+Layout of the archive file:
+
+    FrameArcHeader_t                    64 bytes
+    FrameArcRecord_t of frame 0         64 bytes
+    data of frame 0                     record.size bytes, padded to 64
+    FrameArcRecord_t of frame 1 ...
+    FrameArcRecord_t[nb_frames]         the index, at header.index_offset
+
+The index and header.index_offset are written when the archive is closed.
+The index of an archive which was not closed(index_offset 0) is rebuilt
+by the reader from the records in front of the frames.
+
+The planes of a picture are packed without stride padding. A frame is
+stored compressed only if it gets smaller.
+*/
+typedef struct _FrameArcHeader_t {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t nb_frames;      /*in the index*/
+    uint64_t index_offset;   /*0: the archive was not closed*/
+    uint32_t record_size;    /*sizeof(FrameArcRecord_t)*/
+    uint32_t reserved[9];
+} FrameArcHeader_t;
+
+typedef struct _FrameArcRecord_t {
+    uint32_t magic;          /*FRAMEARC_RECORD_MAGIC*/
+    uint32_t compression;    /*FrameArcCompression_t of the data*/
+    int64_t  pts;
+    int32_t  time_base_num;
+    int32_t  time_base_den;
+    int32_t  width;
+    int32_t  height;
+    int32_t  format;         /*FrameArcFormat_t*/
+    uint32_t raw_size;       /*bytes of the picture*/
+    uint64_t offset;         /*of the data in the file*/
+    uint32_t size;           /*bytes of the data*/
+    uint32_t reserved[3];
+} FrameArcRecord_t;
+
+typedef struct _FrameArcPic_t {
+    int64_t          pts;
+    int              time_base_num;
+    int              time_base_den;
+    int              width;
+    int              height;
+    FrameArcFormat_t format;
+
+    uint8_t          *data[FRAMEARC_MAX_PLANES];
+    int              linesize[FRAMEARC_MAX_PLANES];
+    unsigned int     size;   /*bytes of the picture*/
+} FrameArcPic_t;
+
+/*
+* Bytes of a picture without stride padding
+*/
+unsigned int FrameArcPicSize(FRAMEARC_IN FrameArcFormat_t format,
+                             FRAMEARC_IN int width,
+                             FRAMEARC_IN int height);
+
+/*
+* "none", "lz4" or "zstd"
+*   return FRAMEARC_COMP_MAX if unknown or not built in
+*/
+FrameArcCompression_t FrameArcCompressionFromName(FRAMEARC_IN const char *name);
+
+const char *FrameArcCompressionName(FRAMEARC_IN FrameArcCompression_t compression);
+
+/*
+* Writer: create the archive, an existing file is replaced
+*   level: of zstd, 0: default
+*/
+FRAMEARC_HANDLE_t FrameArcCreate(FRAMEARC_IN const char *path,
+                                 FRAMEARC_IN FrameArcCompression_t compression,
+                                 FRAMEARC_IN int level);
+
+/*
+* Writer: append the picture,
+*   pic->data/linesize: the source planes, pic->size is ignored
+*   return 0 on success, -1 on failure
+*/
+int FrameArcAppend(FRAMEARC_IN FRAMEARC_HANDLE_t handle,
+                   FRAMEARC_IN const FrameArcPic_t *pic);
+
+/*
+* Reader: map the archive, a reader handle may be used by several
+* threads at the same time
+*   return NULL on failure
+*/
+FRAMEARC_HANDLE_t FrameArcOpen(FRAMEARC_IN const char *path);
+
+/*
+* return the number of frames
+*/
+int FrameArcCount(FRAMEARC_IN FRAMEARC_HANDLE_t handle);
+
+/*
+* Reader: get frame n without copying it,
+*   pic->data points into the mapping, valid until FrameArcRelease()
+*   return 0 on success, 1 if the frame is compressed: use FrameArcRead(),
+*          -1 if there is no frame n
+*/
+int FrameArcPeek(FRAMEARC_IN  FRAMEARC_HANDLE_t handle,
+                 FRAMEARC_IN  int n,
+                 FRAMEARC_OUT FrameArcPic_t *pic);
+
+/*
+* Reader: copy or decompress frame n into buf of size bytes,
+*   pic->data points into buf.
+*   return 0 on success, -1 if there is no frame n, buf is too small or
+*          the data is corrupt
+*/
+int FrameArcRead(FRAMEARC_IN  FRAMEARC_HANDLE_t handle,
+                 FRAMEARC_IN  int n,
+                 FRAMEARC_OUT FrameArcPic_t *pic,
+                 FRAMEARC_IN  void *buf,
+                 FRAMEARC_IN  unsigned int size);
+
+/*
+* Reader: the first frame with a pts at or after pts, the frames are
+* in pts order
+*   return the frame number, -1 if there is none
+*/
+int FrameArcFind(FRAMEARC_IN FRAMEARC_HANDLE_t handle,
+                 FRAMEARC_IN int64_t pts);
+
+/*
+* Writer: write the index and close the archive
+* Reader: unmap the archive
+*/
+void FrameArcRelease(FRAMEARC_IN FRAMEARC_HANDLE_t handle);
+
+__END_DECLS
+
+#endif /* __FRAME_ARCHIVE_H_ */
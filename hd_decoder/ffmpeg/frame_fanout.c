@@ -0,0 +1,461 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: frame_fanout.c
+*
+* PURPOSE: share the decoded frames by reference with several consumers,
+*          each one with its own queue, thread, drop policy and rate limit
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Wait for the consumers to process their queues
+************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "frame_fanout.h"
+#include "cpu_affinity.h"
+
+#define FANOUT_MAX_CONSUMERS 8
+
+typedef struct fanout_slot_t {
+    int     stream;
+    AVFrame *frame;
+} fanout_slot_t;
+
+typedef struct fanout_consumer_t {
+    frame_fanout_t  *fo;
+    fanout_consumer_config_t cfg;
+    char            name[16];   /*the max of a thread name*/
+
+    /*
+    The queue of the references, the producers fill it and the thread of
+    the consumer empties it, the slots keep their AVFrame
+    */
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    pthread_cond_t  idle_cond;  /*signaled when the queue is processed*/
+    fanout_slot_t   *slots;
+    unsigned int    head;       /*next slot to process*/
+    unsigned int    tail;       /*next slot to queue*/
+    int             busy;       /*the thread processes a frame*/
+    int             quit;
+    pthread_t       thread;
+    int             has_thread;
+
+    int64_t         interval_us;    /*of max_fps, 0: no limit*/
+    int64_t         *next_pts_us;   /*per stream, only touched by its producer*/
+
+    int             max_occupancy;
+    atomic_ullong   nb_frames;
+    atomic_ullong   nb_limited;
+    atomic_ullong   nb_dropped;
+    atomic_ullong   nb_failed;
+} fanout_consumer_t;
+
+struct frame_fanout_t {
+    int                 nb_streams;
+    fanout_consumer_t   *consumers[FANOUT_MAX_CONSUMERS];
+    int                 nb_consumers;
+};
+
+static const char *policy_names[FANOUT_POLICY_MAX] = {
+    "newest", "oldest"
+};
+
+static void process_frame(fanout_consumer_t *c, int stream, AVFrame *frame) {
+    if (c->cfg.process(c->cfg.opaque, stream, frame) < 0) {
+        atomic_fetch_add_explicit(&c->nb_failed, 1, memory_order_relaxed);
+    } else {
+        atomic_fetch_add_explicit(&c->nb_frames, 1, memory_order_relaxed);
+    }
+}
+
+static void *consumerThreadEntry(void *priv) {
+    fanout_consumer_t *c = (fanout_consumer_t *)priv;
+    fanout_slot_t *slot;
+    AVFrame *frame;
+    int stream;
+
+    frame = av_frame_alloc();
+    if (!frame) {
+        printf("[%s] failed to allocate AVFrame\n", c->name);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&c->lock);
+
+    for (;;) {
+        while (c->head == c->tail && !c->quit) {
+            pthread_cond_wait(&c->cond, &c->lock);
+        }
+
+        if (c->head == c->tail) {
+            break;
+        }
+
+        /*take the reference out of the slot, the producers reuse it meanwhile*/
+        slot = &c->slots[c->head % c->cfg.depth];
+        stream = slot->stream;
+        av_frame_move_ref(frame, slot->frame);
+        c->head++;
+        c->busy = 1;
+        pthread_mutex_unlock(&c->lock);
+
+        process_frame(c, stream, frame);
+        av_frame_unref(frame);
+
+        pthread_mutex_lock(&c->lock);
+        c->busy = 0;
+        if (c->head == c->tail) {
+            pthread_cond_broadcast(&c->idle_cond);
+        }
+    }
+
+    pthread_mutex_unlock(&c->lock);
+
+    av_frame_free(&frame);
+
+    return NULL;
+}
+
+static void free_consumer(fanout_consumer_t *c) {
+    int i;
+
+    if (c->has_thread) {
+        pthread_mutex_lock(&c->lock);
+        c->quit = 1;
+        pthread_cond_signal(&c->cond);
+        pthread_mutex_unlock(&c->lock);
+
+        pthread_join(c->thread, NULL);
+    }
+
+    if (c->slots) {
+        for (i = 0; i < c->cfg.depth; i++) {
+            av_frame_free(&c->slots[i].frame);
+        }
+        free(c->slots);
+    }
+
+    pthread_cond_destroy(&c->idle_cond);
+    pthread_cond_destroy(&c->cond);
+    pthread_mutex_destroy(&c->lock);
+    free(c->next_pts_us);
+    free(c);
+}
+
+/*
+* Return 1 if the rate limit of the consumer skips the frame, the targets
+* stay on their grid and restart after a gap or a jump back
+*/
+static int limit_frame(fanout_consumer_t *c, int stream, int64_t pts_us) {
+    int64_t *next = &c->next_pts_us[stream];
+
+    if (!c->interval_us || pts_us == AV_NOPTS_VALUE) {
+        return 0;
+    }
+
+    if (*next != AV_NOPTS_VALUE && pts_us < *next && pts_us >= *next - c->interval_us) {
+        return 1;
+    }
+
+    if (*next == AV_NOPTS_VALUE || pts_us < *next || pts_us - *next >= c->interval_us) {
+        *next = pts_us + c->interval_us;
+    } else {
+        *next += c->interval_us;
+    }
+
+    return 0;
+}
+
+/*
+*   return 0 if queued, 1 if dropped
+*/
+static int queue_frame(fanout_consumer_t *c, int stream, const AVFrame *frame) {
+    fanout_slot_t *slot;
+    int occupancy;
+    int dropped = 0;
+
+    pthread_mutex_lock(&c->lock);
+
+    if (c->tail - c->head == (unsigned int)c->cfg.depth) {
+        if (c->cfg.policy == FANOUT_DROP_NEWEST) {
+            pthread_mutex_unlock(&c->lock);
+            return 1;
+        }
+
+        av_frame_unref(c->slots[c->head % c->cfg.depth].frame);
+        c->head++;
+        dropped = 1;
+    }
+
+    slot = &c->slots[c->tail % c->cfg.depth];
+    if (av_frame_ref(slot->frame, frame) < 0) {
+        pthread_mutex_unlock(&c->lock);
+        return 1;
+    }
+
+    slot->stream = stream;
+    c->tail++;
+
+    occupancy = c->tail - c->head;
+    if (occupancy > c->max_occupancy) {
+        c->max_occupancy = occupancy;
+    }
+
+    pthread_cond_signal(&c->cond);
+    pthread_mutex_unlock(&c->lock);
+
+    return dropped;
+}
+
+frame_fanout_t *frame_fanout_create(int nb_streams) {
+    frame_fanout_t *fo;
+
+    if (nb_streams <= 0) {
+        printf("invalid number of streams of frame fanout: %d\n", nb_streams);
+        return NULL;
+    }
+
+    fo = (frame_fanout_t *)calloc(1, sizeof(frame_fanout_t));
+    if (fo == NULL) {
+        printf("failed to malloc frame_fanout_t\n");
+        return NULL;
+    }
+
+    fo->nb_streams = nb_streams;
+
+    return fo;
+}
+
+void frame_fanout_destroy(frame_fanout_t **fo) {
+    int i;
+
+    if (!fo || !*fo) {
+        return;
+    }
+
+    for (i = 0; i < (*fo)->nb_consumers; i++) {
+        free_consumer((*fo)->consumers[i]);
+    }
+
+    free(*fo);
+    *fo = NULL;
+}
+
+void frame_fanout_flush(frame_fanout_t *fo) {
+    fanout_consumer_t *c;
+    int i;
+
+    if (!fo) {
+        return;
+    }
+
+    for (i = 0; i < fo->nb_consumers; i++) {
+        c = fo->consumers[i];
+        if (!c->has_thread) {
+            continue;
+        }
+
+        pthread_mutex_lock(&c->lock);
+        while (c->head != c->tail || c->busy) {
+            pthread_cond_wait(&c->idle_cond, &c->lock);
+        }
+        pthread_mutex_unlock(&c->lock);
+    }
+}
+
+int frame_fanout_add(frame_fanout_t *fo, const fanout_consumer_config_t *cfg) {
+    fanout_consumer_t *c;
+    int ret;
+    int i;
+
+    if (fo->nb_consumers == FANOUT_MAX_CONSUMERS) {
+        printf("too many frame consumers, the max is %d\n", FANOUT_MAX_CONSUMERS);
+        return -1;
+    }
+
+    if (!cfg->process || cfg->depth < 0 || cfg->max_fps < 0 ||
+        cfg->policy >= FANOUT_POLICY_MAX) {
+        printf("invalid frame consumer %s\n", cfg->name ? cfg->name : "");
+        return -1;
+    }
+
+    c = (fanout_consumer_t *)calloc(1, sizeof(fanout_consumer_t));
+    if (c == NULL) {
+        printf("failed to malloc fanout_consumer_t\n");
+        return -1;
+    }
+
+    c->fo  = fo;
+    c->cfg = *cfg;
+    snprintf(c->name, sizeof(c->name), "%s", cfg->name ? cfg->name : "fanout");
+    c->cfg.name = c->name;
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->cond, NULL);
+    pthread_cond_init(&c->idle_cond, NULL);
+    atomic_init(&c->nb_frames, 0);
+    atomic_init(&c->nb_limited, 0);
+    atomic_init(&c->nb_dropped, 0);
+    atomic_init(&c->nb_failed, 0);
+
+    c->next_pts_us = (int64_t *)malloc(fo->nb_streams * sizeof(int64_t));
+    if (c->next_pts_us == NULL) {
+        printf("failed to malloc the rate limits of %d streams\n", fo->nb_streams);
+        free_consumer(c);
+        return -1;
+    }
+    for (i = 0; i < fo->nb_streams; i++) {
+        c->next_pts_us[i] = AV_NOPTS_VALUE;
+    }
+    if (cfg->max_fps > 0) {
+        c->interval_us = (int64_t)(1000000 / cfg->max_fps);
+    }
+
+    if (cfg->depth > 0) {
+        c->slots = (fanout_slot_t *)calloc(cfg->depth, sizeof(fanout_slot_t));
+        if (c->slots == NULL) {
+            printf("failed to malloc %d slots of %s\n", cfg->depth, c->name);
+            c->cfg.depth = 0;
+            free_consumer(c);
+            return -1;
+        }
+
+        for (i = 0; i < cfg->depth; i++) {
+            c->slots[i].frame = av_frame_alloc();
+            if (!c->slots[i].frame) {
+                printf("failed to allocate AVFrame\n");
+                c->cfg.depth = i;
+                free_consumer(c);
+                return -1;
+            }
+        }
+
+        ret = pthread_create(&c->thread, NULL, consumerThreadEntry, (void *)c);
+        if (ret != 0) {
+            printf("Failed to create the thread of %s(res=%d, error=%s)\n",
+                    c->name, ret, strerror(ret));
+            free_consumer(c);
+            return -1;
+        }
+        c->has_thread = 1;
+        pthread_setname_np(c->thread, c->name);
+    }
+
+    fo->consumers[fo->nb_consumers] = c;
+
+    return fo->nb_consumers++;
+}
+
+int frame_fanout_nb_consumers(frame_fanout_t *fo) {
+    return fo->nb_consumers;
+}
+
+int frame_fanout_set_affinity(frame_fanout_t *fo, const char *cpus) {
+    int i;
+
+    for (i = 0; i < fo->nb_consumers; i++) {
+        if (fo->consumers[i]->has_thread &&
+            cpu_affinity_set(fo->consumers[i]->thread, cpus) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int frame_fanout_push(frame_fanout_t *fo, int stream, const AVFrame *frame, int64_t pts_us) {
+    fanout_consumer_t *c;
+    int nb_dropped = 0;
+    int i;
+
+    for (i = 0; i < fo->nb_consumers; i++) {
+        c = fo->consumers[i];
+
+        if (limit_frame(c, stream, pts_us)) {
+            atomic_fetch_add_explicit(&c->nb_limited, 1, memory_order_relaxed);
+            continue;
+        }
+
+        if (!c->cfg.depth) {
+            /*the consumer queues the frame itself, a refusal is a drop*/
+            if (c->cfg.process(c->cfg.opaque, stream, (AVFrame *)frame)) {
+                atomic_fetch_add_explicit(&c->nb_dropped, 1, memory_order_relaxed);
+                nb_dropped++;
+            } else {
+                atomic_fetch_add_explicit(&c->nb_frames, 1, memory_order_relaxed);
+            }
+            continue;
+        }
+
+        if (queue_frame(c, stream, frame)) {
+            atomic_fetch_add_explicit(&c->nb_dropped, 1, memory_order_relaxed);
+            nb_dropped++;
+        }
+    }
+
+    return nb_dropped;
+}
+
+void frame_fanout_get_stats(frame_fanout_t *fo, int index, fanout_stats_t *stats) {
+    fanout_consumer_t *c = fo->consumers[index];
+
+    pthread_mutex_lock(&c->lock);
+    stats->occupancy     = c->tail - c->head;
+    stats->max_occupancy = c->max_occupancy;
+    pthread_mutex_unlock(&c->lock);
+
+    stats->name       = c->name;
+    stats->depth      = c->cfg.depth;
+    stats->nb_frames  = atomic_load_explicit(&c->nb_frames, memory_order_relaxed);
+    stats->nb_limited = atomic_load_explicit(&c->nb_limited, memory_order_relaxed);
+    stats->nb_dropped = atomic_load_explicit(&c->nb_dropped, memory_order_relaxed);
+    stats->nb_failed  = atomic_load_explicit(&c->nb_failed, memory_order_relaxed);
+}
+
+const char *fanout_policy_name(fanout_policy_t policy) {
+    if (policy >= FANOUT_POLICY_MAX) {
+        return "unknown";
+    }
+
+    return policy_names[policy];
+}
+
+fanout_policy_t fanout_policy_from_name(const char *name) {
+    int i;
+
+    for (i = 0; i < FANOUT_POLICY_MAX; i++) {
+        if (!strcmp(name, policy_names[i])) {
+            return (fanout_policy_t)i;
+        }
+    }
+
+    return FANOUT_POLICY_MAX;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: frame_fanout.h
+*
+* PURPOSE: share the decoded frames by reference with several consumers,
+*          each one with its own queue, thread, drop policy and rate limit
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Wait for the consumers to process their queues
+************************************************************************/
+
+#ifndef __FRAME_FANOUT_H_
+#define __FRAME_FANOUT_H_
+
+#include <stdint.h>
+
+#include <libavutil/frame.h>
+
+/*what frame_fanout_push() does when the queue of a consumer is full*/
+typedef enum {
+    FANOUT_DROP_NEWEST = 0,     /*the consumer does not get the new frame*/
+    FANOUT_DROP_OLDEST,         /*the oldest queued frame makes room for it*/
+
+    FANOUT_POLICY_MAX
+} fanout_policy_t;
+
+/*
+* Process a frame of the stream, it owns no reference: the frame is
+* unreferenced after it returns
+*   return 0 on success, -1 on failure, counted in nb_failed.
+*          Called by the producer(depth 0): non-zero if the frame is dropped
+*/
+typedef int (*fanout_process_t)(void *opaque, int stream, AVFrame *frame);
+
+typedef struct fanout_consumer_config_t {
+    const char       *name;     /*for the log and the thread*/
+    int              depth;     /*queued frames, 0: process is called by the producer,
+                                  it must not block, e.g. it queues the frame itself*/
+    fanout_policy_t  policy;
+    double           max_fps;   /*per stream, 0: all the frames*/
+    fanout_process_t process;
+    void             *opaque;
+} fanout_consumer_config_t;
+
+typedef struct fanout_stats_t {
+    const char *name;
+    int      depth;
+    int      occupancy;         /*frames waiting for the consumer*/
+    int      max_occupancy;
+
+    uint64_t nb_frames;         /*processed*/
+    uint64_t nb_limited;        /*skipped by max_fps*/
+    uint64_t nb_dropped;        /*the queue was full*/
+    uint64_t nb_failed;         /*process returned an error*/
+} fanout_stats_t;
+
+typedef struct frame_fanout_t frame_fanout_t;
+
+/*
+*   nb_streams: the stream index of frame_fanout_push() is below it
+*/
+frame_fanout_t *frame_fanout_create(int nb_streams);
+
+/*
+* Process the queued frames, stop the threads of the consumers and free the fan-out
+*/
+void frame_fanout_destroy(frame_fanout_t **fo);
+
+/*
+* Wait until the consumers have processed the queued frames, after the
+* last frame_fanout_push()
+*/
+void frame_fanout_flush(frame_fanout_t *fo);
+
+/*
+* Register a consumer and start its thread, before the first frame is pushed
+*   return the consumer index, -1 on failure
+*/
+int frame_fanout_add(frame_fanout_t *fo, const fanout_consumer_config_t *cfg);
+
+int frame_fanout_nb_consumers(frame_fanout_t *fo);
+
+/*
+* Run the threads of the consumers only on the cpus of the list like "0-3,6"
+*   return 0 on success, -1 on failure
+*/
+int frame_fanout_set_affinity(frame_fanout_t *fo, const char *cpus);
+
+/*
+* Queue a reference of the frame for every consumer, it never blocks and
+* never copies the picture. The frames of one stream are pushed by one
+* thread at a time, the streams may be pushed concurrently
+*   pts_us: of the frame for the rate limits, AV_NOPTS_VALUE: not limited
+*   return the number of consumers which dropped the frame or failed
+*/
+int frame_fanout_push(frame_fanout_t *fo, int stream, const AVFrame *frame, int64_t pts_us);
+
+/*
+* Safe from any thread
+*/
+void frame_fanout_get_stats(frame_fanout_t *fo, int index, fanout_stats_t *stats);
+
+const char *fanout_policy_name(fanout_policy_t policy);
+
+/*
+* "newest" or "oldest", FANOUT_POLICY_MAX if unknown
+*/
+fanout_policy_t fanout_policy_from_name(const char *name);
+
+#endif /* __FRAME_FANOUT_H_ */
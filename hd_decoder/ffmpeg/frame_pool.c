@@ -0,0 +1,421 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: frame_pool.c
+*
+* PURPOSE: per-stream pool of AVFrame shells and decoded picture buffers
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#include <libavutil/pixdesc.h>
+#include <libavutil/imgutils.h>
+
+#include "frame_pool.h"
+
+#define POOL_ALIGN      64
+/*the size of a buffer is kept in a header in front of the picture*/
+#define POOL_HEADER     POOL_ALIGN
+#define POOL_PADDING    (16 + POOL_ALIGN)
+
+typedef struct pic_geometry_t {
+    int format;
+    int width;
+    int height;
+
+    int nb_planes;
+    int linesize[4];
+    int offset[4];
+    int size;
+} pic_geometry_t;
+
+struct frame_pool_t {
+    pthread_mutex_t lock;
+    int             refs;       /*the owner and every buffer in use*/
+
+    AVFrame         **frames;   /*free shells*/
+    int             nb_free_frames;
+    int             max_frames;
+    int             nb_frames;
+    int             nb_frames_used;
+    int             max_frames_used;
+
+    pic_geometry_t  geo;
+    uint8_t         **buffers;  /*free pictures of geo.size*/
+    int             nb_free_buffers;
+    int             max_buffers;
+    int             nb_buffers;
+    int             nb_buffers_used;
+    int             max_buffers_used;
+    uint64_t        nb_buffer_allocs;
+    uint64_t        nb_fallbacks;
+};
+
+/*called with pool->lock held, return 1 when the last reference is gone*/
+static int unref_pool(frame_pool_t *pool) {
+    return --pool->refs == 0;
+}
+
+static void destroy_pool(frame_pool_t *pool) {
+    int i;
+
+    for (i = 0; i < pool->nb_free_frames; i++) {
+        av_frame_free(&pool->frames[i]);
+    }
+
+    for (i = 0; i < pool->nb_free_buffers; i++) {
+        free(pool->buffers[i] - POOL_HEADER);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->frames);
+    free(pool->buffers);
+    free(pool);
+}
+
+frame_pool_t *frame_pool_alloc(int max_frames, int max_buffers) {
+    frame_pool_t *pool;
+
+    pool = (frame_pool_t *)calloc(1, sizeof(frame_pool_t));
+    if (pool == NULL) {
+        printf("failed to malloc frame_pool_t\n");
+        return NULL;
+    }
+
+    pool->frames  = (AVFrame **)calloc(max_frames, sizeof(AVFrame *));
+    pool->buffers = (uint8_t **)calloc(max_buffers, sizeof(uint8_t *));
+    if (pool->frames == NULL || pool->buffers == NULL) {
+        printf("failed to malloc the frame pool(%d frames, %d buffers)\n",
+                max_frames, max_buffers);
+        free(pool->frames);
+        free(pool->buffers);
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pool->refs        = 1;
+    pool->max_frames  = max_frames;
+    pool->max_buffers = max_buffers;
+    pool->geo.format  = AV_PIX_FMT_NONE;
+
+    return pool;
+}
+
+void frame_pool_free(frame_pool_t **pool) {
+    int last;
+
+    if (!pool || !*pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&(*pool)->lock);
+    last = unref_pool(*pool);
+    pthread_mutex_unlock(&(*pool)->lock);
+
+    if (last) {
+        destroy_pool(*pool);
+    }
+    *pool = NULL;
+}
+
+AVFrame *frame_pool_get(frame_pool_t *pool) {
+    AVFrame *frame = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (pool->nb_free_frames > 0) {
+        frame = pool->frames[--pool->nb_free_frames];
+    }
+
+    pool->nb_frames_used++;
+    if (pool->nb_frames_used > pool->max_frames_used) {
+        pool->max_frames_used = pool->nb_frames_used;
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    if (!frame) {
+        frame = av_frame_alloc();
+        if (!frame) {
+            printf("failed to allocate AVFrame\n");
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        if (frame) {
+            pool->nb_frames++;
+        } else {
+            pool->nb_frames_used--;
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    return frame;
+}
+
+void frame_pool_put(frame_pool_t *pool, AVFrame **frame) {
+    if (!frame || !*frame) {
+        return;
+    }
+
+    av_frame_unref(*frame);
+
+    pthread_mutex_lock(&pool->lock);
+
+    pool->nb_frames_used--;
+    if (pool->nb_free_frames < pool->max_frames) {
+        pool->frames[pool->nb_free_frames++] = *frame;
+        *frame = NULL;
+    } else {
+        pool->nb_frames--;
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    av_frame_free(frame);
+}
+
+/*
+* The same layout as the default allocator: the dimensions are aligned
+* for the decoder and every plane starts on an aligned address
+*/
+static int get_geometry(AVCodecContext *avctx, int format, int width, int height,
+                        pic_geometry_t *geo) {
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+    int linesize_align[AV_NUM_DATA_POINTERS];
+    int w = width;
+    int h = height;
+    int plane_h;
+    int i;
+
+    if (!desc || (desc->flags & AV_PIX_FMT_FLAG_HWACCEL) || width <= 0 || height <= 0) {
+        return -1;
+    }
+
+    switch (format) {
+        case AV_PIX_FMT_YUV420P:
+        case AV_PIX_FMT_YUVJ420P:
+        case AV_PIX_FMT_YUV422P:
+        case AV_PIX_FMT_YUV444P:
+        case AV_PIX_FMT_NV12:
+        case AV_PIX_FMT_NV21:
+        case AV_PIX_FMT_GRAY8:
+            break;
+
+        default:
+            /*leave the other layouts to the default allocator*/
+            return -1;
+    }
+
+    avcodec_align_dimensions2(avctx, &w, &h, linesize_align);
+
+    memset(geo, 0, sizeof(pic_geometry_t));
+    geo->format = format;
+    geo->width  = width;
+    geo->height = height;
+
+    if (av_image_fill_linesizes(geo->linesize, format, w) < 0) {
+        return -1;
+    }
+
+    for (i = 0; i < desc->nb_components; i++) {
+        if (desc->comp[i].plane + 1 > geo->nb_planes) {
+            geo->nb_planes = desc->comp[i].plane + 1;
+        }
+    }
+
+    for (i = 0; i < geo->nb_planes; i++) {
+        geo->linesize[i] = FFALIGN(geo->linesize[i], POOL_ALIGN);
+        plane_h = (i == 1 || i == 2) ? -((-h) >> desc->log2_chroma_h) : h;
+
+        geo->offset[i] = geo->size;
+        geo->size += FFALIGN(geo->linesize[i] * plane_h, POOL_ALIGN);
+    }
+
+    geo->size += POOL_PADDING;
+
+    return 0;
+}
+
+static void release_buffer(void *opaque, uint8_t *data) {
+    frame_pool_t *pool = (frame_pool_t *)opaque;
+    int size = *(int *)(data - POOL_HEADER);
+    int last;
+
+    pthread_mutex_lock(&pool->lock);
+
+    pool->nb_buffers_used--;
+
+    /*the pictures of an old geometry are not reused*/
+    if (size == pool->geo.size && pool->nb_free_buffers < pool->max_buffers) {
+        pool->buffers[pool->nb_free_buffers++] = data;
+        data = NULL;
+    } else {
+        pool->nb_buffers--;
+    }
+
+    last = unref_pool(pool);
+
+    pthread_mutex_unlock(&pool->lock);
+
+    if (data) {
+        free(data - POOL_HEADER);
+    }
+
+    if (last) {
+        destroy_pool(pool);
+    }
+}
+
+static int pool_get_buffer2(AVCodecContext *avctx, AVFrame *frame, int flags) {
+    frame_pool_t *pool = (frame_pool_t *)avctx->opaque;
+    pic_geometry_t geo;
+    uint8_t *data = NULL;
+    uint8_t *raw;
+    int size;
+    int i;
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (frame->format != pool->geo.format ||
+        frame->width  != pool->geo.width ||
+        frame->height != pool->geo.height) {
+        if (get_geometry(avctx, frame->format, frame->width, frame->height, &geo) < 0) {
+            pool->nb_fallbacks++;
+            pthread_mutex_unlock(&pool->lock);
+            return avcodec_default_get_buffer2(avctx, frame, flags);
+        }
+
+        /*the stream changes its resolution*/
+        for (i = 0; i < pool->nb_free_buffers; i++) {
+            free(pool->buffers[i] - POOL_HEADER);
+        }
+        pool->nb_buffers -= pool->nb_free_buffers;
+        pool->nb_free_buffers = 0;
+        pool->geo = geo;
+    }
+
+    geo = pool->geo;
+
+    if (pool->nb_free_buffers > 0) {
+        data = pool->buffers[--pool->nb_free_buffers];
+    } else if (pool->nb_buffers >= pool->max_buffers) {
+        pool->nb_fallbacks++;
+        pthread_mutex_unlock(&pool->lock);
+        return avcodec_default_get_buffer2(avctx, frame, flags);
+    } else {
+        pool->nb_buffers++;
+        pool->nb_buffer_allocs++;
+    }
+
+    pool->nb_buffers_used++;
+    if (pool->nb_buffers_used > pool->max_buffers_used) {
+        pool->max_buffers_used = pool->nb_buffers_used;
+    }
+    pool->refs++;
+
+    pthread_mutex_unlock(&pool->lock);
+
+    if (!data) {
+        if (posix_memalign((void **)&raw, POOL_ALIGN, POOL_HEADER + geo.size)) {
+            raw = NULL;
+        } else {
+            *(int *)raw = geo.size;
+            data = raw + POOL_HEADER;
+        }
+    }
+
+    if (data) {
+        frame->buf[0] = av_buffer_create(data, geo.size, release_buffer, pool, 0);
+    }
+
+    if (!data || !frame->buf[0]) {
+        printf("failed to allocate the %dx%d picture buffer\n", geo.width, geo.height);
+
+        if (data) {
+            /*returns the picture to the pool and drops its reference*/
+            *(int *)(data - POOL_HEADER) = -1;
+            release_buffer(pool, data);
+        } else {
+            pthread_mutex_lock(&pool->lock);
+            pool->nb_buffers--;
+            pool->nb_buffers_used--;
+            pool->refs--;
+            pthread_mutex_unlock(&pool->lock);
+        }
+
+        return AVERROR(ENOMEM);
+    }
+
+    for (i = 0; i < geo.nb_planes; i++) {
+        frame->data[i]     = data + geo.offset[i];
+        frame->linesize[i] = geo.linesize[i];
+    }
+    frame->extended_data = frame->data;
+
+    return 0;
+}
+
+int frame_pool_attach(frame_pool_t *pool, AVCodecContext *avctx,
+                      const AVCodecParameters *par) {
+    pic_geometry_t geo;
+
+    if (!(avctx->codec->capabilities & AV_CODEC_CAP_DR1)) {
+        /*the decoder doesn't support custom allocators*/
+        return -1;
+    }
+
+    /*prepare the geometry of the stream, so the first picture is pooled*/
+    pthread_mutex_lock(&pool->lock);
+    if (get_geometry(avctx, par->format, par->width, par->height, &geo) == 0) {
+        pool->geo = geo;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    avctx->opaque      = pool;
+    avctx->get_buffer2 = pool_get_buffer2;
+
+    return 0;
+}
+
+void frame_pool_get_stats(frame_pool_t *pool, frame_pool_stats_t *stats) {
+    pthread_mutex_lock(&pool->lock);
+
+    stats->nb_frames        = pool->nb_frames;
+    stats->nb_frames_used   = pool->nb_frames_used;
+    stats->max_frames_used  = pool->max_frames_used;
+
+    stats->buffer_size      = pool->geo.size;
+    stats->nb_buffers       = pool->nb_buffers;
+    stats->nb_buffers_used  = pool->nb_buffers_used;
+    stats->max_buffers_used = pool->max_buffers_used;
+    stats->nb_buffer_allocs = pool->nb_buffer_allocs;
+    stats->nb_fallbacks     = pool->nb_fallbacks;
+
+    pthread_mutex_unlock(&pool->lock);
+}
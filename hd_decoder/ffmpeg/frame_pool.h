@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: frame_pool.h
+*
+* PURPOSE: per-stream pool of AVFrame shells and decoded picture buffers
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#ifndef __FRAME_POOL_H_
+#define __FRAME_POOL_H_
+
+#include <stdint.h>
+
+#include <libavcodec/avcodec.h>
+
+typedef struct frame_pool_stats_t {
+    /*AVFrame shells*/
+    int      nb_frames;          /*allocated*/
+    int      nb_frames_used;     /*got and not put back*/
+    int      max_frames_used;    /*high-water mark*/
+
+    /*picture buffers for the decoder*/
+    int      buffer_size;        /*bytes of one picture*/
+    int      nb_buffers;         /*allocated*/
+    int      nb_buffers_used;    /*referenced by frames*/
+    int      max_buffers_used;   /*high-water mark*/
+    uint64_t nb_buffer_allocs;   /*allocations since the start*/
+    uint64_t nb_fallbacks;       /*pictures allocated by avcodec_default_get_buffer2()*/
+} frame_pool_stats_t;
+
+typedef struct frame_pool_t frame_pool_t;
+
+/*
+* max_frames:  AVFrame shells kept for reuse
+* max_buffers: picture buffers, the decoder falls back to the default
+*              allocator when all of them are in use
+*/
+frame_pool_t *frame_pool_alloc(int max_frames, int max_buffers);
+
+/*
+* Drop the pool, the memory is freed when the last frame is unreferenced
+*/
+void frame_pool_free(frame_pool_t **pool);
+
+/*
+* Get an empty AVFrame, safe from any thread
+*/
+AVFrame *frame_pool_get(frame_pool_t *pool);
+
+/*
+* Unreference the frame and keep the shell for frame_pool_get()
+*/
+void frame_pool_put(frame_pool_t *pool, AVFrame **frame);
+
+/*
+* Let the decoder allocate its pictures from the pool: the buffers are
+* sized from par and avctx->get_buffer2 is replaced.
+* Must be called before avcodec_open2()
+*   return 0 if attached, -1 if the decoder does not support it
+*/
+int frame_pool_attach(frame_pool_t *pool, AVCodecContext *avctx,
+                      const AVCodecParameters *par);
+
+void frame_pool_get_stats(frame_pool_t *pool, frame_pool_stats_t *stats);
+
+#endif /* __FRAME_POOL_H_ */
@@ -0,0 +1,492 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: frame_shm.c
+*
+* PURPOSE: shared memory ring of decoded frames, one writer and lock-free
+*          readers in other processes
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Replace the ring by a bigger one for bigger frames
+************************************************************************/
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+
+#include "frame_shm.h"
+
+#define FRAMESHM_PAGE_SIZE 4096
+#define FRAMESHM_RETRIES   4    /*the writer lapped the reader while it looked*/
+
+#define ALIGN_UP(x, a) (((x) + (a) - 1) & ~((uint64_t)(a) - 1))
+
+typedef struct frame_shm_t {
+    char             name[256];
+    int              writer;
+    int              fd;
+
+    uint8_t          *base;
+    size_t           map_size;
+    FrameShmHeader_t *hdr;
+    FrameShmSlot_t   *slots;
+    uint64_t         slot_stride;   /*bytes between the picture data of 2 slots*/
+
+    uint64_t         seq;           /*writer: last published, reader: last got*/
+} frame_shm_t;
+
+static int pic_planes(int format, int width, int height, int *widths, int *heights) {
+    if (width <= 0 || height <= 0) {
+        return -1;
+    }
+
+    if (format == FRAMESHM_FMT_YUV420) {
+        widths[0]  = width;
+        heights[0] = height;
+        widths[1]  = widths[2]  = (width + 1) / 2;
+        heights[1] = heights[2] = (height + 1) / 2;
+        return 3;
+    } else if (format == FRAMESHM_FMT_NV12) {
+        widths[0]  = width;
+        heights[0] = height;
+        widths[1]  = (width + 1) / 2 * 2;
+        heights[1] = (height + 1) / 2;
+        return 2;
+    }
+
+    return -1;
+}
+
+static void make_shm_name(char *buf, int size, const char *name) {
+    /*POSIX shared memory objects are named "/name"*/
+    if (name[0] == '/') {
+        snprintf(buf, size, "%s", name);
+    } else {
+        snprintf(buf, size, "/%s", name);
+    }
+}
+
+static uint8_t *slot_data(frame_shm_t *s, FrameShmSlot_t *slot) {
+    return s->base + s->hdr->data_offset + (slot - s->slots) * s->slot_stride;
+}
+
+unsigned int FrameShmPicSize(FrameShmFormat_t format, int width, int height) {
+    int widths[FRAMESHM_MAX_PLANES];
+    int heights[FRAMESHM_MAX_PLANES];
+    unsigned int size = 0;
+    int nb_planes;
+    int i;
+
+    nb_planes = pic_planes(format, width, height, widths, heights);
+    for (i = 0; i < nb_planes; i++) {
+        size += widths[i] * heights[i];
+    }
+
+    return size;
+}
+
+static frame_shm_t *create_ring(const char *name, int nb_slots, unsigned int slot_size,
+                                uint32_t generation) {
+    frame_shm_t *s;
+
+    if (nb_slots <= 0 || slot_size == 0) {
+        printf("invalid frame shm ring: %d slots of %u bytes\n", nb_slots, slot_size);
+        return NULL;
+    }
+
+    s = (frame_shm_t *)calloc(1, sizeof(frame_shm_t));
+    if (s == NULL) {
+        printf("failed to malloc frame_shm_t\n");
+        return NULL;
+    }
+
+    make_shm_name(s->name, sizeof(s->name), name);
+    s->writer      = 1;
+    s->slot_stride = ALIGN_UP(slot_size, FRAMESHM_PAGE_SIZE);
+    s->map_size    = ALIGN_UP(sizeof(FrameShmHeader_t) + nb_slots * sizeof(FrameShmSlot_t),
+                              FRAMESHM_PAGE_SIZE) + nb_slots * s->slot_stride;
+
+    /*a ring left by a crashed writer is replaced, its readers keep the old one*/
+    shm_unlink(s->name);
+
+    s->fd = shm_open(s->name, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (s->fd < 0) {
+        printf("failed to create shared memory %s(error: %s)\n", s->name, strerror(errno));
+        free(s);
+        return NULL;
+    }
+
+    if (ftruncate(s->fd, s->map_size) < 0) {
+        printf("failed to resize shared memory %s to %zu bytes(error: %s)\n",
+                s->name, s->map_size, strerror(errno));
+        goto fail;
+    }
+
+    s->base = (uint8_t *)mmap(NULL, s->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, s->fd, 0);
+    if (s->base == MAP_FAILED) {
+        printf("failed to map shared memory %s(error: %s)\n", s->name, strerror(errno));
+        s->base = NULL;
+        goto fail;
+    }
+
+    s->hdr   = (FrameShmHeader_t *)s->base;
+    s->slots = (FrameShmSlot_t *)(s->base + sizeof(FrameShmHeader_t));
+
+    s->hdr->version     = FRAMESHM_VERSION;
+    s->hdr->nb_slots    = nb_slots;
+    s->hdr->slot_size   = slot_size;
+    s->hdr->data_offset = s->map_size - nb_slots * s->slot_stride;
+    s->hdr->generation  = generation;
+
+    /*the readers ignore the ring until the magic is there*/
+    __atomic_store_n(&s->hdr->magic, FRAMESHM_MAGIC, __ATOMIC_RELEASE);
+
+    return s;
+
+fail:
+    close(s->fd);
+    shm_unlink(s->name);
+    free(s);
+    return NULL;
+}
+
+FRAMESHM_HANDLE_t FrameShmCreate(const char *name, int nb_slots, unsigned int slot_size) {
+    return (FRAMESHM_HANDLE_t)create_ring(name, nb_slots, slot_size, 0);
+}
+
+int FrameShmResize(FRAMESHM_HANDLE_t handle, unsigned int slot_size) {
+    frame_shm_t *s = (frame_shm_t *)handle;
+    frame_shm_t *n;
+
+    /*the new ring takes the name, the readers find it once the old one is replaced*/
+    n = create_ring(s->name, s->hdr->nb_slots, slot_size, s->hdr->generation + 1);
+    if (n) {
+        __atomic_store_n(&s->hdr->replaced, 1, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&s->hdr->closed, 1, __ATOMIC_RELEASE);
+
+    if (!n) {
+        return -1;
+    }
+
+    munmap(s->base, s->map_size);
+    close(s->fd);
+    *s = *n;
+    free(n);
+
+    return 0;
+}
+
+int FrameShmPublish(FRAMESHM_HANDLE_t handle, const FrameShmPic_t *pic) {
+    frame_shm_t *s = (frame_shm_t *)handle;
+    int widths[FRAMESHM_MAX_PLANES];
+    int heights[FRAMESHM_MAX_PLANES];
+    FrameShmSlot_t *slot;
+    uint8_t *dst;
+    uint64_t n;
+    uint32_t offset = 0;
+    int nb_planes;
+    int i, j;
+
+    nb_planes = pic_planes(pic->format, pic->width, pic->height, widths, heights);
+    if (nb_planes < 0 ||
+        FrameShmPicSize(pic->format, pic->width, pic->height) > s->hdr->slot_size) {
+        return -1;
+    }
+
+    n    = s->seq + 1;
+    slot = &s->slots[(n - 1) % s->hdr->nb_slots];
+    dst  = slot_data(s, slot);
+
+    /*the readers of the previous frame in the slot see it is gone*/
+    __atomic_store_n(&slot->seq, 2 * n + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->pts           = pic->pts;
+    slot->time_base_num = pic->time_base_num;
+    slot->time_base_den = pic->time_base_den;
+    slot->width         = pic->width;
+    slot->height        = pic->height;
+    slot->format        = pic->format;
+
+    /*the planes are packed without stride padding*/
+    for (i = 0; i < FRAMESHM_MAX_PLANES; i++) {
+        if (i >= nb_planes) {
+            slot->linesize[i] = 0;
+            slot->offset[i]   = 0;
+            continue;
+        }
+
+        slot->linesize[i] = widths[i];
+        slot->offset[i]   = offset;
+
+        if (pic->linesize[i] == widths[i]) {
+            memcpy(dst + offset, pic->data[i], (size_t)widths[i] * heights[i]);
+        } else {
+            for (j = 0; j < heights[i]; j++) {
+                memcpy(dst + offset + j * widths[i],
+                       pic->data[i] + (ptrdiff_t)j * pic->linesize[i],
+                       widths[i]);
+            }
+        }
+
+        offset += widths[i] * heights[i];
+    }
+    slot->size = offset;
+
+    __atomic_store_n(&slot->seq, 2 * n, __ATOMIC_RELEASE);
+    __atomic_store_n(&s->hdr->latest, n, __ATOMIC_RELEASE);
+    s->seq = n;
+
+    return 0;
+}
+
+FRAMESHM_HANDLE_t FrameShmOpen(const char *name) {
+    frame_shm_t *s;
+    struct stat st;
+    uint64_t data_size;
+
+    s = (frame_shm_t *)calloc(1, sizeof(frame_shm_t));
+    if (s == NULL) {
+        printf("failed to malloc frame_shm_t\n");
+        return NULL;
+    }
+
+    make_shm_name(s->name, sizeof(s->name), name);
+
+    s->fd = shm_open(s->name, O_RDONLY, 0);
+    if (s->fd < 0) {
+        free(s);
+        return NULL;
+    }
+
+    if (fstat(s->fd, &st) < 0 || st.st_size < (off_t)sizeof(FrameShmHeader_t)) {
+        goto fail;
+    }
+
+    s->map_size = st.st_size;
+    s->base = (uint8_t *)mmap(NULL, s->map_size, PROT_READ, MAP_SHARED, s->fd, 0);
+    if (s->base == MAP_FAILED) {
+        printf("failed to map shared memory %s(error: %s)\n", s->name, strerror(errno));
+        s->base = NULL;
+        goto fail;
+    }
+
+    s->hdr = (FrameShmHeader_t *)s->base;
+    if (__atomic_load_n(&s->hdr->magic, __ATOMIC_ACQUIRE) != FRAMESHM_MAGIC) {
+        /*not initialized yet*/
+        goto fail;
+    }
+
+    if (s->hdr->version != FRAMESHM_VERSION || s->hdr->nb_slots == 0) {
+        printf("unsupported frame shm ring %s(version %u)\n", s->name, s->hdr->version);
+        goto fail;
+    }
+
+    s->slots       = (FrameShmSlot_t *)(s->base + sizeof(FrameShmHeader_t));
+    s->slot_stride = ALIGN_UP(s->hdr->slot_size, FRAMESHM_PAGE_SIZE);
+    data_size      = s->hdr->nb_slots * s->slot_stride;
+    if (s->hdr->data_offset < sizeof(FrameShmHeader_t) + s->hdr->nb_slots * sizeof(FrameShmSlot_t) ||
+        s->hdr->data_offset + data_size > s->map_size) {
+        printf("corrupt frame shm ring %s\n", s->name);
+        goto fail;
+    }
+
+    return (FRAMESHM_HANDLE_t)s;
+
+fail:
+    if (s->base) {
+        munmap(s->base, s->map_size);
+    }
+    close(s->fd);
+    free(s);
+    return NULL;
+}
+
+/*
+* Snapshot the slot of the latest frame into pic,
+*   return the slot, NULL if there is no new frame
+*/
+static FrameShmSlot_t *peek_latest(frame_shm_t *s, FrameShmPic_t *pic) {
+    int widths[FRAMESHM_MAX_PLANES];
+    int heights[FRAMESHM_MAX_PLANES];
+    FrameShmSlot_t *slot;
+    uint64_t n;
+    int retry;
+    int i;
+
+    for (retry = 0; retry < FRAMESHM_RETRIES; retry++) {
+        n = __atomic_load_n(&s->hdr->latest, __ATOMIC_ACQUIRE);
+        if (n == 0 || n == s->seq) {
+            return NULL;
+        }
+
+        slot = &s->slots[(n - 1) % s->hdr->nb_slots];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != 2 * n) {
+            continue;
+        }
+
+        pic->seq           = n;
+        pic->generation    = s->hdr->generation;
+        pic->pts           = slot->pts;
+        pic->time_base_num = slot->time_base_num;
+        pic->time_base_den = slot->time_base_den;
+        pic->width         = slot->width;
+        pic->height        = slot->height;
+        pic->format        = slot->format;
+        pic->size          = slot->size;
+        for (i = 0; i < FRAMESHM_MAX_PLANES; i++) {
+            pic->linesize[i] = slot->linesize[i];
+            pic->data[i]     = slot_data(s, slot) + slot->offset[i];
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != 2 * n) {
+            continue;
+        }
+
+        /*the snapshot is consistent, but do not trust it blindly*/
+        if (pic_planes(pic->format, pic->width, pic->height, widths, heights) < 0 ||
+            pic->size > s->hdr->slot_size) {
+            return NULL;
+        }
+
+        return slot;
+    }
+
+    return NULL;
+}
+
+/*
+* Move to the ring which replaced this one under the name, the frames left
+* in the old one are older than the ones to come
+*/
+static void follow_ring(frame_shm_t *s) {
+    frame_shm_t *n;
+
+    if (!__atomic_load_n(&s->hdr->replaced, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    n = (frame_shm_t *)FrameShmOpen(s->name);
+    if (!n) {
+        return;
+    }
+    if (n->hdr->generation == s->hdr->generation) {
+        FrameShmRelease((FRAMESHM_HANDLE_t)n);
+        return;
+    }
+
+    munmap(s->base, s->map_size);
+    close(s->fd);
+    *s = *n;
+    free(n);
+}
+
+int FrameShmPeekLatest(FRAMESHM_HANDLE_t handle, FrameShmPic_t *pic) {
+    frame_shm_t *s = (frame_shm_t *)handle;
+
+    follow_ring(s);
+
+    if (!peek_latest(s, pic)) {
+        return __atomic_load_n(&s->hdr->closed, __ATOMIC_ACQUIRE) ? -1 : 1;
+    }
+
+    s->seq = pic->seq;
+
+    return 0;
+}
+
+int FrameShmCheck(FRAMESHM_HANDLE_t handle, const FrameShmPic_t *pic) {
+    frame_shm_t *s = (frame_shm_t *)handle;
+    FrameShmSlot_t *slot = &s->slots[(pic->seq - 1) % s->hdr->nb_slots];
+
+    if (pic->generation != s->hdr->generation) {
+        return -1;
+    }
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == 2 * pic->seq ? 0 : -1;
+}
+
+int FrameShmReadLatest(FRAMESHM_HANDLE_t handle, FrameShmPic_t *pic,
+                       void *buf, unsigned int size) {
+    frame_shm_t *s = (frame_shm_t *)handle;
+    FrameShmSlot_t *slot;
+    uint8_t *src;
+    int retry;
+    int i;
+
+    follow_ring(s);
+
+    for (retry = 0; retry < FRAMESHM_RETRIES; retry++) {
+        slot = peek_latest(s, pic);
+        if (!slot) {
+            break;
+        }
+
+        if (pic->size > size) {
+            printf("buffer of %u bytes is too small for the %u bytes frame\n", size, pic->size);
+            return -1;
+        }
+
+        src = slot_data(s, slot);
+        memcpy(buf, src, pic->size);
+
+        if (FrameShmCheck(handle, pic) == 0) {
+            for (i = 0; i < FRAMESHM_MAX_PLANES; i++) {
+                pic->data[i] = (uint8_t *)buf + (pic->data[i] - src);
+            }
+
+            s->seq = pic->seq;
+            return 0;
+        }
+    }
+
+    return __atomic_load_n(&s->hdr->closed, __ATOMIC_ACQUIRE) ? -1 : 1;
+}
+
+void FrameShmRelease(FRAMESHM_HANDLE_t handle) {
+    frame_shm_t *s = (frame_shm_t *)handle;
+
+    if (!s) {
+        return;
+    }
+
+    if (s->writer) {
+        __atomic_store_n(&s->hdr->closed, 1, __ATOMIC_RELEASE);
+        shm_unlink(s->name);
+    }
+
+    munmap(s->base, s->map_size);
+    close(s->fd);
+    free(s);
+}
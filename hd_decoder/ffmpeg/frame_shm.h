@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: frame_shm.h
+*
+* PURPOSE: header file of the shared memory ring of decoded frames,
+*          ffmpeg_hd_decoder publishes the frames and any number of
+*          processes read them with libframeshm.so
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Replace the ring by a bigger one for bigger frames
+************************************************************************/
+
+#ifndef __FRAME_SHM_H_
+#define __FRAME_SHM_H_
+
+#include <sys/cdefs.h>
+#include <stdint.h>
+
+__BEGIN_DECLS
+
+#ifndef FRAMESHM_IN
+#define FRAMESHM_IN
+#endif
+
+#ifndef FRAMESHM_OUT
+#define FRAMESHM_OUT
+#endif
+
+#define FRAMESHM_MAGIC      0x4D485346  /*"FSHM"*/
+#define FRAMESHM_VERSION    1
+#define FRAMESHM_MAX_PLANES 3
+
+typedef void* FRAMESHM_HANDLE_t;
+
+typedef enum {
+    FRAMESHM_FMT_YUV420 = 0,  // YYYY.....U....V...
+    FRAMESHM_FMT_NV12,        // YYYY.....UV....
+
+    FRAMESHM_FMT_MAX
+} FrameShmFormat_t;
+
+/*
+Layout of the shared memory object "/name":
+
+    FrameShmHeader_t                    64 bytes
+    FrameShmSlot_t[nb_slots]            64 bytes each
+    picture data of slot 0              slot_size bytes, from data_offset
+    picture data of slot 1 ...          page aligned
+
+Frame n(1, 2, 3...) is written in slot (n - 1) % nb_slots. The slot is
+guarded by its seq like a seqlock: it is 2n + 1 while the writer copies
+frame n and 2n once the frame is complete, the reader checks seq did not
+change after it has read the frame. header.latest is n after frame n is
+complete. seq and latest are accessed atomically.
+
+A frame bigger than slot_size makes the writer create a new ring of the
+same name with the next generation, then set replaced and closed in the
+old one. The readers of libframeshm.so move to the new ring by themselves.
+*/
+typedef struct _FrameShmHeader_t {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nb_slots;
+    uint32_t slot_size;      /*bytes of picture data in one slot*/
+    uint64_t data_offset;    /*picture data of slot 0*/
+    uint64_t latest;         /*number of the latest complete frame, 0: none yet*/
+    uint32_t closed;         /*the writer stopped, no more frames*/
+    uint32_t generation;     /*of the rings created under the name by the writer*/
+    uint32_t replaced;       /*a ring of the next generation took the name*/
+    uint32_t reserved[5];
+} FrameShmHeader_t;
+
+typedef struct _FrameShmSlot_t {
+    uint64_t seq;
+    int64_t  pts;
+    int32_t  time_base_num;
+    int32_t  time_base_den;
+    int32_t  width;
+    int32_t  height;
+    int32_t  format;         /*FrameShmFormat_t*/
+    int32_t  linesize[FRAMESHM_MAX_PLANES];
+    uint32_t offset[FRAMESHM_MAX_PLANES]; /*of the planes in the slot data*/
+    uint32_t size;           /*bytes of the picture*/
+} FrameShmSlot_t;
+
+typedef struct _FrameShmPic_t {
+    uint64_t         seq;    /*frame number*/
+    uint32_t         generation;   /*of the ring*/
+    int64_t          pts;
+    int              time_base_num;
+    int              time_base_den;
+    int              width;
+    int              height;
+    FrameShmFormat_t format;
+
+    uint8_t          *data[FRAMESHM_MAX_PLANES];
+    int              linesize[FRAMESHM_MAX_PLANES];
+    unsigned int     size;
+} FrameShmPic_t;
+
+/*
+* Bytes of a picture without stride padding, the slot_size for it
+*/
+unsigned int FrameShmPicSize(FRAMESHM_IN FrameShmFormat_t format,
+                             FRAMESHM_IN int width,
+                             FRAMESHM_IN int height);
+
+/*
+* Writer: create the ring, slot_size is the max bytes of one picture.
+* An existing ring of the same name is replaced
+*/
+FRAMESHM_HANDLE_t FrameShmCreate(FRAMESHM_IN const char *name,
+                                 FRAMESHM_IN int nb_slots,
+                                 FRAMESHM_IN unsigned int slot_size);
+
+/*
+* Writer: copy the picture into the next slot and publish it,
+*   pic->data/linesize: the source planes, pic->seq and pic->size are ignored
+*   return 0 on success, -1 if the picture does not fit in the slot
+*/
+int FrameShmPublish(FRAMESHM_IN FRAMESHM_HANDLE_t handle,
+                    FRAMESHM_IN const FrameShmPic_t *pic);
+
+/*
+* Writer: replace the ring by one of the next generation with slots of
+* slot_size bytes, the handle stays valid. The ring is closed on failure
+*   return 0 on success, -1 on failure
+*/
+int FrameShmResize(FRAMESHM_IN FRAMESHM_HANDLE_t handle,
+                   FRAMESHM_IN unsigned int slot_size);
+
+/*
+* Reader: map the ring created by the writer
+*   return NULL if it does not exist(yet)
+*/
+FRAMESHM_HANDLE_t FrameShmOpen(FRAMESHM_IN const char *name);
+
+/*
+* Reader: get the latest frame without copying it,
+*   pic->data points into the ring: call FrameShmCheck() after using it,
+*   the writer may have overwritten the slot meanwhile. The reader follows
+*   a replaced ring here, the frames got from the old one are invalid then.
+*   return 0 for a new frame, 1 if there is no new frame since the last call,
+*          -1 if the writer stopped
+*/
+int FrameShmPeekLatest(FRAMESHM_IN  FRAMESHM_HANDLE_t handle,
+                       FRAMESHM_OUT FrameShmPic_t *pic);
+
+/*
+* Reader: return 0 if the frame got by FrameShmPeekLatest() is still intact,
+*         -1 if the writer has reused its slot
+*/
+int FrameShmCheck(FRAMESHM_IN FRAMESHM_HANDLE_t handle,
+                  FRAMESHM_IN const FrameShmPic_t *pic);
+
+/*
+* Reader: copy the latest frame into buf of size bytes,
+*   pic->data points into buf.
+*   return as FrameShmPeekLatest(), -1 also if buf is too small
+*/
+int FrameShmReadLatest(FRAMESHM_IN  FRAMESHM_HANDLE_t handle,
+                       FRAMESHM_OUT FrameShmPic_t *pic,
+                       FRAMESHM_IN  void *buf,
+                       FRAMESHM_IN  unsigned int size);
+
+/*
+* Writer: mark the ring closed and unlink it, the readers keep their mapping
+* Reader: unmap the ring
+*/
+void FrameShmRelease(FRAMESHM_IN FRAMESHM_HANDLE_t handle);
+
+__END_DECLS
+
+#endif /* __FRAME_SHM_H_ */
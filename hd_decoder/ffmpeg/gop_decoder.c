@@ -0,0 +1,975 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: gop_decoder.c
+*
+* PURPOSE: decode a local file on several decoders at the same time,
+*          split into segments at the keyframes
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Output path patterns are not used as printf formats
+************************************************************************/
+
+/*
+example:
+decode a recording on 8 decoders, the frames are written in pts order:
+./gop_decoder -i record.mp4 -j 8 -o record.yuv
+
+segments of 10 GOPs, written into a file per segment:
+./gop_decoder -i record.mp4 -j 8 -g 10 -o record_%d.yuv
+
+decode only, to measure the throughput:
+./gop_decoder -i record.mp4 -j 8
+
+The keyframes are taken from the index of the container (mp4, ...), or
+found by one demux pass when the index is missing or does not match the
+packets (raw H.264/HEVC, ts, ...). Every decoder takes the next segment,
+seeks to its first keyframe and decodes up to the first keyframe of the
+next segment. The leading pictures after that keyframe, which are shown
+before it (open GOP), are decoded too: every frame is output by the
+segment which its pts falls into.
+
+With one output file, the frames of a segment are written when all the
+segments before it are written, the others are kept in memory up to -m
+megabytes; a decoder waits when it is full.
+*/
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+
+#include "dec_backend.h"
+#include "path_pattern.h"
+
+#define MAX_INSTANCES      64
+#define SEGMENT_PER_DECODER 4   /*segments per decoder when -g is not set, to balance the load*/
+#define QUEUE_MB           1024 /*frames kept for the ordered output*/
+
+typedef struct key_entry_t {
+    int64_t pos;        /*byte position of the keyframe packet, -1: unknown*/
+    int64_t ts;         /*to seek to it, and to find it if pos is unknown*/
+} key_entry_t;
+
+typedef struct segment_t {
+    int      index;
+    int      key;           /*first keyframe, in gop_t.keys*/
+    int      end_key;       /*first keyframe of the next segment, nb_keys for the last one*/
+
+    /*frames decoded before all the segments in front are written, only
+      the decoder of the segment uses them until it is done*/
+    AVFrame  **frames;
+    int      nb_queued;
+    int      size;
+    int64_t  queued_bytes;
+
+    int      done;
+    int      failed;
+    uint64_t nb_frames;
+    int64_t  elapsed_us;
+} segment_t;
+
+typedef struct gop_t gop_t;
+
+typedef struct instance_t {
+    int             id;
+    gop_t           *gop;
+    pthread_t       thread;
+
+    AVFormatContext *ctx;
+    AVCodecContext  *avctx;
+    AVPacket        *pkt;
+    AVFrame         *frame;
+    uint8_t         *buf;         /*picture being written*/
+    int             buf_size;
+
+    int64_t         start_pts;    /*frames of the segment being decoded*/
+    int64_t         end_pts;
+
+    int             nb_segments;
+    uint64_t        nb_frames;
+    uint64_t        nb_errors;
+    int64_t         busy_us;
+    int             failed;
+} instance_t;
+
+struct gop_t {
+    const char           *path;
+    const char           *output;     /*file or pattern with %d, NULL: no output*/
+    int                  per_segment; /*output is a pattern*/
+    int                  fd;          /*ordered output*/
+
+    int                  vstrm_index;
+    AVCodecParameters    *par;
+    key_entry_t          *keys;
+    int                  nb_keys;
+    int                  demux_pass;  /*the keyframes are not from the container index*/
+    int                  gops;        /*per segment*/
+
+    segment_t            *segments;
+    int                  nb_segments;
+
+    instance_t           instances[MAX_INSTANCES];
+    int                  nb_instances;
+    dec_backend_config_t backend;
+
+    /*segments, ordered output*/
+    pthread_mutex_t      lock;
+    pthread_cond_t       cond;
+    int                  next_segment;  /*taken by the next decoder*/
+    int                  head;          /*first segment not written*/
+    int                  advancing;     /*a decoder writes the done segments*/
+    int64_t              queued_bytes;
+    int64_t              max_queued_bytes;
+    int                  write_failed;
+};
+
+
+static void usage(char *programname)
+{
+    printf("%s (compiled %s)\n", programname, __DATE__);
+    printf(("Usage %s [OPTION]\n"
+        " -i <video file>                        : H.264/HEVC file\n"
+        " -j <number of decoders>(default: cpus) : segments decoded at the same time\n"
+        " -g <GOPs>                              : GOPs per segment, default: %d segments per decoder\n"
+        " -o <yuv file>                          : output file in pts order, a pattern with %%d for a file per segment\n"
+        " -m <megabytes>(default: %d)          : frames kept in memory for the ordered output\n"
+        " -b <auto/hw/sw>(default: auto)         : decoder backend\n"
+        " -H <number of decoders>                : max hardware decoders, the others use software in auto mode\n"
+        " -n <number of threads>(default: 1)     : threads of a software decoder, 0: number of cpu cores\n"
+        " -x <frame/slice>                       : threading of a software decoder\n"
+        " -h, --help                             : print this help and exit\n"),
+        programname, SEGMENT_PER_DECODER, QUEUE_MB);
+}
+
+static int64_t get_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t packet_ts(const AVPacket *pkt) {
+    return pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+}
+
+/*
+* return <0 if the packet is before the keyframe, 0 if it is the keyframe, >0 after it
+*/
+static int key_order(const AVPacket *pkt, const key_entry_t *key) {
+    int64_t ts;
+
+    if (key->pos >= 0 && pkt->pos >= 0) {
+        return pkt->pos < key->pos ? -1 : pkt->pos > key->pos;
+    }
+
+    ts = packet_ts(pkt);
+    if (ts == AV_NOPTS_VALUE || key->ts == AV_NOPTS_VALUE) {
+        return -1;
+    }
+
+    return ts < key->ts ? -1 : ts > key->ts;
+}
+
+static int open_file(const char *path, AVFormatContext **ctx) {
+    int ret;
+
+    ret = avformat_open_input(ctx, path, NULL, NULL);
+    if (ret < 0) {
+        printf("%s: avformat_open_input() -- Failure(%s)!\n", path, av_err2str(ret));
+        return -1;
+    }
+
+    ret = avformat_find_stream_info(*ctx, NULL);
+    if (ret < 0) {
+        printf("%s: could not find codec parameters\n", path);
+        avformat_close_input(ctx);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+* Read the next packet of the video stream
+*/
+static int read_video_packet(AVFormatContext *ctx, int vstrm_index, AVPacket *pkt) {
+    int ret;
+
+    for (;;) {
+        ret = av_read_frame(ctx, pkt);
+        if (ret < 0) {
+            return ret;
+        }
+        if (pkt->stream_index == vstrm_index) {
+            return 0;
+        }
+        av_packet_unref(pkt);
+    }
+}
+
+static int add_key(gop_t *gop, int *size, int64_t pos, int64_t ts) {
+    key_entry_t *keys;
+
+    if (gop->nb_keys == *size) {
+        *size = *size ? *size * 2 : 1024;
+        keys = (key_entry_t *)realloc(gop->keys, *size * sizeof(key_entry_t));
+        if (keys == NULL) {
+            printf("failed to malloc %d keyframes\n", *size);
+            return -1;
+        }
+        gop->keys = keys;
+    }
+
+    gop->keys[gop->nb_keys].pos = pos;
+    gop->keys[gop->nb_keys].ts  = ts;
+    gop->nb_keys++;
+
+    return 0;
+}
+
+/*
+* Keyframes of the container index, if the first keyframe packet is found in it
+*/
+static int index_keys(gop_t *gop, AVFormatContext *ctx) {
+    AVStream *st = ctx->streams[gop->vstrm_index];
+    AVPacket pkt;
+    int size = 0;
+    int found = 0;
+    int i;
+
+    for (i = 0; i < st->nb_index_entries; i++) {
+        if (st->index_entries[i].flags & AVINDEX_KEYFRAME) {
+            if (add_key(gop, &size, st->index_entries[i].pos, st->index_entries[i].timestamp)) {
+                return -1;
+            }
+        }
+    }
+
+    if (gop->nb_keys < 2) {
+        gop->nb_keys = 0;
+        return 0;
+    }
+
+    /*the index of some containers points at clusters or pages, not at the packets*/
+    av_init_packet(&pkt);
+    while (read_video_packet(ctx, gop->vstrm_index, &pkt) == 0) {
+        if (pkt.flags & AV_PKT_FLAG_KEY) {
+            for (i = 0; i < gop->nb_keys && !found; i++) {
+                found = pkt.pos >= 0 && gop->keys[i].pos == pkt.pos;
+            }
+            av_packet_unref(&pkt);
+            break;
+        }
+        av_packet_unref(&pkt);
+    }
+
+    if (!found) {
+        gop->nb_keys = 0;
+    }
+
+    return 0;
+}
+
+/*
+* Keyframes found by reading all the packets, without decoding them
+*/
+static int demux_keys(gop_t *gop, AVFormatContext *ctx) {
+    AVPacket pkt;
+    int size = 0;
+    int ret;
+
+    gop->nb_keys = 0;
+    gop->demux_pass = 1;
+
+    av_init_packet(&pkt);
+    while ((ret = read_video_packet(ctx, gop->vstrm_index, &pkt)) == 0) {
+        if ((pkt.flags & AV_PKT_FLAG_KEY) && add_key(gop, &size, pkt.pos, packet_ts(&pkt))) {
+            av_packet_unref(&pkt);
+            return -1;
+        }
+        av_packet_unref(&pkt);
+    }
+
+    if (ret != AVERROR_EOF) {
+        printf("%s: failed to read the packets(%s)\n", gop->path, av_err2str(ret));
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+* Find the video stream and the keyframes, and split the file into segments
+*/
+static int build_segments(gop_t *gop) {
+    AVFormatContext *ctx = NULL;
+    int64_t start_us = get_time_us();
+    int gops = gop->gops;
+    int i;
+
+    if (open_file(gop->path, &ctx)) {
+        return -1;
+    }
+
+    gop->vstrm_index = -1;
+    for (i = 0; i < ctx->nb_streams; i++) {
+        if (ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            gop->vstrm_index = i;
+            break;
+        }
+    }
+
+    if (gop->vstrm_index < 0) {
+        printf("%s: no video stream\n", gop->path);
+        avformat_close_input(&ctx);
+        return -1;
+    }
+
+    gop->par = avcodec_parameters_alloc();
+    if (!gop->par ||
+        avcodec_parameters_copy(gop->par, ctx->streams[gop->vstrm_index]->codecpar) < 0) {
+        printf("failed to copy the codec parameters\n");
+        avformat_close_input(&ctx);
+        return -1;
+    }
+
+    if (index_keys(gop, ctx) || (!gop->nb_keys && demux_keys(gop, ctx))) {
+        avformat_close_input(&ctx);
+        return -1;
+    }
+    avformat_close_input(&ctx);
+
+    if (!gop->nb_keys) {
+        printf("%s: no keyframe\n", gop->path);
+        return -1;
+    }
+
+    if (!gops) {
+        gops = (gop->nb_keys + gop->nb_instances * SEGMENT_PER_DECODER - 1) /
+               (gop->nb_instances * SEGMENT_PER_DECODER);
+    }
+
+    gop->nb_segments = (gop->nb_keys + gops - 1) / gops;
+    gop->segments = (segment_t *)calloc(gop->nb_segments, sizeof(segment_t));
+    if (gop->segments == NULL) {
+        printf("failed to malloc %d segments\n", gop->nb_segments);
+        return -1;
+    }
+
+    for (i = 0; i < gop->nb_segments; i++) {
+        gop->segments[i].index   = i;
+        gop->segments[i].key     = i * gops;
+        gop->segments[i].end_key = FFMIN((i + 1) * gops, gop->nb_keys);
+    }
+
+    printf("%s: %s %dx%d, %d keyframes from the %s in %.2fs, %d segments of %d GOPs\n",
+            gop->path, avcodec_get_name(gop->par->codec_id), gop->par->width, gop->par->height,
+            gop->nb_keys, gop->demux_pass ? "demux pass" : "container index",
+            (get_time_us() - start_us) / 1000000.0, gop->nb_segments, gops);
+
+    return 0;
+}
+
+static int write_frame(instance_t *inst, int fd, const AVFrame *frame) {
+    int size = av_image_get_buffer_size((enum AVPixelFormat)frame->format,
+                                        frame->width, frame->height, 1);
+    uint8_t *buf;
+    int done = 0;
+    int ret;
+
+    if (size <= 0) {
+        printf("[%d] pixel format %d is not supported\n", inst->id, frame->format);
+        return -1;
+    }
+
+    if (size > inst->buf_size) {
+        buf = (uint8_t *)realloc(inst->buf, size);
+        if (buf == NULL) {
+            printf("[%d] failed to malloc %d bytes\n", inst->id, size);
+            return -1;
+        }
+        inst->buf      = buf;
+        inst->buf_size = size;
+    }
+
+    av_image_copy_to_buffer(inst->buf, size, (const uint8_t * const *)frame->data, frame->linesize,
+                            (enum AVPixelFormat)frame->format, frame->width, frame->height, 1);
+
+    while (done < size) {
+        ret = write(fd, inst->buf + done, size - done);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            printf("[%d] failed to write the frame(error: %s)\n", inst->id, strerror(errno));
+            return -1;
+        }
+        done += ret;
+    }
+
+    return 0;
+}
+
+static void write_queued(instance_t *inst, segment_t *seg) {
+    gop_t *gop = inst->gop;
+    int failed = 0;
+    int i;
+
+    for (i = 0; i < seg->nb_queued; i++) {
+        if (!failed && write_frame(inst, gop->fd, seg->frames[i])) {
+            failed = 1;
+        }
+        av_frame_free(&seg->frames[i]);
+    }
+    seg->nb_queued = 0;
+
+    pthread_mutex_lock(&gop->lock);
+    gop->queued_bytes -= seg->queued_bytes;
+    gop->write_failed |= failed;
+    pthread_cond_broadcast(&gop->cond);
+    pthread_mutex_unlock(&gop->lock);
+
+    seg->queued_bytes = 0;
+}
+
+/*
+* Write the frame if all the segments in front are written, or keep it
+*/
+static int output_frame(instance_t *inst, segment_t *seg, AVFrame *frame) {
+    gop_t *gop = inst->gop;
+    int64_t bytes = (int64_t)frame->width * frame->height * 3 / 2;
+    AVFrame **frames;
+    int head;
+
+    pthread_mutex_lock(&gop->lock);
+    while (gop->head != seg->index && gop->queued_bytes + bytes > gop->max_queued_bytes &&
+           !gop->write_failed) {
+        pthread_cond_wait(&gop->cond, &gop->lock);
+    }
+    if (gop->write_failed) {
+        pthread_mutex_unlock(&gop->lock);
+        return -1;
+    }
+    head = gop->head == seg->index;
+    if (!head) {
+        gop->queued_bytes += bytes;
+    }
+    pthread_mutex_unlock(&gop->lock);
+
+    if (head) {
+        if (seg->nb_queued) {
+            write_queued(inst, seg);
+        }
+        if (write_frame(inst, gop->fd, frame)) {
+            pthread_mutex_lock(&gop->lock);
+            gop->write_failed = 1;
+            pthread_cond_broadcast(&gop->cond);
+            pthread_mutex_unlock(&gop->lock);
+            return -1;
+        }
+        return 0;
+    }
+
+    if (seg->nb_queued == seg->size) {
+        seg->size = seg->size ? seg->size * 2 : 64;
+        frames = (AVFrame **)realloc(seg->frames, seg->size * sizeof(AVFrame *));
+        if (frames == NULL) {
+            printf("[%d] failed to malloc %d frames\n", inst->id, seg->size);
+            return -1;
+        }
+        seg->frames = frames;
+    }
+
+    seg->frames[seg->nb_queued] = av_frame_clone(frame);
+    if (!seg->frames[seg->nb_queued]) {
+        return -1;
+    }
+    seg->nb_queued++;
+    seg->queued_bytes += bytes;
+
+    return 0;
+}
+
+/*
+* Write the done segments from the head, by one decoder at a time
+*/
+static void finish_segment(instance_t *inst, segment_t *seg) {
+    gop_t *gop = inst->gop;
+    segment_t *head;
+
+    pthread_mutex_lock(&gop->lock);
+    seg->done = 1;
+    if (!gop->advancing) {
+        gop->advancing = 1;
+        while (gop->head < gop->nb_segments && gop->segments[gop->head].done) {
+            head = &gop->segments[gop->head];
+            if (head->nb_queued) {
+                pthread_mutex_unlock(&gop->lock);
+                write_queued(inst, head);
+                pthread_mutex_lock(&gop->lock);
+            }
+            gop->head++;
+        }
+        gop->advancing = 0;
+        pthread_cond_broadcast(&gop->cond);
+    }
+    pthread_mutex_unlock(&gop->lock);
+}
+
+static int segment_frame(instance_t *inst, segment_t *seg, int fd) {
+    AVFrame *frame = inst->frame;
+    int64_t pts = frame->best_effort_timestamp;
+
+    /*shown before the keyframe of the segment, or after the next one*/
+    if (pts != AV_NOPTS_VALUE &&
+        ((inst->start_pts != AV_NOPTS_VALUE && pts < inst->start_pts) ||
+         (inst->end_pts != AV_NOPTS_VALUE && pts >= inst->end_pts))) {
+        return 0;
+    }
+
+    seg->nb_frames++;
+    inst->nb_frames++;
+
+    if (fd >= 0) {
+        return write_frame(inst, fd, frame);
+    } else if (inst->gop->fd >= 0) {
+        return output_frame(inst, seg, frame);
+    }
+
+    return 0;
+}
+
+static int receive_frames(instance_t *inst, segment_t *seg, int fd) {
+    int ret;
+
+    for (;;) {
+        ret = avcodec_receive_frame(inst->avctx, inst->frame);
+        if (ret < 0) {
+            if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+                inst->nb_errors++;
+            }
+            return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF ? 0 : ret;
+        }
+
+        ret = segment_frame(inst, seg, fd);
+        av_frame_unref(inst->frame);
+        if (ret < 0) {
+            return -1;
+        }
+    }
+}
+
+static int send_packet(instance_t *inst, segment_t *seg, AVPacket *pkt, int fd) {
+    int ret;
+
+    for (;;) {
+        ret = avcodec_send_packet(inst->avctx, pkt);
+        if (ret != AVERROR(EAGAIN)) {
+            break;
+        }
+        /*the decoder has frames to output before it takes the packet*/
+        if (receive_frames(inst, seg, fd) < 0) {
+            return -1;
+        }
+    }
+
+    if (ret < 0 && ret != AVERROR_EOF) {
+        inst->nb_errors++;
+    }
+
+    return receive_frames(inst, seg, fd);
+}
+
+/*
+* Seek to the first keyframe of the segment and read it into inst->pkt.
+* A seek may land after the keyframe, then the keyframes before it are tried
+*/
+static int seek_segment(instance_t *inst, segment_t *seg) {
+    gop_t *gop = inst->gop;
+    const key_entry_t *key = &gop->keys[seg->key];
+    int order;
+    int ret;
+    int k;
+
+    for (k = seg->key; k >= 0; k--) {
+        ret = av_seek_frame(inst->ctx, gop->vstrm_index, gop->keys[k].ts, AVSEEK_FLAG_BACKWARD);
+        if (ret < 0) {
+            continue;
+        }
+
+        while ((ret = read_video_packet(inst->ctx, gop->vstrm_index, inst->pkt)) == 0) {
+            order = key_order(inst->pkt, key);
+            if (order == 0) {
+                return 0;
+            }
+            av_packet_unref(inst->pkt);
+            if (order > 0) {
+                break;
+            }
+        }
+    }
+
+    printf("[%d] failed to seek to the keyframe of segment %d\n", inst->id, seg->index);
+
+    return -1;
+}
+
+static int open_segment_output(instance_t *inst, segment_t *seg) {
+    char path[1024];
+    int fd;
+
+    if (path_pattern_format(path, sizeof(path), inst->gop->output, seg->index) < 0) {
+        printf("[%d] output path of segment %d is too long\n", inst->id, seg->index);
+        return -1;
+    }
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("[%d] failed to create %s(error: %s)\n", inst->id, path, strerror(errno));
+    }
+
+    return fd;
+}
+
+/*
+* Decode from the keyframe of the segment to the keyframe of the next one,
+* and the leading pictures after it
+*/
+static int decode_segment(instance_t *inst, segment_t *seg) {
+    gop_t *gop = inst->gop;
+    const key_entry_t *end = seg->end_key < gop->nb_keys ? &gop->keys[seg->end_key] : NULL;
+    AVPacket *pkt = inst->pkt;
+    int boundary = 0;
+    int fd = -1;
+    int ret;
+
+    if (gop->per_segment) {
+        fd = open_segment_output(inst, seg);
+        if (fd < 0) {
+            return -1;
+        }
+    }
+
+    ret = seek_segment(inst, seg);
+    if (ret < 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    inst->start_pts = pkt->pts;
+    inst->end_pts   = AV_NOPTS_VALUE;
+
+    while (ret == 0) {
+        if (end && !boundary && key_order(pkt, end) >= 0) {
+            boundary = 1;
+            inst->end_pts = pkt->pts;
+            if (inst->end_pts == AV_NOPTS_VALUE) {
+                av_packet_unref(pkt);
+                break;
+            }
+        } else if (boundary && ((pkt->flags & AV_PKT_FLAG_KEY) || pkt->pts == AV_NOPTS_VALUE ||
+                   pkt->pts >= inst->end_pts)) {
+            /*past the leading pictures of the next keyframe*/
+            av_packet_unref(pkt);
+            break;
+        }
+
+        ret = send_packet(inst, seg, pkt, fd);
+        av_packet_unref(pkt);
+        if (ret < 0) {
+            break;
+        }
+
+        ret = read_video_packet(inst->ctx, gop->vstrm_index, pkt);
+        if (ret == AVERROR_EOF) {
+            ret = 1;
+        }
+    }
+
+    if (ret >= 0) {
+        ret = send_packet(inst, seg, NULL, fd);
+    }
+    /*clean decoder for the next segment*/
+    avcodec_flush_buffers(inst->avctx);
+
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    return ret < 0 ? -1 : 0;
+}
+
+static void *instanceThreadEntry(void *priv) {
+    instance_t *inst = (instance_t *)priv;
+    gop_t *gop = inst->gop;
+    segment_t *seg;
+    int64_t start_us;
+
+    inst->pkt   = av_packet_alloc();
+    inst->frame = av_frame_alloc();
+    if (!inst->pkt || !inst->frame || open_file(gop->path, &inst->ctx)) {
+        inst->failed = 1;
+    } else {
+        /*no picture pool: the frames of the ordered output are kept for a while*/
+        inst->avctx = dec_backend_open(&gop->backend, gop->par, NULL, inst->id);
+        inst->failed = !inst->avctx;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&gop->lock);
+        seg = gop->next_segment < gop->nb_segments ? &gop->segments[gop->next_segment++] : NULL;
+        pthread_mutex_unlock(&gop->lock);
+        if (!seg) {
+            break;
+        }
+
+        start_us = get_time_us();
+        if (inst->failed || decode_segment(inst, seg)) {
+            seg->failed = 1;
+        }
+        seg->elapsed_us = get_time_us() - start_us;
+        inst->busy_us += seg->elapsed_us;
+        inst->nb_segments++;
+
+        if (gop->fd >= 0) {
+            finish_segment(inst, seg);
+        }
+    }
+
+    return NULL;
+}
+
+static void free_gop(gop_t *gop) {
+    int i, j;
+
+    for (i = 0; i < gop->nb_instances; i++) {
+        instance_t *inst = &gop->instances[i];
+
+        if (inst->avctx) {
+            dec_backend_close(&inst->avctx);
+        }
+        avformat_close_input(&inst->ctx);
+        av_packet_free(&inst->pkt);
+        av_frame_free(&inst->frame);
+        free(inst->buf);
+    }
+
+    for (i = 0; i < gop->nb_segments; i++) {
+        for (j = 0; j < gop->segments[i].nb_queued; j++) {
+            av_frame_free(&gop->segments[i].frames[j]);
+        }
+        free(gop->segments[i].frames);
+    }
+
+    free(gop->segments);
+    free(gop->keys);
+    avcodec_parameters_free(&gop->par);
+    pthread_mutex_destroy(&gop->lock);
+    pthread_cond_destroy(&gop->cond);
+    free(gop);
+}
+
+int main(int argc, char *argv[])
+{
+    int option;
+    int ret = 0;
+    int i;
+    int queue_mb = QUEUE_MB;
+    uint64_t nb_frames = 0;
+    int nb_failed = 0;
+    int64_t start_us, elapsed_us;
+    double seconds;
+
+    gop_t *gop = NULL;
+
+    gop = (gop_t *)malloc(sizeof(gop_t));
+    if (gop == NULL) {
+        printf("failed to  malloc gop_t\n");
+        return -1;
+    }
+
+    memset(gop, 0, sizeof(gop_t));
+    gop->fd = -1;
+    gop->nb_instances = sysconf(_SC_NPROCESSORS_ONLN);
+    /*the segments run in parallel, one thread per software decoder is enough*/
+    gop->backend.thread_count = 1;
+    pthread_mutex_init(&gop->lock, NULL);
+    pthread_cond_init(&gop->cond, NULL);
+
+    /* Process options with getopt */
+    while ((option = getopt(argc, argv,"i:j:g:o:m:b:H:n:x:h")) != -1) {
+        switch (option) {
+            case 'i':
+                gop->path = optarg;
+                break;
+
+            case 'j':
+                gop->nb_instances = atoi(optarg);
+                break;
+
+            case 'g':
+                gop->gops = atoi(optarg);
+                break;
+
+            case 'o':
+                gop->output = optarg;
+                break;
+
+            case 'm':
+                queue_mb = atoi(optarg);
+                break;
+
+            case 'b':
+                gop->backend.backend = dec_backend_from_name(optarg);
+                break;
+
+            case 'H':
+                gop->backend.max_hw = atoi(optarg);
+                break;
+
+            case 'n':
+                gop->backend.thread_count = atoi(optarg);
+                break;
+
+            case 'x':
+                gop->backend.thread_type = dec_backend_thread_type_from_name(optarg);
+                break;
+
+            case 'h':
+            default:
+                usage(argv[0]);
+                exit(0);
+                break;
+        }
+    }
+
+    if (!gop->path || gop->nb_instances <= 0 || gop->gops < 0 || queue_mb <= 0 ||
+        gop->backend.backend == DEC_BACKEND_MAX || gop->backend.max_hw < 0 ||
+        gop->backend.thread_count < 0 || gop->backend.thread_type < 0) {
+        usage(argv[0]);
+        exit(0);
+    }
+
+    if (gop->nb_instances > MAX_INSTANCES) {
+        gop->nb_instances = MAX_INSTANCES;
+    }
+    gop->max_queued_bytes = (int64_t)queue_mb * 1024 * 1024;
+
+    if (build_segments(gop)) {
+        free_gop(gop);
+        return -1;
+    }
+
+    if (gop->nb_instances > gop->nb_segments) {
+        gop->nb_instances = gop->nb_segments;
+    }
+
+    if (gop->output) {
+        gop->per_segment = path_pattern_check(gop->output);
+        if (gop->per_segment < 0) {
+            printf("invalid output path: %s, only one %%d is allowed and no other %%\n", gop->output);
+            free_gop(gop);
+            return -1;
+        }
+        if (!gop->per_segment) {
+            gop->fd = open(gop->output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (gop->fd < 0) {
+                printf("failed to create %s(error: %s)\n", gop->output, strerror(errno));
+                free_gop(gop);
+                return -1;
+            }
+        }
+    }
+
+    start_us = get_time_us();
+
+    for (i = 0; i < gop->nb_instances; i++) {
+        gop->instances[i].id  = i;
+        gop->instances[i].gop = gop;
+        ret = pthread_create(&gop->instances[i].thread, NULL, instanceThreadEntry,
+                             (void *)&gop->instances[i]);
+        if (ret != 0) {
+            printf("Failed to create decoder thread %d(res=%d, error=%s)\n",
+                    i, ret, strerror(ret));
+            gop->nb_instances = i;
+            ret = -1;
+            break;
+        }
+    }
+
+    for (i = 0; i < gop->nb_instances; i++) {
+        pthread_join(gop->instances[i].thread, NULL);
+    }
+
+    elapsed_us = get_time_us() - start_us;
+    seconds = elapsed_us / 1000000.0;
+
+    for (i = 0; i < gop->nb_instances; i++) {
+        instance_t *inst = &gop->instances[i];
+
+        printf("[%d] %s: %d segments, %llu frames, %llu errors, busy %.1f%%\n",
+                inst->id, inst->avctx ? inst->avctx->codec->name : "failed",
+                inst->nb_segments, (unsigned long long)inst->nb_frames,
+                (unsigned long long)inst->nb_errors,
+                elapsed_us > 0 ? inst->busy_us * 100.0 / elapsed_us : 0);
+        nb_frames += inst->nb_frames;
+    }
+
+    for (i = 0; i < gop->nb_segments; i++) {
+        if (gop->segments[i].failed) {
+            printf("segment %d failed\n", i);
+            nb_failed++;
+        }
+    }
+
+    if (gop->fd >= 0) {
+        close(gop->fd);
+    }
+
+    printf("%llu frames of %d segments on %d decoders in %.2fs: %.1f fps%s\n",
+            (unsigned long long)nb_frames, gop->nb_segments, gop->nb_instances, seconds,
+            seconds > 0 ? nb_frames / seconds : 0,
+            gop->write_failed ? ", failed to write the output" : "");
+
+    if (nb_failed || gop->write_failed) {
+        ret = -1;
+    }
+
+    free_gop(gop);
+
+    return ret;
+}
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: hdr_hist.c
+*
+* PURPOSE: log-linear histogram of latencies in the HdrHistogram style
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+#include "hdr_hist.h"
+
+/*
+Values below 2^SUB_BUCKET_BITS have their own bucket. Above it, every
+power of 2 range is split into 2^(SUB_BUCKET_BITS - 1) buckets, so the
+bucket width is less than 1/64 of the value.
+*/
+#define SUB_BUCKET_BITS  7
+#define SUB_BUCKET_HALF  (1 << (SUB_BUCKET_BITS - 1))
+
+struct hdr_hist_t {
+    int64_t      max_value;
+    int          nb_buckets;
+
+    atomic_llong min;
+    atomic_llong max;
+    atomic_llong sum;
+    atomic_llong count;
+    atomic_llong buckets[];
+};
+
+static int bucket_index(int64_t value) {
+    int msb;
+    int shift;
+
+    if (value < (1 << SUB_BUCKET_BITS)) {
+        return (int)value;
+    }
+
+    msb   = 63 - __builtin_clzll((uint64_t)value);
+    shift = msb - SUB_BUCKET_BITS + 1;
+
+    return (shift << (SUB_BUCKET_BITS - 1)) + (int)(value >> shift);
+}
+
+/*the highest value counted in the bucket*/
+static int64_t bucket_value(int index) {
+    int shift;
+    int64_t sub;
+
+    if (index < (1 << SUB_BUCKET_BITS)) {
+        return index;
+    }
+
+    shift = (index >> (SUB_BUCKET_BITS - 1)) - 1;
+    sub   = (index & (SUB_BUCKET_HALF - 1)) + SUB_BUCKET_HALF;
+
+    return ((sub + 1) << shift) - 1;
+}
+
+hdr_hist_t *hdr_hist_alloc(int64_t max_value) {
+    hdr_hist_t *hist;
+    int nb_buckets;
+    int i;
+
+    if (max_value <= 0) {
+        printf("invalid max value of histogram: %lld\n", (long long)max_value);
+        return NULL;
+    }
+
+    nb_buckets = bucket_index(max_value) + 1;
+
+    hist = (hdr_hist_t *)malloc(sizeof(hdr_hist_t) + nb_buckets * sizeof(atomic_llong));
+    if (hist == NULL) {
+        printf("failed to malloc histogram of %d buckets\n", nb_buckets);
+        return NULL;
+    }
+
+    hist->max_value  = max_value;
+    hist->nb_buckets = nb_buckets;
+    atomic_init(&hist->min, INT64_MAX);
+    atomic_init(&hist->max, 0);
+    atomic_init(&hist->sum, 0);
+    atomic_init(&hist->count, 0);
+    for (i = 0; i < nb_buckets; i++) {
+        atomic_init(&hist->buckets[i], 0);
+    }
+
+    return hist;
+}
+
+void hdr_hist_free(hdr_hist_t **hist) {
+    free(*hist);
+    *hist = NULL;
+}
+
+void hdr_hist_record(hdr_hist_t *hist, int64_t value) {
+    long long old;
+
+    if (value < 0) {
+        value = 0;
+    } else if (value > hist->max_value) {
+        value = hist->max_value;
+    }
+
+    atomic_fetch_add_explicit(&hist->buckets[bucket_index(value)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->sum, value, memory_order_relaxed);
+
+    old = atomic_load_explicit(&hist->min, memory_order_relaxed);
+    while (value < old &&
+           !atomic_compare_exchange_weak_explicit(&hist->min, &old, value,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+
+    old = atomic_load_explicit(&hist->max, memory_order_relaxed);
+    while (value > old &&
+           !atomic_compare_exchange_weak_explicit(&hist->max, &old, value,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void hdr_hist_merge(hdr_hist_t *dst, const hdr_hist_t *src) {
+    long long n;
+    int i;
+
+    if (dst->nb_buckets != src->nb_buckets) {
+        printf("can not merge the histograms of %d and %d buckets\n",
+                dst->nb_buckets, src->nb_buckets);
+        return;
+    }
+
+    for (i = 0; i < src->nb_buckets; i++) {
+        n = atomic_load_explicit(&src->buckets[i], memory_order_relaxed);
+        if (n) {
+            atomic_fetch_add_explicit(&dst->buckets[i], n, memory_order_relaxed);
+        }
+    }
+
+    atomic_fetch_add_explicit(&dst->count,
+                              atomic_load_explicit(&src->count, memory_order_relaxed),
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&dst->sum,
+                              atomic_load_explicit(&src->sum, memory_order_relaxed),
+                              memory_order_relaxed);
+
+    if (hdr_hist_min(src) < hdr_hist_min(dst)) {
+        atomic_store_explicit(&dst->min, hdr_hist_min(src), memory_order_relaxed);
+    }
+    if (hdr_hist_max(src) > hdr_hist_max(dst)) {
+        atomic_store_explicit(&dst->max, hdr_hist_max(src), memory_order_relaxed);
+    }
+}
+
+void hdr_hist_reset(hdr_hist_t *hist) {
+    int i;
+
+    for (i = 0; i < hist->nb_buckets; i++) {
+        atomic_store_explicit(&hist->buckets[i], 0, memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&hist->min, INT64_MAX, memory_order_relaxed);
+    atomic_store_explicit(&hist->max, 0, memory_order_relaxed);
+    atomic_store_explicit(&hist->sum, 0, memory_order_relaxed);
+    atomic_store_explicit(&hist->count, 0, memory_order_relaxed);
+}
+
+uint64_t hdr_hist_count(const hdr_hist_t *hist) {
+    return atomic_load_explicit(&hist->count, memory_order_relaxed);
+}
+
+int64_t hdr_hist_min(const hdr_hist_t *hist) {
+    int64_t min = atomic_load_explicit(&hist->min, memory_order_relaxed);
+
+    return min == INT64_MAX ? 0 : min;
+}
+
+int64_t hdr_hist_max(const hdr_hist_t *hist) {
+    return atomic_load_explicit(&hist->max, memory_order_relaxed);
+}
+
+double hdr_hist_mean(const hdr_hist_t *hist) {
+    uint64_t count = hdr_hist_count(hist);
+
+    if (!count) {
+        return 0;
+    }
+
+    return (double)atomic_load_explicit(&hist->sum, memory_order_relaxed) / count;
+}
+
+int64_t hdr_hist_percentile(const hdr_hist_t *hist, double percentile) {
+    uint64_t total = 0;
+    uint64_t target;
+    uint64_t seen = 0;
+    int64_t value;
+    int i;
+
+    /*sum the buckets rather than trust count, they are recorded apart*/
+    for (i = 0; i < hist->nb_buckets; i++) {
+        total += atomic_load_explicit(&hist->buckets[i], memory_order_relaxed);
+    }
+
+    if (!total) {
+        return 0;
+    }
+
+    if (percentile > 100) {
+        percentile = 100;
+    }
+
+    target = (uint64_t)(percentile / 100 * total + 0.5);
+    if (target < 1) {
+        target = 1;
+    }
+
+    for (i = 0; i < hist->nb_buckets; i++) {
+        seen += atomic_load_explicit(&hist->buckets[i], memory_order_relaxed);
+        if (seen >= target) {
+            break;
+        }
+    }
+
+    if (i == hist->nb_buckets) {
+        i--;
+    }
+
+    /*no more than the real max*/
+    value = bucket_value(i);
+    if (value > hdr_hist_max(hist) && hdr_hist_max(hist) > 0) {
+        value = hdr_hist_max(hist);
+    }
+
+    return value;
+}
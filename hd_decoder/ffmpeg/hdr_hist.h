@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: hdr_hist.h
+*
+* PURPOSE: log-linear histogram of latencies in the HdrHistogram style,
+*          about 1% precision over the whole range, lock-free recording
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#ifndef __HDR_HIST_H_
+#define __HDR_HIST_H_
+
+#include <stdint.h>
+
+typedef struct hdr_hist_t hdr_hist_t;
+
+/*
+* Histogram of the values in [0, max_value], bigger values are counted as max_value
+*/
+hdr_hist_t *hdr_hist_alloc(int64_t max_value);
+
+void hdr_hist_free(hdr_hist_t **hist);
+
+/*
+* Count a value, safe from any thread without lock
+*/
+void hdr_hist_record(hdr_hist_t *hist, int64_t value);
+
+/*
+* Add the counts of src into dst, both of the same max_value
+*/
+void hdr_hist_merge(hdr_hist_t *dst, const hdr_hist_t *src);
+
+/*
+* Clear the counts, the values recorded meanwhile may be lost
+*/
+void hdr_hist_reset(hdr_hist_t *hist);
+
+uint64_t hdr_hist_count(const hdr_hist_t *hist);
+int64_t  hdr_hist_min(const hdr_hist_t *hist);
+int64_t  hdr_hist_max(const hdr_hist_t *hist);
+double   hdr_hist_mean(const hdr_hist_t *hist);
+
+/*
+* The value below which percentile% of the recorded values fall,
+* rounded up to the precision of the histogram
+*   percentile: 0 - 100, e.g. 99.9
+*/
+int64_t hdr_hist_percentile(const hdr_hist_t *hist, double percentile);
+
+#endif /* __HDR_HIST_H_ */
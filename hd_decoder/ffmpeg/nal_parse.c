@@ -0,0 +1,448 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: nal_parse.c
+*
+* PURPOSE: light H.264/HEVC NAL unit parser of the demuxed packets
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Picture type from the slice header
+* 2026-10-18  Apoidea   HEVC sub-layer non-reference pictures by their TemporalId
+************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "nal_parse.h"
+
+#define HEVC_NAL_SPS     33
+#define HEVC_NAL_PPS     34
+#define SLICE_HEADER_MAX 32   /*bytes of a NAL unit unescaped for the slice header*/
+
+/*reader of the RBSP bits, the emulation prevention bytes are removed*/
+typedef struct bit_reader_t {
+    uint8_t         buf[SLICE_HEADER_MAX];
+    int             size;
+    int             pos;        /*in bits*/
+    int             overread;
+} bit_reader_t;
+
+static void bit_reader_init(bit_reader_t *br, const uint8_t *data, int size) {
+    int zeros = 0;
+    int i;
+
+    br->size     = 0;
+    br->pos      = 0;
+    br->overread = 0;
+
+    for (i = 0; i < size && br->size < SLICE_HEADER_MAX; i++) {
+        if (zeros >= 2 && data[i] == 3) {
+            /*emulation_prevention_three_byte*/
+            zeros = 0;
+            continue;
+        }
+        zeros = data[i] ? 0 : zeros + 1;
+        br->buf[br->size++] = data[i];
+    }
+}
+
+static unsigned int read_bits(bit_reader_t *br, int n) {
+    unsigned int v = 0;
+
+    while (n-- > 0) {
+        if (br->pos >= br->size * 8) {
+            br->overread = 1;
+            return 0;
+        }
+        v = (v << 1) | ((br->buf[br->pos >> 3] >> (7 - (br->pos & 7))) & 1);
+        br->pos++;
+    }
+
+    return v;
+}
+
+/*ue(v)*/
+static unsigned int read_ue(bit_reader_t *br) {
+    int zeros = 0;
+
+    while (!read_bits(br, 1)) {
+        if (br->overread || ++zeros > 31) {
+            br->overread = 1;
+            return 0;
+        }
+    }
+
+    return (1u << zeros) - 1 + read_bits(br, zeros);
+}
+
+/*num_extra_slice_header_bits of an HEVC PPS*/
+static void parse_pps(nal_parser_t *p, const uint8_t *data, int size) {
+    bit_reader_t br;
+    unsigned int pps_id;
+    unsigned int extra_bits;
+
+    bit_reader_init(&br, data + 2, size - 2);
+    pps_id = read_ue(&br);
+    read_ue(&br);       /*pps_seq_parameter_set_id*/
+    read_bits(&br, 2);  /*dependent_slice_segments_enabled_flag, output_flag_present_flag*/
+    extra_bits = read_bits(&br, 3);
+
+    if (!br.overread && pps_id < NAL_MAX_PPS) {
+        p->extra_slice_header_bits[pps_id] = extra_bits;
+    }
+}
+
+/*
+* sps_max_sub_layers_minus1 of an HEVC SPS, right after the 4 bits of
+* sps_video_parameter_set_id, no emulation prevention byte before it
+*/
+static void parse_sps(nal_parser_t *p, const uint8_t *data, int size) {
+    int max_temporal_id;
+
+    if (size < 3) {
+        return;
+    }
+
+    max_temporal_id = (data[2] >> 1) & 0x7;
+    if (max_temporal_id > p->max_temporal_id) {
+        p->max_temporal_id = max_temporal_id;
+    }
+}
+
+/*the SPS and PPS of hvcC or Annex-B extradata*/
+static void parse_extradata_ps(nal_parser_t *p, const uint8_t *data, int size) {
+    const uint8_t *end = data + size;
+    nal_parser_t annexb;
+    nal_unit_t nal;
+    int nb_arrays;
+    int nb_nals;
+    int len;
+    int type;
+
+    if (size > 0 && data[0] == 1) {
+        if (size < 23) {
+            return;
+        }
+        nb_arrays = data[22];
+        data += 23;
+
+        while (nb_arrays-- > 0 && end - data >= 3) {
+            type    = data[0] & 0x3f;
+            nb_nals = (data[1] << 8) | data[2];
+            data += 3;
+
+            while (nb_nals-- > 0 && end - data >= 2) {
+                len = (data[0] << 8) | data[1];
+                data += 2;
+                if (len > end - data) {
+                    return;
+                }
+                if (type == HEVC_NAL_PPS && len > 2) {
+                    parse_pps(p, data, len);
+                } else if (type == HEVC_NAL_SPS) {
+                    parse_sps(p, data, len);
+                }
+                data += len;
+            }
+        }
+        return;
+    }
+
+    annexb = *p;
+    annexb.length_size = 0;
+    while (nal_next(&annexb, &data, end, &nal)) {
+        if (nal.type == HEVC_NAL_PPS) {
+            parse_pps(p, nal.data, nal.size);
+        } else if (nal.type == HEVC_NAL_SPS) {
+            parse_sps(p, nal.data, nal.size);
+        }
+    }
+}
+
+int nal_parser_init(nal_parser_t *p, const AVCodecParameters *par) {
+    const uint8_t *extradata = par->extradata;
+    int size = par->extradata_size;
+
+    memset(p, 0, sizeof(nal_parser_t));
+
+    if (par->codec_id != AV_CODEC_ID_H264 && par->codec_id != AV_CODEC_ID_HEVC) {
+        return -1;
+    }
+
+    p->codec_id = par->codec_id;
+    p->max_temporal_id = -1;
+
+    /*
+    avcC/hvcC extradata(configurationVersion is 1) comes with length prefixed
+    packets, e.g. mp4/mkv. Otherwise the packets are in Annex-B, e.g. rtsp/ts
+    */
+    if (extradata && size > 0 && extradata[0] == 1) {
+        if (p->codec_id == AV_CODEC_ID_H264 && size >= 7) {
+            p->length_size = (extradata[4] & 0x3) + 1;
+        } else if (p->codec_id == AV_CODEC_ID_HEVC && size >= 23) {
+            p->length_size = (extradata[21] & 0x3) + 1;
+            /*numTemporalLayers, 0: unknown*/
+            p->max_temporal_id = ((extradata[21] >> 3) & 0x7) - 1;
+        }
+    }
+
+    if (p->codec_id == AV_CODEC_ID_HEVC && extradata) {
+        parse_extradata_ps(p, extradata, size);
+    }
+
+    return 0;
+}
+
+/*return the next "00 00 01" from buf, end if there is none*/
+static const uint8_t *find_start_code(const uint8_t *buf, const uint8_t *end) {
+    while (buf + 2 < end) {
+        if (buf[2] > 1) {
+            buf += 3;
+        } else if (buf[1]) {
+            buf += 2;
+        } else if (buf[0] || buf[2] != 1) {
+            buf++;
+        } else {
+            return buf;
+        }
+    }
+
+    return end;
+}
+
+static void parse_header(const nal_parser_t *p, nal_unit_t *nal) {
+    if (p->codec_id == AV_CODEC_ID_H264) {
+        nal->type        = nal->data[0] & 0x1f;
+        nal->ref_idc     = (nal->data[0] >> 5) & 0x3;
+        nal->temporal_id = 0;
+    } else {
+        nal->type = (nal->data[0] >> 1) & 0x3f;
+        /*TRAIL_N, TSA_N, STSA_N, RADL_N, RASL_N and RSV_VCL_N10/12/14*/
+        nal->ref_idc = (nal->type <= 14 && !(nal->type & 1)) ? 0 : 1;
+        /*nuh_temporal_id_plus1, 0 is not allowed*/
+        nal->temporal_id = (nal->data[1] & 0x7) - 1;
+    }
+}
+
+static int next_annexb(const nal_parser_t *p, const uint8_t **buf, const uint8_t *end,
+                       nal_unit_t *nal) {
+    const uint8_t *start;
+    const uint8_t *next;
+    const uint8_t *nal_end;
+
+    for (;;) {
+        start = find_start_code(*buf, end);
+        if (start == end) {
+            *buf = end;
+            return 0;
+        }
+
+        start += 3;
+        next = find_start_code(start, end);
+        *buf = next;
+
+        /*trailing_zero_8bits and the leading zero of a 4 bytes start code*/
+        nal_end = next;
+        while (nal_end > start && nal_end[-1] == 0) {
+            nal_end--;
+        }
+
+        if (nal_end - start >= (p->codec_id == AV_CODEC_ID_HEVC ? 2 : 1)) {
+            nal->data = start;
+            nal->size = nal_end - start;
+            return 1;
+        }
+    }
+}
+
+static int next_length_prefixed(const nal_parser_t *p, const uint8_t **buf,
+                                 const uint8_t *end, nal_unit_t *nal) {
+    const uint8_t *q;
+    uint32_t len;
+    int i;
+
+    while (end - *buf >= p->length_size) {
+        q = *buf;
+        len = 0;
+        for (i = 0; i < p->length_size; i++) {
+            len = (len << 8) | *q++;
+        }
+
+        if (len > (uint32_t)(end - q)) {
+            /*truncated packet*/
+            break;
+        }
+
+        *buf = q + len;
+        if (len >= (p->codec_id == AV_CODEC_ID_HEVC ? 2u : 1u)) {
+            nal->data = q;
+            nal->size = len;
+            return 1;
+        }
+    }
+
+    *buf = end;
+    return 0;
+}
+
+int nal_next(const nal_parser_t *p, const uint8_t **buf, const uint8_t *end,
+             nal_unit_t *nal) {
+    int ret;
+
+    if (p->length_size) {
+        ret = next_length_prefixed(p, buf, end, nal);
+    } else {
+        ret = next_annexb(p, buf, end, nal);
+    }
+
+    if (ret) {
+        parse_header(p, nal);
+    }
+
+    return ret;
+}
+
+int nal_is_vcl(const nal_parser_t *p, const nal_unit_t *nal) {
+    if (p->codec_id == AV_CODEC_ID_H264) {
+        return nal->type >= 1 && nal->type <= 5;
+    }
+
+    return nal->type <= 31;
+}
+
+int nal_packet_is_droppable(nal_parser_t *p, const uint8_t *data, int size) {
+    const uint8_t *end = data + size;
+    nal_unit_t nal;
+
+    /*all the slices of a picture agree, the first one decides*/
+    while (nal_next(p, &data, end, &nal)) {
+        if (p->codec_id == AV_CODEC_ID_HEVC && nal.type == HEVC_NAL_SPS) {
+            parse_sps(p, nal.data, nal.size);
+            continue;
+        }
+        if (!nal_is_vcl(p, &nal)) {
+            continue;
+        }
+
+        if (nal.ref_idc != 0) {
+            return 0;
+        }
+
+        /*
+        the pictures of the higher sub-layers may reference it, no higher
+        one is known only if the SPS is
+        */
+        return p->codec_id != AV_CODEC_ID_HEVC ||
+               (p->max_temporal_id >= 0 && nal.temporal_id >= p->max_temporal_id);
+    }
+
+    return 0;
+}
+
+int nal_packet_is_irap(const nal_parser_t *p, const uint8_t *data, int size) {
+    const uint8_t *end = data + size;
+    nal_unit_t nal;
+
+    while (nal_next(p, &data, end, &nal)) {
+        if (nal_is_vcl(p, &nal)) {
+            if (p->codec_id == AV_CODEC_ID_H264) {
+                return nal.type == 5;
+            }
+
+            /*BLA_W_LP ... CRA_NUT, and RSV_IRAP_VCL22/23*/
+            return nal.type >= 16 && nal.type <= 23;
+        }
+    }
+
+    return 0;
+}
+
+static enum AVPictureType slice_picture_type(const nal_parser_t *p, const nal_unit_t *nal) {
+    bit_reader_t br;
+    unsigned int pps_id;
+    unsigned int slice_type;
+
+    if (p->codec_id == AV_CODEC_ID_H264) {
+        bit_reader_init(&br, nal->data + 1, nal->size - 1);
+        read_ue(&br);   /*first_mb_in_slice*/
+        slice_type = read_ue(&br);
+        if (br.overread || slice_type > 9) {
+            return AV_PICTURE_TYPE_NONE;
+        }
+
+        /*P, B, I, SP, SI and the same +5 when all the slices agree*/
+        switch (slice_type % 5) {
+            case 0:
+            case 3:
+                return AV_PICTURE_TYPE_P;
+            case 1:
+                return AV_PICTURE_TYPE_B;
+            default:
+                return AV_PICTURE_TYPE_I;
+        }
+    }
+
+    bit_reader_init(&br, nal->data + 2, nal->size - 2);
+    if (!read_bits(&br, 1)) {
+        /*not first_slice_segment_in_pic_flag, the address needs the SPS*/
+        return AV_PICTURE_TYPE_NONE;
+    }
+    if (nal->type >= 16 && nal->type <= 23) {
+        read_bits(&br, 1);  /*no_output_of_prior_pics_flag*/
+    }
+    pps_id = read_ue(&br);
+    if (pps_id >= NAL_MAX_PPS) {
+        return AV_PICTURE_TYPE_NONE;
+    }
+    read_bits(&br, p->extra_slice_header_bits[pps_id]);
+    slice_type = read_ue(&br);
+    if (br.overread) {
+        return AV_PICTURE_TYPE_NONE;
+    }
+
+    switch (slice_type) {
+        case 0:
+            return AV_PICTURE_TYPE_B;
+        case 1:
+            return AV_PICTURE_TYPE_P;
+        case 2:
+            return AV_PICTURE_TYPE_I;
+        default:
+            return AV_PICTURE_TYPE_NONE;
+    }
+}
+
+enum AVPictureType nal_packet_picture_type(nal_parser_t *p, const uint8_t *data, int size) {
+    const uint8_t *end = data + size;
+    nal_unit_t nal;
+
+    while (nal_next(p, &data, end, &nal)) {
+        if (p->codec_id == AV_CODEC_ID_HEVC && nal.type == HEVC_NAL_PPS) {
+            parse_pps(p, nal.data, nal.size);
+        } else if (nal_is_vcl(p, &nal)) {
+            return slice_picture_type(p, &nal);
+        }
+    }
+
+    return AV_PICTURE_TYPE_NONE;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: nal_parse.h
+*
+* PURPOSE: light H.264/HEVC NAL unit parser of the demuxed packets,
+*          it looks at the NAL headers and the start of the slice headers
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Picture type from the slice header
+* 2026-10-18  Apoidea   HEVC sub-layer non-reference pictures by their TemporalId
+************************************************************************/
+
+#ifndef __NAL_PARSE_H_
+#define __NAL_PARSE_H_
+
+#include <stdint.h>
+
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+
+#define NAL_MAX_PPS 64
+
+typedef struct nal_parser_t {
+    enum AVCodecID codec_id;    /*AV_CODEC_ID_H264 or AV_CODEC_ID_HEVC*/
+    int            length_size; /*NAL length field of the avcC/hvcC packets*/
+    uint8_t        extra_slice_header_bits[NAL_MAX_PPS];   /*HEVC, of the PPS ids*/
+    int            max_temporal_id;    /*HEVC, the highest TemporalId by the SPS, -1: unknown*/
+} nal_parser_t;
+
+typedef struct nal_unit_t {
+    const uint8_t *data;        /*from the NAL header, without start code*/
+    int           size;
+    int           type;         /*nal_unit_type*/
+    int           ref_idc;      /*H.264 nal_ref_idc, HEVC: 0 for the sub-layer
+                                  non-reference pictures, otherwise 1*/
+    int           temporal_id;  /*HEVC TemporalId, H.264: 0*/
+} nal_unit_t;
+
+/*
+* Set up the parser for the stream
+*   return 0 on success, -1 if the codec has no NAL units to parse
+*/
+int nal_parser_init(nal_parser_t *p, const AVCodecParameters *par);
+
+/*
+* Get the next NAL unit of the packet, Annex-B or length prefixed
+*   *buf, end: the rest of the packet, *buf is moved after the NAL unit
+*   return 1 if a NAL unit is got, 0 at the end of the packet
+*/
+int nal_next(const nal_parser_t *p, const uint8_t **buf, const uint8_t *end,
+             nal_unit_t *nal);
+
+/*
+* Coded slice of a picture
+*/
+int nal_is_vcl(const nal_parser_t *p, const nal_unit_t *nal);
+
+/*
+* Return 1 if no other picture references the picture of the packet,
+* dropping it does not break the decoding, otherwise 0. An HEVC sub-layer
+* non-reference picture is referenced by the higher sub-layers, it is
+* droppable only in the highest sub-layer of the SPS, the SPS of the
+* packet are kept for the packets after them
+*/
+int nal_packet_is_droppable(nal_parser_t *p, const uint8_t *data, int size);
+
+/*
+* Return 1 if the picture of the packet is an H.264 IDR or an HEVC IRAP
+* (BLA, IDR, CRA), the decoding can restart from it, otherwise 0
+*/
+int nal_packet_is_irap(const nal_parser_t *p, const uint8_t *data, int size);
+
+/*
+* Picture type of the packet by the slice_type of its first slice, the
+* HEVC PPS of the packet are kept for the slice headers after them
+*   return AV_PICTURE_TYPE_I, AV_PICTURE_TYPE_P(SP too) or AV_PICTURE_TYPE_B,
+*          AV_PICTURE_TYPE_NONE if there is no slice header to parse
+*/
+enum AVPictureType nal_packet_picture_type(nal_parser_t *p, const uint8_t *data, int size);
+
+#endif /* __NAL_PARSE_H_ */
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: path_pattern.c
+*
+* PURPOSE: output paths with a number in place of the "%d" of a pattern
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "path_pattern.h"
+
+int path_pattern_check(const char *pattern) {
+    int nb = 0;
+
+    for (; *pattern; pattern++) {
+        if (*pattern != '%') {
+            continue;
+        }
+        if (pattern[1] != 'd' || nb++) {
+            return -1;
+        }
+        pattern++;
+    }
+
+    return nb;
+}
+
+int path_pattern_format(char *path, int size, const char *pattern, long long number) {
+    const char *d = strstr(pattern, "%d");
+    int len;
+
+    if (d == NULL) {
+        len = snprintf(path, size, "%s", pattern);
+    } else {
+        len = snprintf(path, size, "%.*s%lld%s", (int)(d - pattern), pattern, number, d + 2);
+    }
+
+    return len < size ? 0 : -1;
+}
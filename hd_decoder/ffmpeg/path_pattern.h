@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: path_pattern.h
+*
+* PURPOSE: output paths with a number in place of the "%d" of a pattern
+*          given by the user, without using it as a printf format
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#ifndef __PATH_PATTERN_H_
+#define __PATH_PATTERN_H_
+
+/*
+* return 1 if the pattern has one "%d" and no other '%', 0 if it has no '%',
+*        -1 otherwise: it is not a valid pattern
+*/
+int path_pattern_check(const char *pattern);
+
+/*
+* The pattern with its first "%d" replaced by number, the pattern as it
+* is if it has none
+*   return 0 on success, -1 if the path is truncated to size
+*/
+int path_pattern_format(char *path, int size, const char *pattern, long long number);
+
+#endif /* __PATH_PATTERN_H_ */
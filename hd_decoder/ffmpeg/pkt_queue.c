@@ -0,0 +1,357 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: pkt_queue.c
+*
+* PURPOSE: bounded lock-free packet ring between the demux and decode stages
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Drop whole GOPs and report the gaps to the consumer
+************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "pkt_queue.h"
+
+/*
+The ring is a bounded queue with a sequence number per cell:
+    cell.seq == pos:            the cell is free for the producer at pos
+    cell.seq == pos + 1:        the cell holds the packet pushed at pos
+A single producer writes the cells, and pops claim a cell by CAS on
+dequeue_pos. The producer itself pops the oldest packet to make room in
+the drop policies, so the pop side must allow two threads.
+
+The consumer finds a gap before a packet by a position which the
+producer popped, or by the gap flag of a packet pushed after the new
+packets were dropped.
+*/
+typedef struct pkt_cell_t {
+    atomic_size_t seq;
+    AVPacket      pkt;
+    int64_t       ts;
+    int           gap;            /*new packets were dropped before it*/
+} pkt_cell_t;
+
+struct pkt_queue_t {
+    pkt_cell_t         *cells;
+    size_t             mask;
+    pkt_queue_policy_t policy;
+
+    /*producer and consumer positions on their own cache lines*/
+    _Alignas(64) atomic_size_t enqueue_pos;
+    int                dropping;       /*PKT_QUEUE_DROP_UNTIL_KEY state*/
+    int                gap;            /*a new packet was dropped since the last push*/
+    size_t             key_pos;        /*of the last keyframe pushed*/
+    int                has_key;
+    int                max_occupancy;
+    uint64_t           nb_pushed;
+    atomic_ullong      nb_dropped;
+    uint64_t           nb_full;
+
+    _Alignas(64) atomic_size_t dequeue_pos;
+    atomic_ullong      nb_popped;
+    size_t             next_pop;       /*consumer only: the position after its last pop*/
+};
+
+static const char *policy_names[PKT_QUEUE_POLICY_MAX] = {
+    "block",
+    "drop",
+    "key",
+};
+
+pkt_queue_t *pkt_queue_alloc(int depth, pkt_queue_policy_t policy) {
+    pkt_queue_t *q;
+    size_t size = 2;
+    size_t i;
+
+    if (depth <= 0 || policy >= PKT_QUEUE_POLICY_MAX) {
+        printf("invalid packet queue: depth(%d), policy(%d)\n", depth, policy);
+        return NULL;
+    }
+
+    while (size < (size_t)depth) {
+        size <<= 1;
+    }
+
+    if (posix_memalign((void **)&q, 64, sizeof(pkt_queue_t))) {
+        printf("failed to malloc pkt_queue_t\n");
+        return NULL;
+    }
+    memset(q, 0, sizeof(pkt_queue_t));
+
+    q->cells = (pkt_cell_t *)calloc(size, sizeof(pkt_cell_t));
+    if (q->cells == NULL) {
+        printf("failed to malloc %zu packet cells\n", size);
+        free(q);
+        return NULL;
+    }
+
+    for (i = 0; i < size; i++) {
+        atomic_init(&q->cells[i].seq, i);
+        av_init_packet(&q->cells[i].pkt);
+        q->cells[i].pkt.data = NULL;
+        q->cells[i].pkt.size = 0;
+    }
+
+    q->mask   = size - 1;
+    q->policy = policy;
+    atomic_init(&q->enqueue_pos, 0);
+    atomic_init(&q->dequeue_pos, 0);
+    atomic_init(&q->nb_dropped, 0);
+    atomic_init(&q->nb_popped, 0);
+
+    return q;
+}
+
+void pkt_queue_free(pkt_queue_t **q) {
+    AVPacket pkt;
+
+    if (!q || !*q) {
+        return;
+    }
+
+    while (pkt_queue_pop(*q, &pkt, NULL) == 0) {
+        av_packet_unref(&pkt);
+    }
+
+    free((*q)->cells);
+    free(*q);
+    *q = NULL;
+}
+
+/*
+*   pos: the position of the popped packet
+*   gap: the gap flag of the packet
+*/
+static int queue_pop(pkt_queue_t *q, AVPacket *pkt, int64_t *ts, size_t *pos_out, int *gap) {
+    pkt_cell_t *cell;
+    size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    size_t seq;
+    intptr_t dif;
+
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        seq  = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        dif  = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            return AVERROR(EAGAIN);
+        } else {
+            pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    av_packet_move_ref(pkt, &cell->pkt);
+    if (ts) {
+        *ts = cell->ts;
+    }
+    *gap = cell->gap;
+    *pos_out = pos;
+    atomic_store_explicit(&cell->seq, pos + q->mask + 1, memory_order_release);
+    atomic_fetch_add_explicit(&q->nb_popped, 1, memory_order_relaxed);
+
+    return 0;
+}
+
+int pkt_queue_pop(pkt_queue_t *q, AVPacket *pkt, int64_t *ts) {
+    size_t pos;
+    int gap;
+
+    if (queue_pop(q, pkt, ts, &pos, &gap) < 0) {
+        return AVERROR(EAGAIN);
+    }
+
+    /*the positions in between were dropped by the producer*/
+    gap |= pos != q->next_pop;
+    q->next_pop = pos + 1;
+
+    return gap ? PKT_QUEUE_GAP : 0;
+}
+
+/*
+* called by the producer to make room in the drop policies
+*   return 0 if a packet is dropped, -1 if the ring is empty
+*/
+static int drop_oldest(pkt_queue_t *q) {
+    AVPacket pkt;
+    size_t pos;
+    int gap;
+
+    if (queue_pop(q, &pkt, NULL, &pos, &gap) < 0) {
+        return -1;
+    }
+
+    av_packet_unref(&pkt);
+    atomic_fetch_sub_explicit(&q->nb_popped, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&q->nb_dropped, 1, memory_order_relaxed);
+
+    return 0;
+}
+
+/*
+* make room for the keyframe at pos: the GOPs before the last queued
+* keyframe are dropped, and all the queued packets if that one is the
+* oldest. The decoder never gets the rest of a GOP without its start.
+*/
+static void drop_gops(pkt_queue_t *q, size_t pos) {
+    size_t tail = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    size_t end = pos;
+
+    if (q->has_key && (intptr_t)(q->key_pos - tail) > 0) {
+        end = q->key_pos;
+    }
+
+    while ((intptr_t)(end - atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed)) > 0 &&
+           drop_oldest(q) == 0) {
+    }
+}
+
+static void drop_packet(pkt_queue_t *q, AVPacket *pkt) {
+    av_packet_unref(pkt);
+    atomic_fetch_add_explicit(&q->nb_dropped, 1, memory_order_relaxed);
+    q->gap = 1;
+}
+
+int pkt_queue_push(pkt_queue_t *q, AVPacket *pkt, int64_t ts) {
+    pkt_cell_t *cell;
+    size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    size_t seq;
+    int occupancy;
+    int is_full = 0;
+    int is_key = !!(pkt->flags & AV_PKT_FLAG_KEY);
+
+    if (q->dropping) {
+        if (!is_key) {
+            drop_packet(q, pkt);
+            return 1;
+        }
+
+        /*the keyframe starts a new GOP, the queued packets are not needed
+          to decode it, so make room for it at the cost of the old GOPs*/
+        q->dropping = 0;
+    }
+
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        seq  = atomic_load_explicit(&cell->seq, memory_order_acquire);
+
+        if (seq == pos) {
+            break;
+        }
+
+        /*full*/
+        if (!is_full) {
+            is_full = 1;
+            q->nb_full++;
+        }
+
+        switch (q->policy) {
+            case PKT_QUEUE_BLOCK:
+                return AVERROR(EAGAIN);
+
+            case PKT_QUEUE_DROP_OLDEST:
+                drop_oldest(q);
+                break;
+
+            case PKT_QUEUE_DROP_UNTIL_KEY:
+            default:
+                if (!is_key) {
+                    q->dropping = 1;
+                    drop_packet(q, pkt);
+                    return 1;
+                }
+                drop_gops(q, pos);
+                break;
+        }
+    }
+
+    if (is_key) {
+        q->key_pos = pos;
+        q->has_key = 1;
+    }
+
+    av_packet_move_ref(&cell->pkt, pkt);
+    cell->ts  = ts;
+    cell->gap = q->gap;
+    q->gap    = 0;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    atomic_store_explicit(&q->enqueue_pos, pos + 1, memory_order_relaxed);
+    q->nb_pushed++;
+
+    occupancy = pkt_queue_occupancy(q);
+    if (occupancy > q->max_occupancy) {
+        q->max_occupancy = occupancy;
+    }
+
+    return 0;
+}
+
+int pkt_queue_occupancy(pkt_queue_t *q) {
+    size_t head = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    intptr_t n = (intptr_t)(head - tail);
+
+    if (n < 0) {
+        return 0;
+    }
+
+    return n > (intptr_t)(q->mask + 1) ? (int)(q->mask + 1) : (int)n;
+}
+
+void pkt_queue_get_stats(pkt_queue_t *q, pkt_queue_stats_t *stats) {
+    stats->depth         = q->mask + 1;
+    stats->occupancy     = pkt_queue_occupancy(q);
+    stats->max_occupancy = q->max_occupancy;
+    stats->nb_pushed     = q->nb_pushed;
+    stats->nb_popped     = atomic_load_explicit(&q->nb_popped, memory_order_relaxed);
+    stats->nb_dropped    = atomic_load_explicit(&q->nb_dropped, memory_order_relaxed);
+    stats->nb_full       = q->nb_full;
+}
+
+const char *pkt_queue_policy_name(pkt_queue_policy_t policy) {
+    if (policy >= PKT_QUEUE_POLICY_MAX) {
+        return "unknown";
+    }
+
+    return policy_names[policy];
+}
+
+pkt_queue_policy_t pkt_queue_policy_from_name(const char *name) {
+    int i;
+
+    for (i = 0; i < PKT_QUEUE_POLICY_MAX; i++) {
+        if (!strcmp(name, policy_names[i])) {
+            return (pkt_queue_policy_t)i;
+        }
+    }
+
+    return PKT_QUEUE_POLICY_MAX;
+}
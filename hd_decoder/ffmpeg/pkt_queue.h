@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: pkt_queue.h
+*
+* PURPOSE: bounded lock-free packet ring between the demux and decode stages
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Drop whole GOPs and report the gaps to the consumer
+************************************************************************/
+
+#ifndef __PKT_QUEUE_H_
+#define __PKT_QUEUE_H_
+
+#include <stdint.h>
+
+#include <libavcodec/avcodec.h>
+
+/*what pkt_queue_push() does when the ring is full*/
+typedef enum {
+    PKT_QUEUE_BLOCK = 0,       /*refuse the packet, the producer retries later*/
+    PKT_QUEUE_DROP_OLDEST,     /*drop the oldest queued packet*/
+    PKT_QUEUE_DROP_UNTIL_KEY,  /*drop the new packets until the next keyframe, which
+                                 drops the GOPs before it if the ring is still full*/
+
+    PKT_QUEUE_POLICY_MAX
+} pkt_queue_policy_t;
+
+/*pkt_queue_pop(): packets were dropped before the popped one*/
+#define PKT_QUEUE_GAP 1
+
+typedef struct pkt_queue_stats_t {
+    int      depth;
+    int      occupancy;       /*packets in the ring now*/
+    int      max_occupancy;   /*high-water mark*/
+
+    uint64_t nb_pushed;
+    uint64_t nb_popped;
+    uint64_t nb_dropped;
+    uint64_t nb_full;         /*times a push found the ring full*/
+} pkt_queue_stats_t;
+
+typedef struct pkt_queue_t pkt_queue_t;
+
+/*
+* Allocate the ring, depth is rounded up to a power of 2
+*/
+pkt_queue_t *pkt_queue_alloc(int depth, pkt_queue_policy_t policy);
+
+/*
+* Free the ring and the packets left in it
+*/
+void pkt_queue_free(pkt_queue_t **q);
+
+/*
+* Producer side, only one thread at a time
+*   ts: timestamp carried with the packet, e.g. the time it arrived
+*   return 0:               the packet reference is moved into the ring
+*          1:               the packet is dropped by the policy and unreferenced
+*          AVERROR(EAGAIN): full in PKT_QUEUE_BLOCK policy, pkt is untouched
+*/
+int pkt_queue_push(pkt_queue_t *q, AVPacket *pkt, int64_t ts);
+
+/*
+* Consumer side
+*   ts: the timestamp pushed with the packet, may be NULL
+*   return 0:               the oldest packet reference is moved into pkt
+*          PKT_QUEUE_GAP:   the same, but packets were dropped before it,
+*                           the decoder has to restart at a keyframe
+*          AVERROR(EAGAIN): the ring is empty
+*/
+int pkt_queue_pop(pkt_queue_t *q, AVPacket *pkt, int64_t *ts);
+
+/*
+* Approximate number of queued packets, safe from any thread
+*/
+int pkt_queue_occupancy(pkt_queue_t *q);
+
+void pkt_queue_get_stats(pkt_queue_t *q, pkt_queue_stats_t *stats);
+
+const char *pkt_queue_policy_name(pkt_queue_policy_t policy);
+
+/*
+* "block", "drop" or "key", PKT_QUEUE_POLICY_MAX if unknown
+*/
+pkt_queue_policy_t pkt_queue_policy_from_name(const char *name);
+
+#endif /* __PKT_QUEUE_H_ */
@@ -0,0 +1,422 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: probe_cache.c
+*
+* PURPOSE: cache of the probed video codec parameters of the streams in a
+*          local file, keyed by url, to open the known streams quickly
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   The cache file is readable by its owner only
+************************************************************************/
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <pthread.h>
+
+#include <libavutil/pixdesc.h>
+
+#include "probe_cache.h"
+
+/*
+The file has one stream per line:
+    codec width height pix_fmt profile level sar field_order color_range
+    color_primaries color_trc color_space chroma_location extradata url
+The extradata is in hex, '-' if there is none. The url is the rest of the
+line. Codec and pixel format are saved by name, their ids may differ in
+another build of ffmpeg.
+*/
+#define CACHE_VERSION_LINE "# probe cache v1"
+
+typedef struct cache_entry_t {
+    char              *url;
+    AVCodecParameters *par;
+} cache_entry_t;
+
+struct probe_cache_t {
+    char            *path;
+    cache_entry_t   *entries;
+    int             nb_entries;
+    int             size;
+
+    pthread_mutex_t lock;
+};
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+static int parse_extradata(AVCodecParameters *par, const char *hex) {
+    int len = strlen(hex);
+    int hi, lo;
+    int i;
+
+    if (!strcmp(hex, "-")) {
+        return 0;
+    }
+
+    if (len % 2) {
+        return -1;
+    }
+
+    par->extradata = (uint8_t *)av_mallocz(len / 2 + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!par->extradata) {
+        return -1;
+    }
+    par->extradata_size = len / 2;
+
+    for (i = 0; i < len / 2; i++) {
+        hi = hex_value(hex[2 * i]);
+        lo = hex_value(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            return -1;
+        }
+        par->extradata[i] = (hi << 4) | lo;
+    }
+
+    return 0;
+}
+
+/*
+* return the parameters of the line and its url in *url, NULL if it is invalid
+*/
+static AVCodecParameters *parse_line(char *line, char **url) {
+    const AVCodecDescriptor *desc;
+    AVCodecParameters *par;
+    char codec[64];
+    char pix_fmt[64];
+    char *hex;
+    int field_order, color_range, color_primaries, color_trc, color_space, chroma_location;
+    int url_pos = 0;
+    int hex_pos = 0;
+    int hex_end = 0;
+
+    par = avcodec_parameters_alloc();
+    if (!par) {
+        return NULL;
+    }
+
+    if (sscanf(line, "%63s %d %d %63s %d %d %d:%d %d %d %d %d %d %d %n%*s%n %n",
+               codec, &par->width, &par->height, pix_fmt, &par->profile, &par->level,
+               &par->sample_aspect_ratio.num, &par->sample_aspect_ratio.den,
+               &field_order, &color_range, &color_primaries, &color_trc,
+               &color_space, &chroma_location,
+               &hex_pos, &hex_end, &url_pos) != 14 || !url_pos || !line[url_pos]) {
+        avcodec_parameters_free(&par);
+        return NULL;
+    }
+
+    desc = avcodec_descriptor_get_by_name(codec);
+    if (!desc || desc->type != AVMEDIA_TYPE_VIDEO) {
+        avcodec_parameters_free(&par);
+        return NULL;
+    }
+
+    par->codec_type = AVMEDIA_TYPE_VIDEO;
+    par->codec_id   = desc->id;
+    par->format     = strcmp(pix_fmt, "-") ? av_get_pix_fmt(pix_fmt) : AV_PIX_FMT_NONE;
+    par->field_order     = field_order;
+    par->color_range     = color_range;
+    par->color_primaries = color_primaries;
+    par->color_trc       = color_trc;
+    par->color_space     = color_space;
+    par->chroma_location = chroma_location;
+
+    hex = line + hex_pos;
+    hex[hex_end - hex_pos] = '\0';
+    if (parse_extradata(par, hex) < 0) {
+        avcodec_parameters_free(&par);
+        return NULL;
+    }
+
+    *url = line + url_pos;
+
+    return par;
+}
+
+static int add_entry(probe_cache_t *cache, const char *url, AVCodecParameters *par) {
+    cache_entry_t *entries;
+    int size;
+
+    if (cache->nb_entries == cache->size) {
+        size = cache->size ? cache->size * 2 : 16;
+        entries = (cache_entry_t *)realloc(cache->entries, size * sizeof(cache_entry_t));
+        if (entries == NULL) {
+            printf("failed to malloc %d probe cache entries\n", size);
+            return -1;
+        }
+        cache->entries = entries;
+        cache->size    = size;
+    }
+
+    cache->entries[cache->nb_entries].url = strdup(url);
+    if (!cache->entries[cache->nb_entries].url) {
+        return -1;
+    }
+    cache->entries[cache->nb_entries].par = par;
+    cache->nb_entries++;
+
+    return 0;
+}
+
+static cache_entry_t *find_entry(probe_cache_t *cache, const char *url) {
+    int i;
+
+    for (i = 0; i < cache->nb_entries; i++) {
+        if (!strcmp(cache->entries[i].url, url)) {
+            return &cache->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+probe_cache_t *probe_cache_load(const char *path) {
+    probe_cache_t *cache;
+    AVCodecParameters *par;
+    cache_entry_t *entry;
+    FILE *fp;
+    char *line = NULL;
+    size_t line_size = 0;
+    ssize_t len;
+    char *url;
+    int nb_invalid = 0;
+
+    cache = (probe_cache_t *)malloc(sizeof(probe_cache_t));
+    if (cache == NULL) {
+        printf("failed to malloc probe_cache_t\n");
+        return NULL;
+    }
+
+    memset(cache, 0, sizeof(probe_cache_t));
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->path = strdup(path);
+    if (!cache->path) {
+        probe_cache_free(&cache);
+        return NULL;
+    }
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        if (errno != ENOENT) {
+            printf("failed to open the probe cache: %s(error: %s)\n", path, strerror(errno));
+            probe_cache_free(&cache);
+            return NULL;
+        }
+
+        printf("probe cache %s: empty\n", path);
+        return cache;
+    }
+
+    while ((len = getline(&line, &line_size, fp)) >= 0) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[--len] = '\0';
+        }
+
+        if (len == 0 || line[0] == '#') {
+            continue;
+        }
+
+        par = parse_line(line, &url);
+        if (!par) {
+            nb_invalid++;
+            continue;
+        }
+
+        /*the later line of the same url wins*/
+        entry = find_entry(cache, url);
+        if (entry) {
+            avcodec_parameters_free(&entry->par);
+            entry->par = par;
+        } else if (add_entry(cache, url, par) < 0) {
+            avcodec_parameters_free(&par);
+            break;
+        }
+    }
+
+    free(line);
+    fclose(fp);
+
+    printf("probe cache %s: %d streams, %d invalid lines\n", path, cache->nb_entries, nb_invalid);
+
+    return cache;
+}
+
+void probe_cache_free(probe_cache_t **cache) {
+    int i;
+
+    if (!cache || !*cache) {
+        return;
+    }
+
+    for (i = 0; i < (*cache)->nb_entries; i++) {
+        free((*cache)->entries[i].url);
+        avcodec_parameters_free(&(*cache)->entries[i].par);
+    }
+
+    pthread_mutex_destroy(&(*cache)->lock);
+    free((*cache)->entries);
+    free((*cache)->path);
+    free(*cache);
+    *cache = NULL;
+}
+
+AVCodecParameters *probe_cache_get(probe_cache_t *cache, const char *url) {
+    AVCodecParameters *par = NULL;
+    cache_entry_t *entry;
+
+    pthread_mutex_lock(&cache->lock);
+
+    entry = find_entry(cache, url);
+    if (entry) {
+        par = avcodec_parameters_alloc();
+        if (par && avcodec_parameters_copy(par, entry->par) < 0) {
+            avcodec_parameters_free(&par);
+        }
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return par;
+}
+
+static void write_entry(FILE *fp, const cache_entry_t *entry) {
+    const AVCodecParameters *par = entry->par;
+    const char *pix_fmt = av_get_pix_fmt_name(par->format);
+    int i;
+
+    fprintf(fp, "%s %d %d %s %d %d %d:%d %d %d %d %d %d %d ",
+            avcodec_get_name(par->codec_id), par->width, par->height,
+            pix_fmt ? pix_fmt : "-", par->profile, par->level,
+            par->sample_aspect_ratio.num, par->sample_aspect_ratio.den,
+            par->field_order, par->color_range, par->color_primaries,
+            par->color_trc, par->color_space, par->chroma_location);
+
+    if (par->extradata_size > 0) {
+        for (i = 0; i < par->extradata_size; i++) {
+            fprintf(fp, "%02x", par->extradata[i]);
+        }
+    } else {
+        fprintf(fp, "-");
+    }
+
+    fprintf(fp, " %s\n", entry->url);
+}
+
+/*
+* Write a new file and rename it, a crash never leaves half of the file.
+* The urls may carry the passwords of the cameras, only the owner reads it
+*/
+static int save_cache(probe_cache_t *cache) {
+    char tmp_path[1024];
+    FILE *fp;
+    int fd;
+    int i;
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache->path);
+
+    fd = open(tmp_path, O_CREAT | O_WRONLY | O_TRUNC, 0600);
+    if (fd < 0 || fchmod(fd, 0600) < 0 || (fp = fdopen(fd, "w")) == NULL) {
+        printf("failed to create the probe cache: %s(error: %s)\n", tmp_path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    fprintf(fp, "%s\n", CACHE_VERSION_LINE);
+    for (i = 0; i < cache->nb_entries; i++) {
+        write_entry(fp, &cache->entries[i]);
+    }
+
+    if (fclose(fp) != 0 || rename(tmp_path, cache->path) < 0) {
+        printf("failed to save the probe cache: %s(error: %s)\n", cache->path, strerror(errno));
+        remove(tmp_path);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int same_params(const AVCodecParameters *a, const AVCodecParameters *b) {
+    return a->codec_id == b->codec_id &&
+           a->width == b->width && a->height == b->height &&
+           a->format == b->format &&
+           a->profile == b->profile && a->level == b->level &&
+           a->extradata_size == b->extradata_size &&
+           (!a->extradata_size || !memcmp(a->extradata, b->extradata, a->extradata_size));
+}
+
+int probe_cache_put(probe_cache_t *cache, const char *url, const AVCodecParameters *par) {
+    AVCodecParameters *copy;
+    cache_entry_t *entry;
+    int ret = 0;
+
+    /*the url is the rest of a line*/
+    if (strchr(url, '\n') || strchr(url, '\r')) {
+        return -1;
+    }
+
+    copy = avcodec_parameters_alloc();
+    if (!copy || avcodec_parameters_copy(copy, par) < 0) {
+        avcodec_parameters_free(&copy);
+        return -1;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+
+    entry = find_entry(cache, url);
+    if (entry && same_params(entry->par, copy)) {
+        avcodec_parameters_free(&copy);
+    } else {
+        if (entry) {
+            avcodec_parameters_free(&entry->par);
+            entry->par = copy;
+        } else if (add_entry(cache, url, copy) < 0) {
+            avcodec_parameters_free(&copy);
+            ret = -1;
+        }
+
+        if (ret == 0) {
+            ret = save_cache(cache);
+        }
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return ret;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: probe_cache.h
+*
+* PURPOSE: cache of the probed video codec parameters of the streams in a
+*          local file, keyed by url, to open the known streams quickly
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#ifndef __PROBE_CACHE_H_
+#define __PROBE_CACHE_H_
+
+#include <libavcodec/avcodec.h>
+
+typedef struct probe_cache_t probe_cache_t;
+
+/*
+* Read the cache file, it is created by the first probe_cache_put()
+* if it does not exist
+*/
+probe_cache_t *probe_cache_load(const char *path);
+
+void probe_cache_free(probe_cache_t **cache);
+
+/*
+* The cached parameters of the url, safe from any thread
+*   return a copy to be freed by avcodec_parameters_free(), NULL if not cached
+*/
+AVCodecParameters *probe_cache_get(probe_cache_t *cache, const char *url);
+
+/*
+* Cache the parameters of the url and save the file if they changed,
+* safe from any thread
+*   return 0 on success, -1 on failure
+*/
+int probe_cache_put(probe_cache_t *cache, const char *url, const AVCodecParameters *par);
+
+#endif /* __PROBE_CACHE_H_ */
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: stats_sink.c
+*
+* PURPOSE: write the stats as JSON lines into a file or a unix socket
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include "stats_sink.h"
+
+#define UNIX_PREFIX "unix:"
+
+struct stats_sink_t {
+    char     *path;
+    int      is_socket;
+    int      fd;                /*-1: the socket is not connected*/
+
+    uint64_t nb_lines;
+    uint64_t nb_dropped;
+};
+
+static int connect_socket(stats_sink_t *sink) {
+    struct sockaddr_un addr;
+    int fd;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sink->path, sizeof(addr.sun_path) - 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        printf("failed to create the stats socket(error: %s)\n", strerror(errno));
+        return -1;
+    }
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    sink->fd = fd;
+
+    return 0;
+}
+
+stats_sink_t *stats_sink_open(const char *target) {
+    stats_sink_t *sink;
+    int is_socket = !strncmp(target, UNIX_PREFIX, strlen(UNIX_PREFIX));
+
+    sink = (stats_sink_t *)malloc(sizeof(stats_sink_t));
+    if (sink == NULL) {
+        printf("failed to malloc stats_sink_t\n");
+        return NULL;
+    }
+
+    memset(sink, 0, sizeof(stats_sink_t));
+    sink->is_socket = is_socket;
+    sink->path      = strdup(is_socket ? target + strlen(UNIX_PREFIX) : target);
+    sink->fd        = -1;
+
+    if (!sink->path) {
+        printf("failed to malloc stats_sink_t\n");
+        free(sink);
+        return NULL;
+    }
+
+    if (is_socket) {
+        if (strlen(sink->path) >= sizeof(((struct sockaddr_un *)0)->sun_path)) {
+            printf("too long path of the stats socket: %s\n", sink->path);
+            stats_sink_close(&sink);
+            return NULL;
+        }
+
+        /*the peer may start later, the lines are dropped until then*/
+        if (connect_socket(sink) < 0) {
+            printf("the stats socket %s is not ready(error: %s), connect it later\n",
+                    sink->path, strerror(errno));
+        }
+    } else {
+        sink->fd = open(sink->path, O_CREAT | O_APPEND | O_WRONLY | O_CLOEXEC, 0644);
+        if (sink->fd < 0) {
+            printf("failed to open the stats file: %s(error: %s)\n",
+                    sink->path, strerror(errno));
+            stats_sink_close(&sink);
+            return NULL;
+        }
+    }
+
+    return sink;
+}
+
+void stats_sink_close(stats_sink_t **sink) {
+    if (!sink || !*sink) {
+        return;
+    }
+
+    if ((*sink)->fd >= 0) {
+        close((*sink)->fd);
+    }
+
+    free((*sink)->path);
+    free(*sink);
+    *sink = NULL;
+}
+
+static int write_socket(stats_sink_t *sink, const char *line, int len) {
+    struct msghdr msg;
+    struct iovec iov[2];
+    ssize_t n;
+
+    if (sink->fd < 0 && connect_socket(sink) < 0) {
+        return -1;
+    }
+
+    iov[0].iov_base = (void *)line;
+    iov[0].iov_len  = len;
+    iov[1].iov_base = "\n";
+    iov[1].iov_len  = 1;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = 2;
+
+    n = sendmsg(sink->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n == len + 1) {
+        return 0;
+    }
+
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        /*the reader is slow, nothing of the line was sent*/
+        return -1;
+    }
+
+    /*the peer is gone, or a part of the line was sent and the rest would
+      break the next line: start over on a new connection*/
+    close(sink->fd);
+    sink->fd = -1;
+
+    return -1;
+}
+
+static int write_file(stats_sink_t *sink, const char *line, int len) {
+    struct iovec iov[2];
+
+    iov[0].iov_base = (void *)line;
+    iov[0].iov_len  = len;
+    iov[1].iov_base = "\n";
+    iov[1].iov_len  = 1;
+
+    /*O_APPEND: a line is written in one piece by one writev()*/
+    if (writev(sink->fd, iov, 2) != len + 1) {
+        printf("failed to write the stats file: %s(error: %s)\n",
+                sink->path, strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
+int stats_sink_write(stats_sink_t *sink, const char *line, int len) {
+    int ret;
+
+    if (sink->is_socket) {
+        ret = write_socket(sink, line, len);
+    } else {
+        ret = write_file(sink, line, len);
+    }
+
+    if (ret < 0) {
+        sink->nb_dropped++;
+    } else {
+        sink->nb_lines++;
+    }
+
+    return ret;
+}
+
+void stats_sink_get_stats(stats_sink_t *sink, stats_sink_stats_t *stats) {
+    stats->nb_lines   = sink->nb_lines;
+    stats->nb_dropped = sink->nb_dropped;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: stats_sink.h
+*
+* PURPOSE: write the stats as JSON lines into a file or a unix socket
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#ifndef __STATS_SINK_H_
+#define __STATS_SINK_H_
+
+#include <stdint.h>
+
+typedef struct stats_sink_stats_t {
+    uint64_t nb_lines;        /*written*/
+    uint64_t nb_dropped;      /*the socket was not connected or was full*/
+} stats_sink_stats_t;
+
+typedef struct stats_sink_t stats_sink_t;
+
+/*
+* target: path of a file, the lines are appended to it,
+*         or unix:<path> of a listening stream socket, it is connected
+*         again after the peer goes away
+*/
+stats_sink_t *stats_sink_open(const char *target);
+
+void stats_sink_close(stats_sink_t **sink);
+
+/*
+* Write one line, a '\n' is appended. It never blocks on a socket, the
+* line is dropped if the socket can not take all of it
+*   return 0 on success, -1 if the line is dropped
+*/
+int stats_sink_write(stats_sink_t *sink, const char *line, int len);
+
+void stats_sink_get_stats(stats_sink_t *sink, stats_sink_stats_t *stats);
+
+#endif /* __STATS_SINK_H_ */
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: stream_analyzer.c
+*
+* PURPOSE: statistics of a video stream from the NAL units of its
+*          demuxed packets, nothing is decoded
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   The jitter is of the reads, the totals include the window
+************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "stream_analyzer.h"
+#include "nal_parse.h"
+#include "hdr_hist.h"
+
+#define JITTER_MAX_US (10LL * 1000000)
+
+typedef struct analyzer_counters_t {
+    uint64_t        nb_packets;
+    uint64_t        nb_bytes;
+    int64_t         duration_us;    /*sum of the dts intervals*/
+    uint64_t        nb_frames[AV_PICTURE_TYPE_B + 1];
+    uint64_t        nb_keyframes;
+    uint64_t        nb_gops;
+    uint64_t        gop_frames;     /*of the counted GOPs*/
+    int             gop_min;
+    int             gop_max;
+    int             gop_last;
+    uint64_t        nb_ts_errors;
+    hdr_hist_t      *jitter;
+} analyzer_counters_t;
+
+/*
+The packets are only seen by the demux job of the stream, the counters
+are locked for the reporter. The cost of a packet is the scan of its NAL
+headers and the first bytes of a slice header.
+*/
+struct stream_analyzer_t {
+    int             id;
+    nal_parser_t    parser;
+    int             has_parser;
+    AVRational      time_base;
+
+    int64_t         last_dts;       /*AV_NOPTS_VALUE: none*/
+    int64_t         last_us;        /*read of the previous packet, 0: none*/
+    int             gop_frames;     /*since the last keyframe, -1: no keyframe yet*/
+
+    pthread_mutex_t lock;
+    double          jitter_us;
+    analyzer_counters_t window;
+    analyzer_counters_t total;      /*until the last roll*/
+    analyzer_counters_t report;     /*total and window of get_stats()*/
+};
+
+static void reset_counters(analyzer_counters_t *c) {
+    hdr_hist_t *jitter = c->jitter;
+
+    memset(c, 0, sizeof(analyzer_counters_t));
+    c->jitter = jitter;
+    hdr_hist_reset(jitter);
+}
+
+static void merge_counters(analyzer_counters_t *dst, const analyzer_counters_t *src) {
+    int i;
+
+    if (src->nb_gops) {
+        if (!dst->nb_gops || src->gop_min < dst->gop_min) {
+            dst->gop_min = src->gop_min;
+        }
+        if (src->gop_max > dst->gop_max) {
+            dst->gop_max = src->gop_max;
+        }
+        dst->gop_last = src->gop_last;
+    }
+
+    dst->nb_packets   += src->nb_packets;
+    dst->nb_bytes     += src->nb_bytes;
+    dst->duration_us  += src->duration_us;
+    dst->nb_keyframes += src->nb_keyframes;
+    dst->nb_gops      += src->nb_gops;
+    dst->gop_frames   += src->gop_frames;
+    dst->nb_ts_errors += src->nb_ts_errors;
+    for (i = 0; i <= AV_PICTURE_TYPE_B; i++) {
+        dst->nb_frames[i] += src->nb_frames[i];
+    }
+
+    hdr_hist_merge(dst->jitter, src->jitter);
+}
+
+stream_analyzer_t *stream_analyzer_alloc(int id) {
+    stream_analyzer_t *an = (stream_analyzer_t *)calloc(1, sizeof(stream_analyzer_t));
+
+    if (!an) {
+        printf("[%d] failed to malloc the stream analyzer\n", id);
+        return NULL;
+    }
+
+    an->id         = id;
+    an->last_dts   = AV_NOPTS_VALUE;
+    an->gop_frames = -1;
+    an->window.jitter = hdr_hist_alloc(JITTER_MAX_US);
+    an->total.jitter  = hdr_hist_alloc(JITTER_MAX_US);
+    an->report.jitter = hdr_hist_alloc(JITTER_MAX_US);
+    if (!an->window.jitter || !an->total.jitter || !an->report.jitter) {
+        printf("[%d] failed to malloc the jitter histograms\n", id);
+        hdr_hist_free(&an->window.jitter);
+        hdr_hist_free(&an->total.jitter);
+        hdr_hist_free(&an->report.jitter);
+        free(an);
+        return NULL;
+    }
+    pthread_mutex_init(&an->lock, NULL);
+
+    return an;
+}
+
+void stream_analyzer_free(stream_analyzer_t **an) {
+    if (!*an) {
+        return;
+    }
+
+    hdr_hist_free(&(*an)->window.jitter);
+    hdr_hist_free(&(*an)->total.jitter);
+    hdr_hist_free(&(*an)->report.jitter);
+    pthread_mutex_destroy(&(*an)->lock);
+    free(*an);
+    *an = NULL;
+}
+
+int stream_analyzer_set_stream(stream_analyzer_t *an, const AVCodecParameters *par,
+                               AVRational time_base) {
+    an->has_parser = !nal_parser_init(&an->parser, par);
+    if (!an->has_parser) {
+        printf("[%d] %s: the frame types are not parsed, the key packets are the keyframes\n",
+                an->id, avcodec_get_name(par->codec_id));
+    }
+
+    /*the timestamps and the GOP start over*/
+    an->time_base  = time_base;
+    an->last_dts   = AV_NOPTS_VALUE;
+    an->last_us    = 0;
+    an->gop_frames = -1;
+
+    return 0;
+}
+
+void stream_analyzer_add_packet(stream_analyzer_t *an, const AVPacket *pkt, int64_t read_us) {
+    analyzer_counters_t *c = &an->window;
+    enum AVPictureType type = AV_PICTURE_TYPE_NONE;
+    int64_t dts = pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+    int64_t interval_us = 0;
+    int64_t diff_us = -1;
+    int ts_error = 0;
+    int key;
+
+    if (an->has_parser) {
+        type = nal_packet_picture_type(&an->parser, pkt->data, pkt->size);
+        key  = nal_packet_is_irap(&an->parser, pkt->data, pkt->size);
+    } else {
+        key  = !!(pkt->flags & AV_PKT_FLAG_KEY);
+        if (key) {
+            type = AV_PICTURE_TYPE_I;
+        }
+    }
+
+    /*the interval of the stream time against the one of the reads*/
+    if (an->last_us) {
+        if (dts != AV_NOPTS_VALUE && an->last_dts != AV_NOPTS_VALUE && dts > an->last_dts) {
+            interval_us = av_rescale_q(dts - an->last_dts, an->time_base, AV_TIME_BASE_Q);
+            diff_us = llabs(read_us - an->last_us - interval_us);
+        } else {
+            ts_error = 1;
+        }
+    }
+    if (dts != AV_NOPTS_VALUE) {
+        an->last_dts = dts;
+    }
+    an->last_us = read_us;
+
+    pthread_mutex_lock(&an->lock);
+
+    c->nb_packets++;
+    c->nb_bytes += pkt->size;
+    c->duration_us += interval_us;
+    c->nb_frames[type]++;
+    c->nb_ts_errors += ts_error;
+
+    if (diff_us >= 0) {
+        hdr_hist_record(c->jitter, diff_us);
+        an->jitter_us += (diff_us - an->jitter_us) / 16;
+    }
+
+    if (key) {
+        if (an->gop_frames > 0) {
+            if (!c->nb_gops || an->gop_frames < c->gop_min) {
+                c->gop_min = an->gop_frames;
+            }
+            if (an->gop_frames > c->gop_max) {
+                c->gop_max = an->gop_frames;
+            }
+            c->gop_last    = an->gop_frames;
+            c->gop_frames += an->gop_frames;
+            c->nb_gops++;
+        }
+        c->nb_keyframes++;
+        an->gop_frames = 0;
+    }
+    if (an->gop_frames >= 0) {
+        an->gop_frames++;
+    }
+
+    pthread_mutex_unlock(&an->lock);
+}
+
+void stream_analyzer_get_stats(stream_analyzer_t *an, stream_analyzer_stats_t *stats,
+                               int total) {
+    analyzer_counters_t *c = &an->window;
+    int i;
+
+    memset(stats, 0, sizeof(stream_analyzer_stats_t));
+
+    pthread_mutex_lock(&an->lock);
+
+    if (total) {
+        c = &an->report;
+        reset_counters(c);
+        merge_counters(c, &an->total);
+        merge_counters(c, &an->window);
+    }
+
+    stats->nb_packets   = c->nb_packets;
+    stats->nb_bytes     = c->nb_bytes;
+    stats->seconds      = c->duration_us / 1000000.0;
+    stats->nb_keyframes = c->nb_keyframes;
+    stats->nb_gops      = c->nb_gops;
+    stats->gop_min      = c->gop_min;
+    stats->gop_max      = c->gop_max;
+    stats->gop_last     = c->gop_last;
+    stats->nb_ts_errors = c->nb_ts_errors;
+    for (i = 0; i <= AV_PICTURE_TYPE_B; i++) {
+        stats->nb_frames[i] = c->nb_frames[i];
+    }
+
+    if (c->duration_us > 0) {
+        stats->bitrate = c->nb_bytes * 8 / stats->seconds;
+        stats->fps     = c->nb_packets / stats->seconds;
+    }
+    if (c->nb_gops) {
+        stats->gop_mean = (double)c->gop_frames / c->nb_gops;
+    }
+
+    stats->read_jitter_us     = an->jitter_us;
+    stats->read_jitter_p50_us = hdr_hist_percentile(c->jitter, 50);
+    stats->read_jitter_p99_us = hdr_hist_percentile(c->jitter, 99);
+    stats->read_jitter_max_us = hdr_hist_max(c->jitter);
+
+    pthread_mutex_unlock(&an->lock);
+}
+
+void stream_analyzer_roll(stream_analyzer_t *an) {
+    pthread_mutex_lock(&an->lock);
+    merge_counters(&an->total, &an->window);
+    reset_counters(&an->window);
+    pthread_mutex_unlock(&an->lock);
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: stream_analyzer.h
+*
+* PURPOSE: statistics of a video stream from its demuxed packets without
+*          decoding: bitrate, GOP length, frame types and the jitter of
+*          the packet reads
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   The jitter is of the reads, the totals include the window
+************************************************************************/
+
+#ifndef __STREAM_ANALYZER_H_
+#define __STREAM_ANALYZER_H_
+
+#include <stdint.h>
+
+#include <libavformat/avformat.h>
+
+typedef struct stream_analyzer_stats_t {
+    uint64_t nb_packets;
+    uint64_t nb_bytes;
+    double   seconds;           /*of the stream timestamps*/
+    double   bitrate;           /*bits per second of the stream time*/
+    double   fps;
+    uint64_t nb_frames[AV_PICTURE_TYPE_B + 1];  /*by AV_PICTURE_TYPE_I/P/B,
+                                                  AV_PICTURE_TYPE_NONE: unknown*/
+    uint64_t nb_keyframes;      /*IDR/IRAP, or the key packets of the other codecs*/
+    uint64_t nb_gops;           /*from a keyframe to the next one*/
+    double   gop_mean;          /*frames*/
+    int      gop_min;
+    int      gop_max;
+    int      gop_last;
+    /*
+    The read jitter compares the dts intervals with the ones of the times
+    the demuxer returned the packets. It includes the network jitter and
+    the buffering of the demuxer, but also the wait of the stream for a
+    demux worker, which grows when the workers are shared by many streams
+    */
+    double   read_jitter_us;        /*RFC 3550 interarrival jitter at the end*/
+    int64_t  read_jitter_p50_us;    /*of |read interval - dts interval|*/
+    int64_t  read_jitter_p99_us;
+    int64_t  read_jitter_max_us;
+    uint64_t nb_ts_errors;      /*no dts, or not after the previous one*/
+} stream_analyzer_stats_t;
+
+typedef struct stream_analyzer_t stream_analyzer_t;
+
+/*
+*   id: stream index, for the log
+*/
+stream_analyzer_t *stream_analyzer_alloc(int id);
+
+void stream_analyzer_free(stream_analyzer_t **an);
+
+/*
+* The packets of a new input follow, in the time base, the counters go on
+*   return 0 on success, -1 on failure
+*/
+int stream_analyzer_set_stream(stream_analyzer_t *an, const AVCodecParameters *par,
+                               AVRational time_base);
+
+/*
+* Count the packet, one picture per packet like the ffmpeg demuxers give
+*   read_us: monotonic time the demuxer returned the packet
+*/
+void stream_analyzer_add_packet(stream_analyzer_t *an, const AVPacket *pkt, int64_t read_us);
+
+/*
+* Safe from any thread
+*   total: 0: of the current window, 1: of the whole run, the current
+*          window included
+*/
+void stream_analyzer_get_stats(stream_analyzer_t *an, stream_analyzer_stats_t *stats,
+                               int total);
+
+/*
+* Start a new window, the last one is added to the whole run
+*/
+void stream_analyzer_roll(stream_analyzer_t *an);
+
+#endif /* __STREAM_ANALYZER_H_ */
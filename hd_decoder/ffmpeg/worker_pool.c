@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: worker_pool.c
+*
+* PURPOSE: fixed-size pool of worker threads running cooperative stream jobs
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Priority classes of the jobs and cpu affinity
+* 2026-10-18  Apoidea   Submit a job which sleeps until its wake time
+************************************************************************/
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include "worker_pool.h"
+#include "cpu_affinity.h"
+
+#define WORKER_AGING_SLICES 8
+
+struct worker_pool_t {
+    char            name[16];
+
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    worker_job_t    *head[WORKER_PRIO_MAX];    /*run queue of each priority*/
+    worker_job_t    *tail[WORKER_PRIO_MAX];
+    unsigned int    nb_slices;
+    worker_job_t    *sleeping;  /*sorted by wake_us*/
+    int             quit;
+
+    int             nb_workers;
+    pthread_t       *workers;
+};
+
+/*called with pool->lock held*/
+static void enqueue_job(worker_pool_t *pool, worker_job_t *job) {
+    int prio = job->priority < WORKER_PRIO_MAX ? job->priority : WORKER_PRIO_LOW;
+
+    job->next = NULL;
+
+    if (pool->tail[prio]) {
+        pool->tail[prio]->next = job;
+    } else {
+        pool->head[prio] = job;
+    }
+    pool->tail[prio] = job;
+}
+
+/*called with pool->lock held*/
+static worker_job_t *dequeue_job(worker_pool_t *pool) {
+    worker_job_t *job;
+    int prio;
+
+    if (++pool->nb_slices % WORKER_AGING_SLICES == 0) {
+        prio = WORKER_PRIO_MAX - 1;
+        while (prio >= 0 && !pool->head[prio]) {
+            prio--;
+        }
+    } else {
+        prio = 0;
+        while (prio < WORKER_PRIO_MAX && !pool->head[prio]) {
+            prio++;
+        }
+    }
+
+    if (prio < 0 || prio == WORKER_PRIO_MAX) {
+        return NULL;
+    }
+
+    job = pool->head[prio];
+    pool->head[prio] = job->next;
+    if (!pool->head[prio]) {
+        pool->tail[prio] = NULL;
+    }
+    job->next = NULL;
+
+    return job;
+}
+
+static int64_t get_time_us(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*called with pool->lock held*/
+static void sleep_job(worker_pool_t *pool, worker_job_t *job) {
+    worker_job_t **p = &pool->sleeping;
+
+    while (*p && (*p)->wake_us <= job->wake_us) {
+        p = &(*p)->next;
+    }
+
+    job->next = *p;
+    *p = job;
+
+    /*the idle workers wait for the old first job, or for nothing*/
+    if (pool->sleeping == job) {
+        pthread_cond_signal(&pool->cond);
+    }
+}
+
+/*called with pool->lock held*/
+static void wake_jobs(worker_pool_t *pool, int64_t now_us) {
+    worker_job_t *job;
+
+    while (pool->sleeping && pool->sleeping->wake_us <= now_us) {
+        job = pool->sleeping;
+        pool->sleeping = job->next;
+        enqueue_job(pool, job);
+    }
+}
+
+/*called with pool->lock held*/
+static void wait_job(worker_pool_t *pool) {
+    struct timespec ts;
+
+    if (!pool->sleeping) {
+        pthread_cond_wait(&pool->cond, &pool->lock);
+        return;
+    }
+
+    ts.tv_sec  = pool->sleeping->wake_us / 1000000;
+    ts.tv_nsec = pool->sleeping->wake_us % 1000000 * 1000;
+    pthread_cond_timedwait(&pool->cond, &pool->lock, &ts);
+}
+
+static void *workerThreadEntry(void *priv) {
+    worker_pool_t *pool = (worker_pool_t *)priv;
+    worker_job_t *job;
+    int ret;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (!pool->quit) {
+        if (pool->sleeping) {
+            wake_jobs(pool, get_time_us());
+        }
+
+        job = dequeue_job(pool);
+        if (!job) {
+            wait_job(pool);
+            continue;
+        }
+
+        pthread_mutex_unlock(&pool->lock);
+        ret = job->run(job->opaque);
+        pthread_mutex_lock(&pool->lock);
+
+        if (ret == WORKER_JOB_AGAIN) {
+            enqueue_job(pool, job);
+        } else if (ret == WORKER_JOB_LATER) {
+            sleep_job(pool, job);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+worker_pool_t *worker_pool_create(const char *name, int nb_workers) {
+    worker_pool_t *pool;
+    pthread_condattr_t attr;
+    char thread_name[16];
+    int ret;
+    int i;
+
+    if (nb_workers <= 0) {
+        printf("invalid number of workers: %d\n", nb_workers);
+        return NULL;
+    }
+
+    pool = (worker_pool_t *)calloc(1, sizeof(worker_pool_t));
+    if (pool == NULL) {
+        printf("failed to malloc worker_pool_t\n");
+        return NULL;
+    }
+
+    pool->workers = (pthread_t *)calloc(nb_workers, sizeof(pthread_t));
+    if (pool->workers == NULL) {
+        printf("failed to malloc %d workers\n", nb_workers);
+        free(pool);
+        return NULL;
+    }
+
+    snprintf(pool->name, sizeof(pool->name), "%s", name);
+    pthread_mutex_init(&pool->lock, NULL);
+
+    /*wake_us of the sleeping jobs is on the monotonic clock*/
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&pool->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    for (i = 0; i < nb_workers; i++) {
+        ret = pthread_create(&pool->workers[i], NULL,
+                             workerThreadEntry, (void *)pool);
+        if (ret != 0) {
+            printf("Failed to create %s worker thread(res=%d, error=%s)\n",
+                    pool->name, ret, strerror(ret));
+            break;
+        }
+
+        snprintf(thread_name, sizeof(thread_name), "%.10s/%d", pool->name, i);
+        pthread_setname_np(pool->workers[i], thread_name);
+
+        pool->nb_workers++;
+    }
+
+    if (pool->nb_workers == 0) {
+        worker_pool_destroy(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+int worker_pool_set_affinity(worker_pool_t *pool, const char *cpus) {
+    int i;
+
+    for (i = 0; i < pool->nb_workers; i++) {
+        if (cpu_affinity_set(pool->workers[i], cpus) < 0) {
+            return -1;
+        }
+    }
+
+    printf("%s workers run on cpus %s\n", pool->name, cpus);
+
+    return 0;
+}
+
+void worker_pool_submit(worker_pool_t *pool, worker_job_t *job) {
+    pthread_mutex_lock(&pool->lock);
+    enqueue_job(pool, job);
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void worker_pool_submit_later(worker_pool_t *pool, worker_job_t *job) {
+    pthread_mutex_lock(&pool->lock);
+    sleep_job(pool, job);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void worker_pool_destroy(worker_pool_t *pool) {
+    int i;
+
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->nb_workers; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
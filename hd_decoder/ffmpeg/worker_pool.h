@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: worker_pool.h
+*
+* PURPOSE: fixed-size pool of worker threads running cooperative stream jobs
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Priority classes of the jobs and cpu affinity
+* 2026-10-18  Apoidea   Submit a job which sleeps until its wake time
+************************************************************************/
+
+#ifndef __WORKER_POOL_H_
+#define __WORKER_POOL_H_
+
+#include <stdint.h>
+
+/*return values of worker_job_t.run()*/
+#define WORKER_JOB_DONE   0  /*the job is finished, drop it*/
+#define WORKER_JOB_AGAIN  1  /*the job yields, queue it again at the tail*/
+#define WORKER_JOB_LATER  2  /*the job sleeps, queue it again at wake_us*/
+
+/*
+The workers run the queued jobs of the higher classes first, but one slice
+in WORKER_AGING_SLICES goes to the lowest class which waits, so that the
+low jobs slow down under load and never starve
+*/
+typedef enum {
+    WORKER_PRIO_HIGH = 0,
+    WORKER_PRIO_NORMAL,
+    WORKER_PRIO_LOW,
+
+    WORKER_PRIO_MAX
+} worker_prio_t;
+
+/*
+A job is embedded in the object it works on (e.g. runtime_t), so submitting
+it never allocates. A job is queued at most once at any time, which means at
+most one worker runs it: the run() callback doesn't need to lock its own state.
+run() should do a bounded slice of work and return WORKER_JOB_AGAIN, so that
+all the jobs get a fair share of the workers.
+*/
+typedef struct worker_job_t {
+    struct worker_job_t *next;
+
+    int   (*run)(void *opaque);
+    void  *opaque;
+
+    int64_t wake_us;    /*CLOCK_MONOTONIC, set by run() before it returns WORKER_JOB_LATER*/
+    worker_prio_t priority;
+} worker_job_t;
+
+typedef struct worker_pool_t worker_pool_t;
+
+/*
+* Start nb_workers threads, named "<name>/<index>"
+*/
+worker_pool_t *worker_pool_create(const char *name, int nb_workers);
+
+/*
+* Run the workers only on the cpus of the list like "0-3,6"
+*   return 0 on success, -1 on failure
+*/
+int worker_pool_set_affinity(worker_pool_t *pool, const char *cpus);
+
+/*
+* Queue the job at the tail of the run queue of its priority
+*/
+void worker_pool_submit(worker_pool_t *pool, worker_job_t *job);
+
+/*
+* Queue the job asleep until job->wake_us, like a run() which returned
+* WORKER_JOB_LATER
+*/
+void worker_pool_submit_later(worker_pool_t *pool, worker_job_t *job);
+
+/*
+* Stop the workers after their current job and free the pool,
+* the jobs which are still queued or sleeping are not run any more
+*/
+void worker_pool_destroy(worker_pool_t *pool);
+
+#endif /* __WORKER_POOL_H_ */
@@ -0,0 +1,419 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: yuv_writer.c
+*
+* PURPOSE: asynchronous writer of the decoded YUV frames on an I/O thread
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Callback of the written frames
+* 2026-10-18  Apoidea   Wait for the queued frames to be written
+************************************************************************/
+#define _GNU_SOURCE
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/uio.h>
+
+#include <pthread.h>
+
+#include "yuv_writer.h"
+#include "cpu_affinity.h"
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+typedef struct write_slot_t {
+    int     fd;
+    int     close;      /*close fd, there is no frame*/
+    int     id;
+    int     seq;
+    AVFrame *frame;
+} write_slot_t;
+
+struct yuv_writer_t {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;       /*signaled to the I/O thread*/
+    pthread_cond_t  space_cond; /*signaled when slots are free*/
+    write_slot_t    *slots;
+    unsigned int    depth;
+    unsigned int    head;       /*next slot to write*/
+    unsigned int    tail;       /*next slot to queue*/
+    int             quit;
+
+    pthread_t       thread;
+    yuv_writer_done_t done;
+    void            *done_opaque;
+
+    /*only touched by the I/O thread*/
+    struct iovec    iov[IOV_MAX];
+    int             nb_iov;
+    int             iov_fd;
+
+    int             max_occupancy;
+    uint64_t        nb_frames;
+    uint64_t        nb_bytes;
+    uint64_t        nb_dropped;
+    uint64_t        nb_syscalls;
+};
+
+/*write out the gathered rows, the I/O thread only*/
+static void flush_iov(yuv_writer_t *w) {
+    struct iovec *iov = w->iov;
+    int nb_iov = w->nb_iov;
+    ssize_t ret;
+
+    while (nb_iov > 0) {
+        ret = writev(w->iov_fd, iov, nb_iov);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            printf("failed to write the yuv file(fd: %d, error: %s)\n",
+                    w->iov_fd, strerror(errno));
+            break;
+        }
+
+        pthread_mutex_lock(&w->lock);
+        w->nb_bytes += ret;
+        w->nb_syscalls++;
+        pthread_mutex_unlock(&w->lock);
+
+        /*skip what is written, a partial write can stop inside a row*/
+        while (nb_iov > 0 && (size_t)ret >= iov->iov_len) {
+            ret -= iov->iov_len;
+            iov++;
+            nb_iov--;
+        }
+
+        if (nb_iov > 0) {
+            iov->iov_base = (uint8_t *)iov->iov_base + ret;
+            iov->iov_len -= ret;
+        }
+    }
+
+    w->nb_iov = 0;
+}
+
+static void add_iov(yuv_writer_t *w, int fd, uint8_t *data, size_t len) {
+    if (w->nb_iov == IOV_MAX || (w->nb_iov > 0 && w->iov_fd != fd)) {
+        flush_iov(w);
+    }
+
+    w->iov_fd = fd;
+    w->iov[w->nb_iov].iov_base = data;
+    w->iov[w->nb_iov].iov_len  = len;
+    w->nb_iov++;
+}
+
+/*
+* Gather the plane without the stride padding: a plane without padding
+* is one entry, otherwise one entry per row
+*/
+static void add_plane(yuv_writer_t *w, int fd, uint8_t *data, int linesize,
+                      int width, int height) {
+    int i;
+
+    if (linesize == width) {
+        add_iov(w, fd, data, (size_t)width * height);
+        return;
+    }
+
+    for (i = 0; i < height; i++) {
+        add_iov(w, fd, data + (ptrdiff_t)i * linesize, width);
+    }
+}
+
+static void add_frame(yuv_writer_t *w, write_slot_t *slot) {
+    AVFrame *frm = slot->frame;
+
+    /*
+    video: only yuv420p or nv12 are available
+    */
+
+    if (frm->format == AV_PIX_FMT_YUV420P) {
+        add_plane(w, slot->fd, frm->data[0], frm->linesize[0], frm->width, frm->height);
+        add_plane(w, slot->fd, frm->data[1], frm->linesize[1], frm->width/2, frm->height/2);
+        add_plane(w, slot->fd, frm->data[2], frm->linesize[2], frm->width/2, frm->height/2);
+
+        printf("[%d] write out %d YUV420P frame\n", slot->id, slot->seq);
+    } else {
+        add_plane(w, slot->fd, frm->data[0], frm->linesize[0], frm->width, frm->height);
+        add_plane(w, slot->fd, frm->data[1], frm->linesize[1], frm->width, frm->height/2);
+
+        printf("[%d] write out %d NV12 frame\n", slot->id, slot->seq);
+    }
+}
+
+static void *writerThreadEntry(void *priv) {
+    yuv_writer_t *w = (yuv_writer_t *)priv;
+    write_slot_t *slot;
+    unsigned int end;
+    unsigned int i;
+    int nb_frames;
+
+    pthread_mutex_lock(&w->lock);
+
+    for (;;) {
+        while (w->head == w->tail && !w->quit) {
+            pthread_cond_wait(&w->cond, &w->lock);
+        }
+
+        if (w->head == w->tail) {
+            break;
+        }
+
+        /*write all the queued frames in one batch, the producers
+          keep queuing behind them meanwhile*/
+        end = w->tail;
+        pthread_mutex_unlock(&w->lock);
+
+        nb_frames = 0;
+        for (i = w->head; i != end; i++) {
+            slot = &w->slots[i % w->depth];
+
+            if (slot->close) {
+                if (w->nb_iov > 0 && w->iov_fd == slot->fd) {
+                    flush_iov(w);
+                }
+                close(slot->fd);
+            } else {
+                add_frame(w, slot);
+                nb_frames++;
+            }
+        }
+        flush_iov(w);
+
+        for (i = w->head; w->done && i != end; i++) {
+            slot = &w->slots[i % w->depth];
+            if (!slot->close) {
+                w->done(w->done_opaque, slot->id, slot->frame);
+            }
+        }
+
+        pthread_mutex_lock(&w->lock);
+
+        for (i = w->head; i != end; i++) {
+            slot = &w->slots[i % w->depth];
+            if (!slot->close) {
+                av_frame_unref(slot->frame);
+            }
+        }
+
+        w->nb_frames += nb_frames;
+        w->head = end;
+        pthread_cond_broadcast(&w->space_cond);
+    }
+
+    pthread_mutex_unlock(&w->lock);
+
+    return NULL;
+}
+
+void yuv_writer_set_done(yuv_writer_t *w, yuv_writer_done_t done, void *opaque) {
+    pthread_mutex_lock(&w->lock);
+    w->done        = done;
+    w->done_opaque = opaque;
+    pthread_mutex_unlock(&w->lock);
+}
+
+yuv_writer_t *yuv_writer_create(int depth) {
+    yuv_writer_t *w;
+    int ret;
+    int i;
+
+    if (depth <= 0) {
+        printf("invalid depth of yuv writer: %d\n", depth);
+        return NULL;
+    }
+
+    w = (yuv_writer_t *)calloc(1, sizeof(yuv_writer_t));
+    if (w == NULL) {
+        printf("failed to malloc yuv_writer_t\n");
+        return NULL;
+    }
+
+    w->slots = (write_slot_t *)calloc(depth, sizeof(write_slot_t));
+    if (w->slots == NULL) {
+        printf("failed to malloc %d write slots\n", depth);
+        free(w);
+        return NULL;
+    }
+
+    /*the slots keep their AVFrame, queuing a frame only adds references*/
+    for (i = 0; i < depth; i++) {
+        w->slots[i].frame = av_frame_alloc();
+        if (!w->slots[i].frame) {
+            printf("failed to allocate AVFrame\n");
+            w->depth = i;
+            yuv_writer_destroy(w);
+            return NULL;
+        }
+    }
+
+    w->depth = depth;
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->cond, NULL);
+    pthread_cond_init(&w->space_cond, NULL);
+
+    ret = pthread_create(&w->thread, NULL, writerThreadEntry, (void *)w);
+    if (ret != 0) {
+        printf("Failed to create yuv writer thread(res=%d, error=%s)\n",
+                ret, strerror(ret));
+        for (i = 0; i < depth; i++) {
+            av_frame_free(&w->slots[i].frame);
+        }
+        free(w->slots);
+        free(w);
+        return NULL;
+    }
+    pthread_setname_np(w->thread, "yuv_writer");
+
+    return w;
+}
+
+void yuv_writer_destroy(yuv_writer_t *w) {
+    unsigned int i;
+
+    if (!w) {
+        return;
+    }
+
+    if (w->thread) {
+        pthread_mutex_lock(&w->lock);
+        w->quit = 1;
+        pthread_cond_signal(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+
+        pthread_join(w->thread, NULL);
+
+        pthread_cond_destroy(&w->space_cond);
+        pthread_cond_destroy(&w->cond);
+        pthread_mutex_destroy(&w->lock);
+    }
+
+    for (i = 0; i < w->depth; i++) {
+        av_frame_free(&w->slots[i].frame);
+    }
+
+    free(w->slots);
+    free(w);
+}
+
+void yuv_writer_flush(yuv_writer_t *w) {
+    if (!w) {
+        return;
+    }
+
+    /*head passes a batch after its callbacks*/
+    pthread_mutex_lock(&w->lock);
+    while (w->head != w->tail) {
+        pthread_cond_wait(&w->space_cond, &w->lock);
+    }
+    pthread_mutex_unlock(&w->lock);
+}
+
+int yuv_writer_set_affinity(yuv_writer_t *w, const char *cpus) {
+    return cpu_affinity_set(w->thread, cpus);
+}
+
+int yuv_writer_queue(yuv_writer_t *w, int fd, const AVFrame *frame, int id, int seq) {
+    write_slot_t *slot;
+    int occupancy;
+    int ret;
+
+    if (frame->format != AV_PIX_FMT_YUV420P && frame->format != AV_PIX_FMT_NV12) {
+        printf("[%d] invalid avframe format: %d\n", id, frame->format);
+        return -1;
+    }
+
+    pthread_mutex_lock(&w->lock);
+
+    if (w->tail - w->head == w->depth) {
+        w->nb_dropped++;
+        pthread_mutex_unlock(&w->lock);
+        return 1;
+    }
+
+    slot = &w->slots[w->tail % w->depth];
+    ret = av_frame_ref(slot->frame, frame);
+    if (ret < 0) {
+        w->nb_dropped++;
+        pthread_mutex_unlock(&w->lock);
+        return 1;
+    }
+
+    slot->fd    = fd;
+    slot->close = 0;
+    slot->id    = id;
+    slot->seq   = seq;
+    w->tail++;
+
+    occupancy = w->tail - w->head;
+    if (occupancy > w->max_occupancy) {
+        w->max_occupancy = occupancy;
+    }
+
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+
+    return 0;
+}
+
+void yuv_writer_close(yuv_writer_t *w, int fd) {
+    write_slot_t *slot;
+
+    pthread_mutex_lock(&w->lock);
+
+    while (w->tail - w->head == w->depth) {
+        pthread_cond_wait(&w->space_cond, &w->lock);
+    }
+
+    slot = &w->slots[w->tail % w->depth];
+    slot->fd    = fd;
+    slot->close = 1;
+    w->tail++;
+
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+}
+
+void yuv_writer_get_stats(yuv_writer_t *w, yuv_writer_stats_t *stats) {
+    pthread_mutex_lock(&w->lock);
+
+    stats->depth         = w->depth;
+    stats->occupancy     = w->tail - w->head;
+    stats->max_occupancy = w->max_occupancy;
+    stats->nb_frames     = w->nb_frames;
+    stats->nb_bytes      = w->nb_bytes;
+    stats->nb_dropped    = w->nb_dropped;
+    stats->nb_syscalls   = w->nb_syscalls;
+
+    pthread_mutex_unlock(&w->lock);
+}
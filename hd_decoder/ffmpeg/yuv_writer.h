@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: yuv_writer.h
+*
+* PURPOSE: asynchronous writer of the decoded YUV frames on an I/O thread
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Callback of the written frames
+* 2026-10-18  Apoidea   Wait for the queued frames to be written
+************************************************************************/
+
+#ifndef __YUV_WRITER_H_
+#define __YUV_WRITER_H_
+
+#include <stdint.h>
+
+#include <libavutil/frame.h>
+
+typedef struct yuv_writer_stats_t {
+    int      depth;
+    int      occupancy;       /*frames waiting for the disk*/
+    int      max_occupancy;
+
+    uint64_t nb_frames;       /*written*/
+    uint64_t nb_bytes;
+    uint64_t nb_dropped;      /*the queue was full*/
+    uint64_t nb_syscalls;     /*writev() calls*/
+} yuv_writer_stats_t;
+
+typedef struct yuv_writer_t yuv_writer_t;
+
+/*
+* Start the I/O thread with a queue of depth frames
+*/
+yuv_writer_t *yuv_writer_create(int depth);
+
+/*
+* Write everything queued, then stop the I/O thread and free the writer
+*/
+void yuv_writer_destroy(yuv_writer_t *w);
+
+/*
+* Called on the I/O thread for every frame once it is written
+*   id: of yuv_writer_queue()
+*/
+typedef void (*yuv_writer_done_t)(void *opaque, int id, const AVFrame *frame);
+
+/*
+* Set the callback of the written frames, before the first frame is queued
+*/
+void yuv_writer_set_done(yuv_writer_t *w, yuv_writer_done_t done, void *opaque);
+
+/*
+* Run the I/O thread only on the cpus of the list like "0-3,6"
+*   return 0 on success, -1 on failure
+*/
+int yuv_writer_set_affinity(yuv_writer_t *w, const char *cpus);
+
+/*
+* Queue a reference of the YUV420P/NV12 frame for fd, it never blocks:
+* the frame is dropped when the queue is full.
+*   id, seq: stream index and frame number, for the log
+*   return 0 if queued, 1 if dropped, -1 if the pixel format is not supported
+*/
+int yuv_writer_queue(yuv_writer_t *w, int fd, const AVFrame *frame, int id, int seq);
+
+/*
+* Close fd after its queued frames are written, it waits for a free slot
+*/
+void yuv_writer_close(yuv_writer_t *w, int fd);
+
+/*
+* Wait until the queued frames are written and their callbacks returned
+*/
+void yuv_writer_flush(yuv_writer_t *w);
+
+void yuv_writer_get_stats(yuv_writer_t *w, yuv_writer_stats_t *stats);
+
+#endif /* __YUV_WRITER_H_ */
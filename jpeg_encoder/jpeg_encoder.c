@@ -26,10 +26,15 @@
 * Date        Name       Description
 * ---------   ---------- -----------------------------------------------
 * 2022-07-19  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Read any frame of a yuv file or a frame archive
 ************************************************************************/
 /*
 example:
 ./jpeg_encoder -i /root/ffmpeg/out.yuv -o 1.jpeg -w 1920 -h 1080
+
+the frame 250 of a frame archive written by ffmpeg_hd_decoder -o arc:...,
+the size and the format are in the archive:
+./jpeg_encoder -i /root/ffmpeg/cam_0.farc -o 250.jpeg -n 250
 */
 #include <unistd.h>
 #include <sys/types.h>
@@ -43,6 +48,16 @@ example:
 #include <sys/time.h>
 
 #include "jpegenc.h"
+#include "frame_archive.h"
+
+/*
+* return 1 if the file starts with the magic of a frame archive
+*/
+static int is_frame_archive(int fd) {
+    uint32_t magic = 0;
+
+    return pread(fd, &magic, sizeof(magic), 0) == sizeof(magic) && magic == FRAMEARC_MAGIC;
+}
 
 static void usage(char *programname)
 {
@@ -51,7 +66,9 @@ static void usage(char *programname)
         " -i <yuv420p file: use the yuv file generated by ffmpeg example code> \n"
         " -o <jpeg file> \n"
         " -w <the width of picture> \n"
-        " -h <the height of picture> \n"),
+        " -h <the height of picture> \n"
+        " -n <frame number>(default: 0): the frame of the yuv file or the frame archive, \n"
+        "    -w and -h are not needed for an archive \n"),
         programname);
 }
 
@@ -64,6 +81,11 @@ int main(int argc, char *argv[])
     int fjpeg = -1;
     int fyuv = -1;
     int w = 0, h = 0;
+    int n = 0;
+    char *in_path = NULL;
+    FRAMEARC_HANDLE_t arc = NULL;
+    FrameArcPic_t pic;
+    int compressed = 0;
 
     JpegEnSetting_t jpegSetting;
     JPEGEN_HANDLE_t *pic_cap_jpeg_h;
@@ -73,7 +95,7 @@ int main(int argc, char *argv[])
     int jpeg_size;
 
     /* Process options with getopt */
-    while ((option = getopt(argc, argv,"i:o:w:h:")) != -1) {
+    while ((option = getopt(argc, argv,"i:o:w:h:n:")) != -1) {
         switch (option) {
             case 'i':
                 fyuv = open(optarg, O_RDONLY, 0777);
@@ -82,6 +104,7 @@ int main(int argc, char *argv[])
                             optarg, strerror(errno));
                     return -1;
                 }
+                in_path = optarg;
 
                 break;
 
@@ -102,6 +125,10 @@ int main(int argc, char *argv[])
                 h = atoi(optarg);
                 break;
 
+            case 'n':
+                n = atoi(optarg);
+                break;
+
             default:
                 usage(argv[0]);
                 exit(0);
@@ -109,7 +136,26 @@ int main(int argc, char *argv[])
         }
     }
 
-    if (fjpeg < 0 || fyuv < 0 || !w || !h) {
+    if (fyuv >= 0 && is_frame_archive(fyuv)) {
+        close(fyuv);
+        fyuv = -1;
+
+        arc = FrameArcOpen(in_path);
+        if (arc == NULL) {
+            return -1;
+        }
+
+        ret = FrameArcPeek(arc, n, &pic);
+        if (ret < 0) {
+            printf("no frame %d in the archive of %d frames\n", n, FrameArcCount(arc));
+            return -1;
+        }
+        compressed = ret;
+        w = pic.width;
+        h = pic.height;
+    }
+
+    if (fjpeg < 0 || (fyuv < 0 && !arc) || !w || !h || n < 0) {
         usage(argv[0]);
         exit(0);
     }
@@ -118,6 +164,9 @@ int main(int argc, char *argv[])
 
     jpegSetting.width   = w;
     jpegSetting.height  = h;
+    if (arc && pic.format == FRAMEARC_FMT_NV12) {
+        jpegSetting.fmt = JPEGEN_PIC_FMT_NV12;
+    }
 
     pic_cap_jpeg_h = JpegEncoderInit(&jpegSetting);
     if (pic_cap_jpeg_h == NULL) {
@@ -125,14 +174,29 @@ int main(int argc, char *argv[])
         return -1;
     }
 
-    yuv_size = w * h * 3 / 2;
-    yuv_buf = (unsigned char *)malloc(yuv_size);
-
-    ret = read(fyuv, yuv_buf, yuv_size);
-    close(fyuv);
-    if (ret != yuv_size) {
-        printf("read %d bytes but expect %d bytes\n", ret, yuv_size);
-        return -1;
+    if (arc) {
+        /*a stored frame is used in the mapping, a compressed one is read*/
+        if (!compressed) {
+            yuv_buf = pic.data[0];
+        } else {
+            yuv_buf = (unsigned char *)malloc(pic.size);
+            if (yuv_buf == NULL || FrameArcRead(arc, n, &pic, yuv_buf, pic.size) < 0) {
+                printf("failed to read frame %d of the archive\n", n);
+                return -1;
+            }
+        }
+        printf("frame %d of the archive: %dx%d %s, pts %lld\n", n, w, h,
+                pic.format == FRAMEARC_FMT_NV12 ? "nv12" : "yuv420", (long long)pic.pts);
+    } else {
+        yuv_size = w * h * 3 / 2;
+        yuv_buf = (unsigned char *)malloc(yuv_size);
+
+        ret = pread(fyuv, yuv_buf, yuv_size, (off_t)n * yuv_size);
+        close(fyuv);
+        if (ret != yuv_size) {
+            printf("read %d bytes but expect %d bytes\n", ret, yuv_size);
+            return -1;
+        }
     }
 
     ret = JpegEncoderProc(pic_cap_jpeg_h, (void *)yuv_buf, (void **)&jpeg_buf, &jpeg_size);
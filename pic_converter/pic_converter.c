@@ -26,10 +26,31 @@
 * Date        Name       Description
 * ---------   ---------- -----------------------------------------------
 * 2022-07-20  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Read any frame of a raw file or a frame archive
+* 2026-10-18  Apoidea   CPU converter with its kernels, checked against the scalar ones
+* 2026-10-18  Apoidea   Latency of the CPU converter on threads
+* 2026-10-18  Apoidea   Stream the frames of a file through a read/convert/write pipeline
+* 2026-10-18  Apoidea   Free the input picture of a single frame on every exit
 ************************************************************************/
 /*
 example:
 ./pic_converter -i ../ffmpeg/out.yuv -o conv.rgb -s 1920,1080,yuv420 -c 640,480,rgba
+
+the frame 250 of a frame archive written by ffmpeg_hd_decoder -o arc:...,
+the input size and format are in the archive:
+./pic_converter -i ../ffmpeg/cam_0.farc -n 250 -o conv.rgb -c 640,480,rgba
+
+the CPU converter with the AVX2 kernels, the result is checked against the
+scalar reference kernels:
+./pic_converter -i ../ffmpeg/out.yuv -o conv.rgb -s 1920,1080,yuv420 -c 640,480,rgba -k avx2 -V
+
+the latency of the CPU converter on one thread and on one thread for each
+cpu:
+./pic_converter -i ../ffmpeg/out.yuv -o conv.rgb -s 3840,2160,nv12 -c 3840,2160,rgba -t 0
+
+every other frame from the frame 100 to the end of a frame archive, the
+converted frames one after another in conv.yuv:
+./pic_converter -i ../ffmpeg/cam_0.farc -n 100 -f 0 -S 2 -o conv.yuv -c 1280,720,yuv444
 */
 #include <unistd.h>
 #include <sys/types.h>
@@ -41,45 +62,383 @@ example:
 #include <errno.h>
 #include <stdarg.h>
 #include <sys/time.h>
+#include <sys/mman.h>
+#include <pthread.h>
 
 #include "picconverter.h"
+#include "picconv_cpu.h"
+#include "frame_archive.h"
+
+#define TIMED_RUNS 20   /*conversions of -t*/
+#define STREAM_SLOTS 4  /*frames in the read/convert/write pipeline of -f*/
+
+/*the names of -s and -c, in the order of PicFormat_t*/
+static const char *format_names[PIC_FMT_MAX] = {
+    "yuv420", "nv12", "nv21", "uyvy", "yuyv", "yvyu", "yuv444",
+    "bgra", "rgbx", "rgba", "gray8", "jpeg"
+};
+
+/*a frame in the pipeline, its buffers are used again by the frame STREAM_SLOTS after it*/
+typedef struct slot_t {
+    unsigned char *src;         /*in the mapping of the input or in src_buf*/
+    unsigned char *src_buf;     /*a compressed frame of an archive*/
+    unsigned char *dest;
+    unsigned int  dest_size;
+} slot_t;
+
+/*
+* The frames first, first + step, ... of the input: a reader thread maps
+* them in, the caller converts them and a writer thread writes them out
+*/
+typedef struct stream_t {
+    PIC_CONV_HANDLE_t handle;
+    int               cpu;          /*of PicConvCpuInit()*/
+    PicParam_t        src;
+    unsigned int      src_size;
+    unsigned int      dest_size;
+
+    unsigned char     *map;         /*of a raw file*/
+    size_t            map_size;
+    FRAMEARC_HANDLE_t arc;
+    int               fd;           /*of the output*/
+
+    int               first;
+    int               step;
+    int               nb_frames;
+
+    slot_t            slots[STREAM_SLOTS];
+
+    pthread_mutex_t   lock;
+    pthread_cond_t    cond;
+    int               nb_read;      /*frames done by each stage*/
+    int               nb_converted;
+    int               nb_written;
+    int               failed;
+} stream_t;
+
+/*
+* return 1 if the file starts with the magic of a frame archive
+*/
+static int is_frame_archive(int fd) {
+    uint32_t magic = 0;
+
+    return pread(fd, &magic, sizeof(magic), 0) == sizeof(magic) && magic == FRAMEARC_MAGIC;
+}
+
+/*
+* (width),(height),(pixel format)
+*   return PIC_FMT_MAX if the format is unknown
+*/
+static PicFormat_t parse_picture(char *arg, int *width, int *height) {
+    PicFormat_t format = PIC_FMT_MAX;
+    char *p;
+    int id = 0;
+
+    p = strtok(arg, ",");
+    while (p != NULL) {
+        if (id == 0) {
+            *width = atoi(p);
+        } else if (id == 1) {
+            *height = atoi(p);
+        } else if (id == 2) {
+            for (format = 0; format < PIC_FMT_MAX && strcmp(p, format_names[format]); format++);
+        }
+        id++;
+        p = strtok(NULL, ",");
+    }
+
+    return format;
+}
+
+static const char *format_name(PicFormat_t format) {
+    return format < PIC_FMT_MAX ? format_names[format] : "unknown";
+}
+
+/*
+* wait until *count, the frames done by a stage, is above n
+*   return 0, -1 if the stream failed
+*/
+static int stream_wait(stream_t *s, int *count, int n) {
+    int ret;
+
+    pthread_mutex_lock(&s->lock);
+    while (!s->failed && *count <= n) {
+        pthread_cond_wait(&s->cond, &s->lock);
+    }
+    ret = s->failed ? -1 : 0;
+    pthread_mutex_unlock(&s->lock);
+
+    return ret;
+}
+
+static void stream_done(stream_t *s, int *count, int failed) {
+    pthread_mutex_lock(&s->lock);
+    if (failed) {
+        s->failed = 1;
+    } else {
+        (*count)++;
+    }
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+}
+
+/*
+* bring the frame n into the slot, the pages of a mapped one are touched
+* here so that the converter doesn't wait for the disk
+*   return 0 on success, -1 on failure
+*/
+static int read_frame(stream_t *s, slot_t *slot, int n) {
+    FrameArcPic_t pic;
+    unsigned int i;
+    long page = sysconf(_SC_PAGESIZE);
+    int ret;
+
+    if (s->arc) {
+        ret = FrameArcPeek(s->arc, n, &pic);
+        if (ret < 0) {
+            printf("no frame %d in the archive\n", n);
+            return -1;
+        }
+        if ((unsigned int)pic.width != s->src.width || (unsigned int)pic.height != s->src.height ||
+            (pic.format == FRAMEARC_FMT_NV12 ? PIC_FMT_NV12 : PIC_FMT_YUV420) != s->src.format) {
+            printf("frame %d of the archive is not of %dx%d %s\n", n, s->src.width,
+                    s->src.height, format_name(s->src.format));
+            return -1;
+        }
+        if (ret == 1) {
+            if (slot->src_buf == NULL) {
+                slot->src_buf = (unsigned char *)malloc(s->src_size);
+            }
+            if (slot->src_buf == NULL || FrameArcRead(s->arc, n, &pic, slot->src_buf, s->src_size) < 0) {
+                printf("failed to read frame %d of the archive\n", n);
+                return -1;
+            }
+            slot->src = slot->src_buf;
+            return 0;
+        }
+        slot->src = pic.data[0];
+    } else {
+        slot->src = s->map + (size_t)n * s->src_size;
+    }
+
+    for (i = 0; i < s->src_size; i += page) {
+        (void)*(volatile const unsigned char *)&slot->src[i];
+    }
+
+    return 0;
+}
+
+static void *read_frames(void *arg) {
+    stream_t *s = (stream_t *)arg;
+    int failed;
+    int i;
+
+    for (i = 0; i < s->nb_frames; i++) {
+        /*the slot is free once the frame STREAM_SLOTS before is written*/
+        if (stream_wait(s, &s->nb_written, i - STREAM_SLOTS) < 0) {
+            break;
+        }
+        failed = read_frame(s, &s->slots[i % STREAM_SLOTS], s->first + i * s->step);
+        stream_done(s, &s->nb_read, failed);
+        if (failed) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static void *write_frames(void *arg) {
+    stream_t *s = (stream_t *)arg;
+    slot_t *slot;
+    unsigned int done;
+    ssize_t ret;
+    int i;
+
+    for (i = 0; i < s->nb_frames; i++) {
+        if (stream_wait(s, &s->nb_converted, i) < 0) {
+            break;
+        }
+        slot = &s->slots[i % STREAM_SLOTS];
+        for (done = 0; done < slot->dest_size; done += ret) {
+            ret = write(s->fd, slot->dest + done, slot->dest_size - done);
+            if (ret <= 0) {
+                printf("failed to write frame %d(error: %s)\n", s->first + i * s->step, strerror(errno));
+                break;
+            }
+        }
+        stream_done(s, &s->nb_written, done < slot->dest_size);
+        if (done < slot->dest_size) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+* convert the frames of the stream in the read/convert/write pipeline
+*   return 0 on success, -1 on failure
+*/
+static int convert_stream(stream_t *s) {
+    struct timeval start, end;
+    pthread_t reader, writer;
+    slot_t *slot;
+    double secs;
+    int failed;
+    int i;
+
+    for (i = 0; i < STREAM_SLOTS; i++) {
+        s->slots[i].dest = (unsigned char *)malloc(s->dest_size);
+        if (s->slots[i].dest == NULL) {
+            printf("failed to malloc %u bytes of a converted frame\n", s->dest_size);
+            return -1;
+        }
+    }
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, NULL);
+
+    gettimeofday(&start, NULL);
+    if (pthread_create(&reader, NULL, read_frames, s)) {
+        printf("failed to create the reader thread\n");
+        return -1;
+    }
+    if (pthread_create(&writer, NULL, write_frames, s)) {
+        printf("failed to create the writer thread\n");
+        stream_done(s, &s->nb_converted, 1);
+        pthread_join(reader, NULL);
+        return -1;
+    }
+
+    for (i = 0; i < s->nb_frames; i++) {
+        if (stream_wait(s, &s->nb_read, i) < 0) {
+            break;
+        }
+        slot = &s->slots[i % STREAM_SLOTS];
+        if (s->cpu) {
+            failed = PicConvCpuProc_copy(s->handle, slot->src, slot->dest, &slot->dest_size);
+        } else {
+            failed = PicConvProc_copy(s->handle, slot->src, slot->dest, &slot->dest_size);
+        }
+        if (failed) {
+            printf("failed to convert frame %d(ret: %d)\n", s->first + i * s->step, failed);
+        }
+        stream_done(s, &s->nb_converted, failed != 0);
+        if (failed) {
+            break;
+        }
+    }
+
+    pthread_join(reader, NULL);
+    pthread_join(writer, NULL);
+    gettimeofday(&end, NULL);
+
+    secs = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+    printf("converted %d frames(%d..%d step %d) in %.3f s: %.1f frames/s\n", s->nb_written,
+            s->first, s->first + (s->nb_frames - 1) * s->step, s->step, secs,
+            secs > 0 ? s->nb_written / secs : 0);
+
+    for (i = 0; i < STREAM_SLOTS; i++) {
+        free(s->slots[i].src_buf);
+        free(s->slots[i].dest);
+    }
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->lock);
+
+    return s->failed ? -1 : 0;
+}
+
+/*
+* return the mean latency in ms of runs conversions, -1 on failure
+*/
+static double time_conversions(PIC_CONV_HANDLE_t handle, unsigned char *in_buf, int runs) {
+    struct timeval start, end;
+    unsigned char *buf;
+    unsigned int size;
+    int i;
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < runs; i++) {
+        if (PicConvCpuProc(handle, (void *)in_buf, (void **)&buf, &size)) {
+            return -1;
+        }
+    }
+    gettimeofday(&end, NULL);
+
+    return ((end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0) / runs;
+}
 
 static void usage(char *programname)
 {
+    char formats[128] = "";
+    int i;
+
+    for (i = 0; i < PIC_FMT_MAX; i++) {
+        strcat(formats, i ? "/" : "");
+        strcat(formats, format_names[i]);
+    }
+
     printf("%s (compiled %s)\n", programname, __DATE__);
     printf(("Usage %s [OPTION]\n"
         " -i <input raw picture file> \n"
         " -o <output converted picture file> \n"
-        " -s <input picture format: (width),(height),(pixel format: nv12/yuv420/bgra/rgba)> \n"
-        " -c <output picture format: (width),(height),(pixel format: nv12/yuv420/bgra/rgba)> \n"),
-        programname);
+        " -s <input picture format: (width),(height),(pixel format: %s)> \n"
+        " -c <output picture format: (width),(height),(pixel format: %s)> \n"
+        " -n <frame number>(default: 0): the picture of the raw file or the frame archive, \n"
+        "    -s is not needed for an archive \n"
+        " -f <frames>(0: to the end of the input): convert the frames from -n on into the \n"
+        "    output one after another, the input is mapped and the frames are read, \n"
+        "    converted and written by a pipeline of threads \n"
+        " -S <step>(default: 1): of the frame numbers of -f \n"
+        " -k <kernels: auto/scalar/sse4/avx2/neon>: convert by the CPU converter \n"
+        " -V : check the result of the CPU converter against its scalar kernels \n"
+        " -t <threads>(0: one for each cpu): convert by the CPU converter on the threads, \n"
+        "    its latency is compared with the one on one thread, or with -f the frames are \n"
+        "    converted on the threads \n"),
+        programname, formats, formats);
 }
 
 int main(int argc, char *argv[])
 {
     int option;
-    int rc;
     int ret;
-    int i;
+    ssize_t nread;
+    unsigned int i;
     int fconv = -1;
     int fin = -1;
     int in_w = 0, in_h = 0;
     PicFormat_t in_fmt = PIC_FMT_MAX;
     int conv_w = 0, conv_h = 0;
     PicFormat_t conv_fmt = PIC_FMT_MAX;
-    char *p;
-    int id;
-    char fmt[8];
+    int n = 0;
+    char *in_path = NULL;
+    FRAMEARC_HANDLE_t arc = NULL;
+    FrameArcPic_t pic;
+    int compressed = 0;
+    char *kernels = NULL;
+    int verify = 0;
+    PIC_CONV_HANDLE_t ref_h;
+    unsigned char *ref_buf;
+    unsigned int ref_size;
+    int diff;
+    int threads = -1;
+    double single_ms, multi_ms;
+    int nb_frames = -1;
+    int step = 1;
+    int total;
+    struct stat st;
+    stream_t stream;
 
     PicSetting_t pic_conf;
     PIC_CONV_HANDLE_t *pic_conv_h;
     unsigned char *in_buf;
-    int  in_size;
+    unsigned char *in_alloc = NULL;    /*in_buf unless it is in the archive mapping*/
+    unsigned int in_size;
     unsigned char *conv_buf;
-    int conv_size;
+    unsigned int conv_size;
 
     /* Process options with getopt */
-    while ((option = getopt(argc, argv,"i:o:s:c:")) != -1) {
+    while ((option = getopt(argc, argv,"i:o:s:c:n:k:Vt:f:S:")) != -1) {
         switch (option) {
             case 'i':
                 fin = open(optarg, O_RDONLY, 0777);
@@ -88,6 +447,7 @@ int main(int argc, char *argv[])
                             optarg, strerror(errno));
                     return -1;
                 }
+                in_path = optarg;
 
                 break;
 
@@ -101,56 +461,39 @@ int main(int argc, char *argv[])
                 break;
 
             case 's':
-                id = 0;
-                p = strtok(optarg, ",");
-                do {
-                    if (id == 0) {
-                        in_w = atoi(p);
-                    } else if (id == 1) {
-                        in_h = atoi(p);
-                    } else if (id == 2) {
-                        if (!strcmp(p, "nv12")) {
-                            in_fmt = PIC_FMT_NV12;
-                        } else if (!strcmp(p, "yuv420")) {
-                            in_fmt = PIC_FMT_YUV420;
-                        } else if (!strcmp(p, "bgra")) {
-                            in_fmt = PIC_FMT_ABGR32;
-                        } else if (!strcmp(p, "rgba")) {
-                            in_fmt = PIC_FMT_ARGB32;
-                        }
-                        strcpy(fmt, p);
-                    }
-
-                    id++;
-                } while((p = strtok(NULL, ",")) != NULL);
-                printf("input picture: w-%d, h-%d, fmt-%s\n", in_w, in_h, fmt);
+                in_fmt = parse_picture(optarg, &in_w, &in_h);
+                printf("input picture: w-%d, h-%d, fmt-%s\n", in_w, in_h, format_name(in_fmt));
 
                 break;
 
             case 'c':
-                id = 0;
-                p = strtok(optarg, ",");
-                do {
-                    if (id == 0) {
-                        conv_w = atoi(p);
-                    } else if (id == 1) {
-                        conv_h = atoi(p);
-                    } else if (id == 2) {
-                        if (!strcmp(p, "nv12")) {
-                            conv_fmt = PIC_FMT_NV12;
-                        } else if (!strcmp(p, "yuv420")) {
-                            conv_fmt = PIC_FMT_YUV420;
-                        } else if (!strcmp(p, "bgra")) {
-                            conv_fmt = PIC_FMT_ABGR32;
-                        } else if (!strcmp(p, "rgba")) {
-                            conv_fmt = PIC_FMT_ARGB32;
-                        }
-                        strcpy(fmt, p);
-                    }
-                    id++;
-                } while((p = strtok(NULL, ",")) != NULL);
-                printf("output picture: w-%d, h-%d, fmt-%s\n", conv_w, conv_h, fmt);
+                conv_fmt = parse_picture(optarg, &conv_w, &conv_h);
+                printf("output picture: w-%d, h-%d, fmt-%s\n", conv_w, conv_h, format_name(conv_fmt));
+
+                break;
+
+            case 'n':
+                n = atoi(optarg);
+                break;
+
+            case 'k':
+                kernels = optarg;
+                break;
+
+            case 'V':
+                verify = 1;
+                break;
 
+            case 't':
+                threads = atoi(optarg);
+                break;
+
+            case 'f':
+                nb_frames = atoi(optarg);
+                break;
+
+            case 'S':
+                step = atoi(optarg);
                 break;
 
             default:
@@ -160,7 +503,29 @@ int main(int argc, char *argv[])
         }
     }
 
-    if (fconv < 0 || fin < 0 ||
+    if (fin >= 0 && is_frame_archive(fin)) {
+        close(fin);
+        fin = -1;
+
+        arc = FrameArcOpen(in_path);
+        if (arc == NULL) {
+            return -1;
+        }
+
+        ret = FrameArcPeek(arc, n, &pic);
+        if (ret < 0) {
+            printf("no frame %d in the archive of %d frames\n", n, FrameArcCount(arc));
+            return -1;
+        }
+        compressed = ret;
+        in_w   = pic.width;
+        in_h   = pic.height;
+        in_fmt = pic.format == FRAMEARC_FMT_NV12 ? PIC_FMT_NV12 : PIC_FMT_YUV420;
+        printf("input picture: frame %d of the archive, w-%d, h-%d, fmt-%s, pts %lld\n", n,
+                in_w, in_h, format_name(in_fmt), (long long)pic.pts);
+    }
+
+    if (fconv < 0 || (fin < 0 && !arc) || n < 0 || step < 1 || (nb_frames >= 0 && verify) ||
         (!in_w || !in_h || in_fmt == PIC_FMT_MAX) ||
         (!conv_w || !conv_h || conv_fmt == PIC_FMT_MAX)) {
         usage(argv[0]);
@@ -177,36 +542,194 @@ int main(int argc, char *argv[])
     pic_conf.dest.height = conv_h;
     pic_conf.dest.format = conv_fmt;
 
-    pic_conv_h = PicConvInit(&pic_conf);
-    if (pic_conv_h == NULL) {
-        printf("failed to do PicConvInit()\n");
+    if ((verify || threads >= 0) && kernels == NULL) {
+        kernels = "auto";
+    }
+    if (kernels) {
+        pic_conv_h = PicConvCpuInit(&pic_conf);
+        if (pic_conv_h == NULL) {
+            printf("failed to do PicConvCpuInit()\n");
+            return -1;
+        }
+        if (strcmp(kernels, "auto") && PicConvCpuSetKernels(pic_conv_h, kernels) < 0) {
+            printf("no %s kernels on this cpu\n", kernels);
+            return -1;
+        }
+        printf("cpu converter with the %s kernels\n", PicConvCpuKernels(pic_conv_h));
+    } else {
+        pic_conv_h = PicConvInit(&pic_conf);
+        if (pic_conv_h == NULL) {
+            printf("failed to do PicConvInit()\n");
+            return -1;
+        }
+    }
+
+    in_size = PicConvCpuPicSize(in_fmt, in_w, in_h);
+    if (in_size == 0) {
+        printf("the size of a %s input picture is unknown\n", format_name(in_fmt));
         return -1;
     }
 
-    if (in_fmt == PIC_FMT_YUV420 || in_fmt == PIC_FMT_NV12) {
-        in_size = in_w * in_h * 3 / 2;
-    } else if (in_fmt == PIC_FMT_ABGR32 || in_fmt == PIC_FMT_ARGB32) {
-        in_size = in_w * in_h * 4;
+    if (nb_frames >= 0) {
+        memset(&stream, 0, sizeof(stream_t));
+        stream.handle    = pic_conv_h;
+        stream.cpu       = kernels != NULL;
+        stream.src       = pic_conf.src;
+        stream.src_size  = in_size;
+        stream.dest_size = PicConvCpuPicSize(conv_fmt, conv_w, conv_h);
+        stream.arc       = arc;
+        stream.fd        = fconv;
+        stream.first     = n;
+        stream.step      = step;
+
+        if (stream.dest_size == 0) {
+            printf("%s output pictures can not be streamed\n", format_name(conv_fmt));
+            return -1;
+        }
+        if (threads >= 0 && PicConvCpuSetThreads(pic_conv_h, threads) < 0) {
+            printf("failed to convert on %d threads\n", threads);
+            return -1;
+        }
+
+        if (arc) {
+            total = FrameArcCount(arc);
+        } else {
+            if (fstat(fin, &st) < 0 || st.st_size < (off_t)in_size) {
+                printf("no whole picture in the input file\n");
+                return -1;
+            }
+            stream.map_size = st.st_size;
+            stream.map = (unsigned char *)mmap(NULL, stream.map_size, PROT_READ, MAP_SHARED, fin, 0);
+            if (stream.map == MAP_FAILED) {
+                printf("failed to map the input file(error: %s)\n", strerror(errno));
+                return -1;
+            }
+            madvise(stream.map, stream.map_size, MADV_SEQUENTIAL);
+            total = st.st_size / in_size;
+        }
+
+        stream.nb_frames = n < total ? (total - n + step - 1) / step : 0;
+        if (nb_frames > stream.nb_frames) {
+            printf("%d frames from frame %d step %d are not in the input of %d frames\n",
+                    nb_frames, n, step, total);
+            return -1;
+        } else if (nb_frames > 0) {
+            stream.nb_frames = nb_frames;
+        }
+
+        ret = convert_stream(&stream);
+
+        if (stream.map) {
+            munmap(stream.map, stream.map_size);
+            close(fin);
+        } else {
+            FrameArcRelease(arc);
+        }
+        close(fconv);
+        if (kernels) {
+            PicConvCpuRelease(pic_conv_h);
+        } else {
+            PicConvRelease(pic_conv_h);
+        }
+
+        return ret;
     }
 
-    in_buf = (unsigned char *)malloc(in_size);
+    if (arc) {
+        /*a stored frame is used in the mapping, a compressed one is read*/
+        if (!compressed) {
+            in_buf = pic.data[0];
+        } else {
+            in_buf = in_alloc = (unsigned char *)malloc(pic.size);
+            if (in_buf == NULL || FrameArcRead(arc, n, &pic, in_buf, pic.size) < 0) {
+                printf("failed to read frame %d of the archive\n", n);
+                ret = -1;
+                goto end;
+            }
+        }
+    } else {
+        in_buf = in_alloc = (unsigned char *)malloc(in_size);
+        if (in_buf == NULL) {
+            printf("failed to malloc %u bytes of the input picture\n", in_size);
+            close(fin);
+            ret = -1;
+            goto end;
+        }
 
-    ret = read(fin, in_buf, in_size);
-    close(fin);
-    if (ret != in_size) {
-        printf("read %d bytes but expect %d bytes\n", ret, in_size);
-        return -1;
+        nread = pread(fin, in_buf, in_size, (off_t)n * in_size);
+        close(fin);
+        if (nread != (ssize_t)in_size) {
+            printf("read %zd bytes but expect %u bytes\n", nread, in_size);
+            ret = -1;
+            goto end;
+        }
     }
 
-    ret = PicConvProc(pic_conv_h, (void *)in_buf, (void **)&conv_buf, &conv_size);
+    if (threads >= 0) {
+        /*the first run makes the buffers of the threads*/
+        if (PicConvCpuSetThreads(pic_conv_h, 1) < 0 ||
+            (single_ms = time_conversions(pic_conv_h, in_buf, TIMED_RUNS)) < 0 ||
+            PicConvCpuSetThreads(pic_conv_h, threads) < 0 ||
+            time_conversions(pic_conv_h, in_buf, 1) < 0 ||
+            (multi_ms = time_conversions(pic_conv_h, in_buf, TIMED_RUNS)) < 0) {
+            printf("failed to time the conversions on %d threads\n", threads);
+            ret = -1;
+            goto end;
+        }
+        printf("latency of %d runs: %.3f ms on 1 thread, %.3f ms on %d threads, speedup %.2f\n",
+                TIMED_RUNS, single_ms, multi_ms, threads ? threads : (int)sysconf(_SC_NPROCESSORS_ONLN),
+                single_ms / multi_ms);
+    }
+
+    if (kernels) {
+        ret = PicConvCpuProc(pic_conv_h, (void *)in_buf, (void **)&conv_buf, &conv_size);
+    } else {
+        ret = PicConvProc(pic_conv_h, (void *)in_buf, (void **)&conv_buf, &conv_size);
+    }
     if (ret) {
         printf("failed to convert the picture(ret: %d)", ret);
-        return -1;
+        ret = -1;
+        goto end;
+    }
+
+    if (verify) {
+        ref_h = PicConvCpuInit(&pic_conf);
+        if (ref_h == NULL || PicConvCpuSetKernels(ref_h, "scalar") < 0 ||
+            PicConvCpuProc(ref_h, (void *)in_buf, (void **)&ref_buf, &ref_size)) {
+            printf("failed to convert the picture by the scalar kernels\n");
+            if (ref_h) {
+                PicConvCpuRelease(ref_h);
+            }
+            ret = -1;
+            goto end;
+        }
+        diff = 0;
+        for (i = 0; i < conv_size && i < ref_size; i++) {
+            diff += conv_buf[i] != ref_buf[i];
+        }
+        printf("%s kernels: %d of %u bytes differ from the scalar ones\n",
+                PicConvCpuKernels(pic_conv_h), diff, conv_size);
+        PicConvCpuRelease(ref_h);
+        if (diff) {
+            ret = -1;
+        }
     }
 
     write(fconv, conv_buf, conv_size);
+    printf("write out %u bytes converted picture file\n", conv_size);
+
+end:
+    free(in_alloc);
+    if (arc) {
+        FrameArcRelease(arc);
+    }
     close(fconv);
-    printf("write out %d bytes converted picture file\n", conv_size);
 
-    PicConvRelease(pic_conv_h);
+    if (kernels) {
+        PicConvCpuRelease(pic_conv_h);
+    } else {
+        PicConvRelease(pic_conv_h);
+    }
+
+    return ret;
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: picconv_api.c
+*
+* PURPOSE: the functions of picconverter.h by the CPU picture converter,
+*          on the hosts without the Jetson picconverter library
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+#include <stdio.h>
+
+#include "picconv_cpu.h"
+
+PIC_CONV_HANDLE_t PicConvInit(PicSetting_t *config)
+{
+    return PicConvCpuInit(config);
+}
+
+int PicConvProc(PIC_CONV_HANDLE_t handle, void *src_pic, void **dest_pic,
+                unsigned int *dest_pic_sz)
+{
+    return PicConvCpuProc(handle, src_pic, dest_pic, dest_pic_sz);
+}
+
+int PicConvProc_copy(PIC_CONV_HANDLE_t handle, void *src_pic, void *dest_pic,
+                     unsigned int *dest_pic_sz)
+{
+    return PicConvCpuProc_copy(handle, src_pic, dest_pic, dest_pic_sz);
+}
+
+void PicConvRelease(PIC_CONV_HANDLE_t handle)
+{
+    PicConvCpuRelease(handle);
+}
@@ -0,0 +1,1867 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: picconv_cpu.c
+*
+* PURPOSE: CPU implementation of the picture converter: the source is
+*          split into planes, each plane is cropped, scaled by separable
+*          fixed point filters, flipped and transposed, and the planes
+*          are converted and packed into the destination format
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Convert many crop rectangles in one call
+* 2026-10-18  Apoidea   Tensor destination
+* 2026-10-18  Apoidea   Band-parallel conversion
+************************************************************************/
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <libavutil/frame.h>
+
+#include "picconv_cpu.h"
+#include "picconv_kernels.h"
+#include "picconv_pool.h"
+
+#define MAX_PLANES     4     /*Y U V or R G B A*/
+#define TRANSPOSE_BLK  32
+#define ROI_CACHE      8     /*converters of the roi sizes kept by a worker*/
+#define BAND_ROWS      16    /*rows of the destination converted at a time at most*/
+
+/*where the planes are scaled*/
+enum {
+    SPACE_YUV = 0,
+    SPACE_RGB
+};
+
+typedef struct plane_t {
+    uint8_t *data;
+    int     stride;
+    int     w;
+    int     h;
+} plane_t;
+
+typedef struct filter_t {
+    int     taps;            /*of each output, the padding ones are 0*/
+    int     *pos;            /*the first input of each output*/
+    int16_t *coef;           /*taps of each output, their sum is 1 << PICCONV_COEF_BITS*/
+} filter_t;
+
+/*a plane from the source to the destination*/
+typedef struct wplane_t {
+    int      raw;            /*plane of the source picture, -1: constant*/
+    int      off;            /*bytes of the first sample in a pixel group*/
+    int      step;           /*bytes between the samples, 1: planar*/
+    int      crop_x;         /*in the samples of the plane*/
+    int      crop_y;
+    int      constant;       /*value of a plane which is not in the source*/
+
+    int      in_w, in_h;     /*cropped source plane*/
+    int      sw, sh;         /*scaled, before the transposition*/
+    int      out_w, out_h;   /*converted plane*/
+    int      h_identity;     /*no horizontal scaling or flip*/
+    int      v_identity;
+    int      v_first;        /*the vertical filter runs first, on the source rows*/
+    int      vsub;           /*log2 of the vertical subsampling to the destination*/
+    int      dest;           /*plane of the destination it is written into directly, -1: none*/
+    int      band;           /*scaled rows of a band*/
+    int      span;           /*source rows of a band at most*/
+
+    filter_t hf, vf;
+    uint8_t  *row_used;      /*source rows which vf uses*/
+
+    plane_t  sbuf;           /*scaled before the transposition*/
+    plane_t  obuf;           /*converted plane which is packed into the destination*/
+} wplane_t;
+
+/*the buffers of a worker, for the source rows of a band*/
+typedef struct scratch_t {
+    plane_t  unpacked[MAX_PLANES]; /*the source rows of an interleaved format*/
+    plane_t  hbuf[MAX_PLANES];     /*horizontally scaled source rows, or a vertically scaled row*/
+    int      h_lo[MAX_PLANES];     /*source rows in hbuf, the next band uses them again*/
+    int      h_hi[MAX_PLANES];
+    uint8_t  *row_buf;             /*a chroma row pair*/
+    uint8_t  *rgb_row;             /*a row converted to RGB for a tensor*/
+} scratch_t;
+
+/*of a tensor destination*/
+typedef struct tensor_t {
+    PicTensor_t   param;
+    PicCropRect_t box;           /*of the picture in the tensor*/
+    float         lut[3][256];   /*normalized pixel values of the channels of the tensor*/
+    uint16_t      lut16[3][256];
+    float         pad[3];
+    uint16_t      pad16[3];
+} tensor_t;
+
+typedef struct picconv_cpu_t picconv_cpu_t;
+
+/*the converters of the last roi sizes of a worker*/
+typedef struct roi_cache_t {
+    picconv_cpu_t *conv[ROI_CACHE];
+    uint64_t      used[ROI_CACHE];
+    uint64_t      clock;
+} roi_cache_t;
+
+struct picconv_cpu_t {
+    PicSetting_t            cfg;
+    PicCropRect_t           crop;
+    const picconv_kernels_t *k;
+
+    int          space;
+    int          fx, fy;      /*flips done by the filters*/
+    int          transpose;
+    int          nb_planes;
+    wplane_t     planes[MAX_PLANES];
+
+    plane_t      yuv[3];      /*RGB to YUV: full resolution Y of the packed formats, U and V*/
+
+    int          band;        /*destination rows of a band, even*/
+    scratch_t    *scratch;    /*of the workers*/
+    int          nb_scratch;
+
+    unsigned int dest_size;   /*0: no destination of its own, the handle converts rois*/
+    uint8_t      *dest_buf;   /*of PicConvCpuProc()*/
+    tensor_t     *tensor;     /*NULL: the destination is a picture*/
+
+    picconv_pool_t *pool;     /*NULL: one thread*/
+    roi_cache_t  *roi_caches; /*of the workers*/
+    int          nb_roi_caches;
+
+    /*of PicConvCpuProcRois()*/
+    void         *src_pic;
+    PicRoi_t     *rois;
+};
+
+static int is_rgb(PicFormat_t format)
+{
+    return format == PIC_FMT_ABGR32 || format == PIC_FMT_XRGB32 || format == PIC_FMT_ARGB32;
+}
+
+static int has_alpha(PicFormat_t format)
+{
+    return format == PIC_FMT_ABGR32 || format == PIC_FMT_ARGB32;
+}
+
+static int is_packed_422(PicFormat_t format)
+{
+    return format == PIC_FMT_UYVY || format == PIC_FMT_YUYV || format == PIC_FMT_YVYU;
+}
+
+static int has_chroma(PicFormat_t format)
+{
+    return !is_rgb(format) && format != PIC_FMT_GRAY8;
+}
+
+/*log2 of the chroma subsampling*/
+static void chroma_shift(PicFormat_t format, int *sx, int *sy)
+{
+    *sx = *sy = 0;
+    if (format == PIC_FMT_YUV420 || format == PIC_FMT_NV12 || format == PIC_FMT_NV21) {
+        *sx = *sy = 1;
+    } else if (is_packed_422(format)) {
+        *sx = 1;
+    }
+}
+
+/*byte offsets of R, G, B and A in a pixel*/
+static void rgb_offsets(PicFormat_t format, int off[4])
+{
+    if (format == PIC_FMT_ABGR32) {
+        off[0] = 2;
+        off[1] = 1;
+        off[2] = 0;
+    } else {
+        off[0] = 0;
+        off[1] = 1;
+        off[2] = 2;
+    }
+    off[3] = 3;
+}
+
+/*byte offsets of Y, U and V in the 4 bytes of 2 pixels*/
+static void packed_422_offsets(PicFormat_t format, int off[3])
+{
+    if (format == PIC_FMT_UYVY) {
+        off[0] = 1;
+        off[1] = 0;
+        off[2] = 2;
+    } else if (format == PIC_FMT_YUYV) {
+        off[0] = 0;
+        off[1] = 1;
+        off[2] = 3;
+    } else {
+        off[0] = 0;
+        off[1] = 3;
+        off[2] = 1;
+    }
+}
+
+unsigned int PicConvCpuPicSize(PicFormat_t format, unsigned int width, unsigned int height)
+{
+    unsigned int cw = (width + 1) / 2;
+    unsigned int ch = (height + 1) / 2;
+
+    switch (format) {
+        case PIC_FMT_YUV420:
+        case PIC_FMT_NV12:
+        case PIC_FMT_NV21:
+            return width * height + 2 * cw * ch;
+        case PIC_FMT_UYVY:
+        case PIC_FMT_YUYV:
+        case PIC_FMT_YVYU:
+            return cw * 4 * height;
+        case PIC_FMT_YUV444:
+            return width * height * 3;
+        case PIC_FMT_ABGR32:
+        case PIC_FMT_XRGB32:
+        case PIC_FMT_ARGB32:
+            return width * height * 4;
+        case PIC_FMT_GRAY8:
+            return width * height;
+        default:
+            return 0;
+    }
+}
+
+/*
+* the planes of a picture without stride padding
+*/
+static void plain_planes(PicFormat_t format, int w, int h, uint8_t *base, plane_t p[3])
+{
+    int cw = (w + 1) / 2;
+    int ch = (h + 1) / 2;
+
+    memset(p, 0, sizeof(plane_t) * 3);
+    p[0].data = base;
+    p[0].stride = w;
+
+    switch (format) {
+        case PIC_FMT_YUV420:
+            p[1].data = base + w * h;
+            p[1].stride = cw;
+            p[2].data = p[1].data + cw * ch;
+            p[2].stride = cw;
+            break;
+        case PIC_FMT_NV12:
+        case PIC_FMT_NV21:
+            p[1].data = base + w * h;
+            p[1].stride = cw * 2;
+            break;
+        case PIC_FMT_UYVY:
+        case PIC_FMT_YUYV:
+        case PIC_FMT_YVYU:
+            p[0].stride = cw * 4;
+            break;
+        case PIC_FMT_YUV444:
+            p[1].data = base + w * h;
+            p[1].stride = w;
+            p[2].data = p[1].data + w * h;
+            p[2].stride = w;
+            break;
+        case PIC_FMT_ABGR32:
+        case PIC_FMT_XRGB32:
+        case PIC_FMT_ARGB32:
+            p[0].stride = w * 4;
+            break;
+        default:
+            break;
+    }
+}
+
+static void source_planes(picconv_cpu_t *conv, void *src_pic, plane_t p[3])
+{
+    AVFrame *frame;
+    int i;
+
+    if (conv->cfg.pic_type == PIC_DATA_TYPE_ffmpeg) {
+        frame = (AVFrame *)src_pic;
+        for (i = 0; i < 3; i++) {
+            p[i].data = frame->data[i];
+            p[i].stride = frame->linesize[i];
+        }
+    } else {
+        plain_planes(conv->cfg.src.format, conv->cfg.src.width, conv->cfg.src.height,
+                     (uint8_t *)src_pic, p);
+    }
+}
+
+static int plane_alloc(plane_t *p, int w, int h)
+{
+    p->w = w;
+    p->h = h;
+    p->stride = (w + 63) & ~63;
+    p->data = (uint8_t *)malloc((size_t)p->stride * h);
+
+    return p->data ? 0 : -1;
+}
+
+static int interp_taps(PicInterp_t interp)
+{
+    switch (interp) {
+        case PIC_INTERP_NEAREST:
+            return 1;
+        case PIC_INTERP_5TAP:
+            return 5;
+        case PIC_INTERP_10TAP:
+        case PIC_INTERP_NICEST:
+            return 10;
+        default:
+            return 2;
+    }
+}
+
+static double lanczos2(double x)
+{
+    x = fabs(x);
+    if (x < 1e-9) {
+        return 1.0;
+    }
+    if (x >= 2.0) {
+        return 0.0;
+    }
+    return 2.0 * sin(M_PI * x) * sin(M_PI * x / 2.0) / (M_PI * M_PI * x * x);
+}
+
+/*
+* The filter of n_out outputs from n_in inputs, the outputs are in the
+* reversed order if flip. The nearest and bilinear ones are the usual
+* ones. The 5 and 10 tap ones are lanczos-2, stretched when downscaling
+* as far as the taps reach. The taps of a horizontal filter are padded to
+* 4, 8 or 16 for the SIMD kernels except the bilinear ones, and all of
+* them are in the input.
+*/
+static int build_filter(filter_t *f, int n_in, int n_out, PicInterp_t interp, int pad, int flip)
+{
+    int taps = n_in == n_out ? 1 : interp_taps(interp);
+    int size = taps;
+    int i, k, n, first, start, qa, qb, max_k, sum;
+    int idx[PICCONV_MAX_TAPS];
+    double wt[PICCONV_MAX_TAPS];
+    double w[PICCONV_MAX_TAPS];
+    double scale = (double)n_in / n_out;
+    double stretch, c, total;
+    int16_t *coef;
+    int16_t tmp[PICCONV_MAX_TAPS];
+
+    if (pad && taps > 2) {
+        size = taps <= 4 ? 4 : taps <= 8 ? 8 : 16;
+    }
+    if (size > n_in) {
+        size = n_in;
+    }
+    if (taps > size) {
+        taps = size;
+    }
+    stretch = scale < 1.0 ? 1.0 : scale > taps / 4.0 ? taps / 4.0 : scale;
+
+    f->taps = size;
+    f->pos = (int *)malloc(sizeof(int) * n_out);
+    f->coef = (int16_t *)calloc((size_t)n_out * size, sizeof(int16_t));
+    if (f->pos == NULL || f->coef == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < n_out; i++) {
+        c = (i + 0.5) * scale - 0.5;
+        if (taps == 1) {
+            idx[0] = n_in == n_out ? i : (int)((i + 0.5) * scale);
+            wt[0] = 1.0;
+            n = 1;
+        } else if (taps == 2) {
+            first = (int)floor(c);
+            idx[0] = first;
+            idx[1] = first + 1;
+            wt[1] = c - first;
+            wt[0] = 1.0 - wt[1];
+            n = 2;
+        } else {
+            first = (taps & 1) ? (int)lround(c) - taps / 2 : (int)floor(c) - (taps / 2 - 1);
+            for (k = 0; k < taps; k++) {
+                idx[k] = first + k;
+                wt[k] = lanczos2((first + k - c) / stretch);
+            }
+            n = taps;
+        }
+
+        /*the inputs out of the picture are its edges*/
+        qa = n_in;
+        qb = -1;
+        total = 0.0;
+        for (k = 0; k < n; k++) {
+            idx[k] = idx[k] < 0 ? 0 : idx[k] >= n_in ? n_in - 1 : idx[k];
+            qa = idx[k] < qa ? idx[k] : qa;
+            qb = idx[k] > qb ? idx[k] : qb;
+            total += wt[k];
+        }
+        start = qa < n_in - size ? qa : n_in - size;
+
+        memset(w, 0, sizeof(w));
+        for (k = 0; k < n; k++) {
+            w[idx[k] - start] += wt[k] / total;
+        }
+
+        /*the rounding error is put on the largest coefficient*/
+        coef = f->coef + (size_t)i * size;
+        sum = 0;
+        max_k = 0;
+        for (k = 0; k < size; k++) {
+            coef[k] = (int16_t)lround(w[k] * (1 << PICCONV_COEF_BITS));
+            sum += coef[k];
+            if (fabs(w[k]) > fabs(w[max_k])) {
+                max_k = k;
+            }
+        }
+        coef[max_k] += (1 << PICCONV_COEF_BITS) - sum;
+        f->pos[i] = start;
+    }
+
+    if (flip) {
+        for (i = 0; i < n_out / 2; i++) {
+            k = f->pos[i];
+            f->pos[i] = f->pos[n_out - 1 - i];
+            f->pos[n_out - 1 - i] = k;
+
+            memcpy(tmp, f->coef + (size_t)i * size, sizeof(int16_t) * size);
+            memcpy(f->coef + (size_t)i * size, f->coef + (size_t)(n_out - 1 - i) * size,
+                   sizeof(int16_t) * size);
+            memcpy(f->coef + (size_t)(n_out - 1 - i) * size, tmp, sizeof(int16_t) * size);
+        }
+    }
+
+    return 0;
+}
+
+static void wplane_free(wplane_t *wp)
+{
+    free(wp->hf.pos);
+    free(wp->hf.coef);
+    free(wp->vf.pos);
+    free(wp->vf.coef);
+    free(wp->row_used);
+    free(wp->sbuf.data);
+    free(wp->obuf.data);
+}
+
+/*
+* the filters and the buffers of a plane, its source and destination are set
+*/
+static int wplane_init(picconv_cpu_t *conv, wplane_t *wp)
+{
+    int y, t;
+
+    if (conv->transpose) {
+        wp->sw = wp->out_h;
+        wp->sh = wp->out_w;
+    } else {
+        wp->sw = wp->out_w;
+        wp->sh = wp->out_h;
+    }
+
+    if (wp->raw < 0) {
+        /*the destination planes are set in each conversion*/
+        if (wp->dest < 0) {
+            if (plane_alloc(&wp->obuf, wp->out_w, wp->out_h) < 0) {
+                return -1;
+            }
+            for (y = 0; y < wp->out_h; y++) {
+                memset(wp->obuf.data + y * wp->obuf.stride, wp->constant, wp->out_w);
+            }
+        }
+        return 0;
+    }
+
+    wp->h_identity = wp->in_w == wp->sw && !conv->fx;
+    wp->v_identity = wp->in_h == wp->sh && !conv->fy;
+
+    if (build_filter(&wp->hf, wp->in_w, wp->sw, conv->cfg.interp, 1, conv->fx) < 0 ||
+        build_filter(&wp->vf, wp->in_h, wp->sh, conv->cfg.interp, 0, conv->fy) < 0) {
+        return -1;
+    }
+
+    wp->row_used = (uint8_t *)calloc(wp->in_h, 1);
+    if (wp->row_used == NULL) {
+        return -1;
+    }
+    for (y = 0; y < wp->sh; y++) {
+        for (t = 0; t < wp->vf.taps; t++) {
+            wp->row_used[wp->vf.pos[y] + t] = 1;
+        }
+    }
+
+    /*
+    the horizontal filter gathers, it costs about 4 times the vertical
+    one of an output: the one which makes less rows runs first
+    */
+    if (!wp->h_identity && !wp->v_identity) {
+        wp->v_first = (int64_t)wp->sh * wp->in_w + (int64_t)wp->sh * wp->sw * 4 <
+                      (int64_t)wp->in_h * wp->sw * 4 + (int64_t)wp->sh * wp->sw;
+    }
+    if (conv->transpose && plane_alloc(&wp->sbuf, wp->sw, wp->sh) < 0) {
+        return -1;
+    }
+    if (wp->dest < 0 && plane_alloc(&wp->obuf, wp->out_w, wp->out_h) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+* the planes which are scaled, from the source formats to the destination ones
+*/
+static void setup_planes(picconv_cpu_t *conv)
+{
+    PicFormat_t src = conv->cfg.src.format;
+    PicFormat_t dst = conv->cfg.dest.format;
+    int dsx, dsy;
+    int off[4];
+    int i;
+    wplane_t *wp;
+
+    chroma_shift(dst, &dsx, &dsy);
+    conv->space = is_rgb(src) ? SPACE_RGB : SPACE_YUV;
+
+    if (conv->space == SPACE_RGB) {
+        /*R G B and the alpha if both have one*/
+        conv->nb_planes = has_alpha(src) && has_alpha(dst) ? 4 : 3;
+        rgb_offsets(src, off);
+        for (i = 0; i < conv->nb_planes; i++) {
+            wp = &conv->planes[i];
+            wp->raw = 0;
+            wp->off = off[i];
+            wp->step = 4;
+            wp->dest = -1;
+        }
+    } else {
+        conv->nb_planes = has_chroma(dst) || is_rgb(dst) ? 3 : 1;
+        if (is_packed_422(src)) {
+            packed_422_offsets(src, off);
+        }
+        for (i = 0; i < conv->nb_planes; i++) {
+            wp = &conv->planes[i];
+            wp->dest = -1;
+            if (i > 0 && !has_chroma(src)) {
+                wp->raw = -1;
+                wp->constant = 128;
+            } else if (is_packed_422(src)) {
+                wp->raw = 0;
+                wp->off = off[i];
+                wp->step = i ? 4 : 2;
+            } else if (src == PIC_FMT_NV12 || src == PIC_FMT_NV21) {
+                wp->raw = i ? 1 : 0;
+                wp->off = i == 0 ? 0 : (i == 1) == (src == PIC_FMT_NV12) ? 0 : 1;
+                wp->step = i ? 2 : 1;
+            } else {
+                wp->raw = i;
+                wp->step = 1;
+            }
+        }
+
+        /*the planar planes of the destination are written directly*/
+        if (!is_rgb(dst) && !is_packed_422(dst)) {
+            conv->planes[0].dest = 0;
+            if (dst == PIC_FMT_YUV420 || dst == PIC_FMT_YUV444) {
+                conv->planes[1].dest = 1;
+                conv->planes[2].dest = 2;
+            }
+        }
+    }
+
+    for (i = 0; i < conv->nb_planes; i++) {
+        wp = &conv->planes[i];
+
+        /*the planes are converted at the destination size except its chroma*/
+        wp->out_w = conv->cfg.dest.width;
+        wp->out_h = conv->cfg.dest.height;
+        if (i > 0 && conv->space == SPACE_YUV && !is_rgb(dst)) {
+            wp->out_w = (wp->out_w + (1 << dsx) - 1) >> dsx;
+            wp->out_h = (wp->out_h + (1 << dsy) - 1) >> dsy;
+            wp->vsub = dsy;
+        }
+    }
+}
+
+/*
+* the source rectangle of the planes, only its offsets change after the
+* filters are made
+*/
+static void set_crop(picconv_cpu_t *conv, const PicCropRect_t *crop)
+{
+    int sx, sy;
+    int i;
+    wplane_t *wp;
+
+    conv->crop = *crop;
+    chroma_shift(conv->cfg.src.format, &sx, &sy);
+
+    for (i = 0; i < conv->nb_planes; i++) {
+        wp = &conv->planes[i];
+        if (i == 0 || conv->space == SPACE_RGB) {
+            wp->crop_x = crop->x;
+            wp->crop_y = crop->y;
+            wp->in_w = crop->w;
+            wp->in_h = crop->h;
+        } else {
+            /*the chroma of the cropped pixels*/
+            wp->crop_x = crop->x >> sx;
+            wp->crop_y = crop->y >> sy;
+            wp->in_w = ((crop->x + crop->w + (1 << sx) - 1) >> sx) - wp->crop_x;
+            wp->in_h = ((crop->y + crop->h + (1 << sy) - 1) >> sy) - wp->crop_y;
+        }
+    }
+}
+
+static void scratch_free(picconv_cpu_t *conv)
+{
+    scratch_t *sc;
+    int i, j;
+
+    for (i = 0; i < conv->nb_scratch; i++) {
+        sc = &conv->scratch[i];
+        for (j = 0; j < MAX_PLANES; j++) {
+            free(sc->unpacked[j].data);
+            free(sc->hbuf[j].data);
+        }
+        free(sc->row_buf);
+        free(sc->rgb_row);
+    }
+    free(conv->scratch);
+    conv->scratch = NULL;
+    conv->nb_scratch = 0;
+}
+
+/*the source rows lo to hi of the scaled rows y0 to y1 - 1 of a plane*/
+static void source_rows(const wplane_t *wp, int y0, int y1, int *lo, int *hi)
+{
+    int a, b;
+
+    if (wp->v_identity) {
+        *lo = y0;
+        *hi = y1 - 1;
+        return;
+    }
+    /*the filter positions go up, or down if it flips*/
+    a = wp->vf.pos[y0];
+    b = wp->vf.pos[y1 - 1];
+    *lo = a < b ? a : b;
+    *hi = (a > b ? a : b) + wp->vf.taps - 1;
+}
+
+/*
+* The destination is converted in bands of rows, enough of them to share
+* among the workers, each worker has the buffers of the source rows of a
+* band. A transposed plane is scaled in the same number of bands, which
+* are columns of the destination.
+*/
+static int setup_bands(picconv_cpu_t *conv, int nb_workers)
+{
+    int dw = conv->cfg.dest.width;
+    int dh = conv->cfg.dest.height;
+    int nb_bands, i, j, y0, y1, lo, hi;
+    wplane_t *wp;
+    scratch_t *sc;
+
+    scratch_free(conv);
+
+    conv->band = (dh + nb_workers * 4 - 1) / (nb_workers * 4);
+    conv->band = conv->band > BAND_ROWS ? BAND_ROWS : (conv->band + 1) & ~1;
+    nb_bands = (dh + conv->band - 1) / conv->band;
+
+    for (i = 0; i < conv->nb_planes; i++) {
+        wp = &conv->planes[i];
+        wp->band = conv->transpose ? (wp->sh + nb_bands - 1) / nb_bands : conv->band >> wp->vsub;
+        if (wp->raw < 0) {
+            continue;
+        }
+        wp->span = 0;
+        for (y0 = 0; y0 < wp->sh; y0 += wp->band) {
+            y1 = y0 + wp->band < wp->sh ? y0 + wp->band : wp->sh;
+            source_rows(wp, y0, y1, &lo, &hi);
+            wp->span = hi - lo + 1 > wp->span ? hi - lo + 1 : wp->span;
+        }
+    }
+
+    conv->scratch = (scratch_t *)calloc(nb_workers, sizeof(scratch_t));
+    if (conv->scratch == NULL) {
+        return -1;
+    }
+    conv->nb_scratch = nb_workers;
+    for (j = 0; j < nb_workers; j++) {
+        sc = &conv->scratch[j];
+        for (i = 0; i < conv->nb_planes; i++) {
+            wp = &conv->planes[i];
+            if (wp->raw < 0) {
+                continue;
+            }
+            if (wp->step > 1 && plane_alloc(&sc->unpacked[i], wp->in_w, wp->span) < 0) {
+                return -1;
+            }
+            if (!wp->h_identity && !wp->v_identity &&
+                plane_alloc(&sc->hbuf[i], wp->v_first ? wp->in_w : wp->sw,
+                            wp->v_first ? 1 : wp->span) < 0) {
+                return -1;
+            }
+        }
+        sc->row_buf = (uint8_t *)malloc(dw + 2);
+        if (sc->row_buf == NULL) {
+            return -1;
+        }
+        if (conv->tensor) {
+            sc->rgb_row = (uint8_t *)malloc((size_t)dw * 4);
+            if (sc->rgb_row == NULL) {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void release(picconv_cpu_t *conv)
+{
+    int i, j;
+
+    picconv_pool_destroy(conv->pool);
+    for (i = 0; i < conv->nb_roi_caches; i++) {
+        for (j = 0; j < ROI_CACHE; j++) {
+            if (conv->roi_caches[i].conv[j]) {
+                release(conv->roi_caches[i].conv[j]);
+            }
+        }
+    }
+    free(conv->roi_caches);
+
+    for (i = 0; i < MAX_PLANES; i++) {
+        wplane_free(&conv->planes[i]);
+    }
+    for (i = 0; i < 3; i++) {
+        free(conv->yuv[i].data);
+    }
+    scratch_free(conv);
+    free(conv->dest_buf);
+    free(conv->tensor);
+    free(conv);
+}
+
+/*
+* return 0 if the crop rectangle is in the source and the destination is valid
+*/
+static int check_geometry(const PicSetting_t *config, const PicCropRect_t *crop,
+                          const PicParam_t *dest)
+{
+    if (dest->format >= PIC_FMT_JPEG || !dest->width || !dest->height) {
+        printf("pic_conv: invalid destination %dx%d of format %d\n",
+                dest->width, dest->height, dest->format);
+        return -1;
+    }
+    if (crop->x < 0 || crop->y < 0 || crop->w <= 0 || crop->h <= 0 ||
+        crop->x + crop->w > config->src.width || crop->y + crop->h > config->src.height) {
+        printf("pic_conv: the crop rectangle %d,%d %dx%d is out of the %dx%d picture\n",
+                crop->x, crop->y, crop->w, crop->h, config->src.width, config->src.height);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+* the converter of crop to config->dest, both are checked
+*/
+static picconv_cpu_t *conv_create(const PicSetting_t *config, const PicCropRect_t *crop)
+{
+    picconv_cpu_t *conv;
+    PicFormat_t dst = config->dest.format;
+    int dw = config->dest.width;
+    int dh = config->dest.height;
+    int i;
+
+    conv = (picconv_cpu_t *)calloc(1, sizeof(picconv_cpu_t));
+    if (conv == NULL) {
+        return NULL;
+    }
+    conv->cfg = *config;
+    conv->cfg.cropping = NULL;
+    conv->k = picconv_kernels_find(NULL);
+
+    /*
+    the flips are done by the filters in the reversed order, the
+    rotations are a flip and a transposition
+    */
+    switch (config->flip) {
+        case PIC_FLIP_180:
+            conv->fx = conv->fy = 1;
+            break;
+        case PIC_FLIP_FlipX:
+            conv->fx = 1;
+            break;
+        case PIC_FLIP_FlipY:
+            conv->fy = 1;
+            break;
+        case PIC_FLIP_90:
+            conv->fx = conv->transpose = 1;
+            break;
+        case PIC_FLIP_270:
+            conv->fy = conv->transpose = 1;
+            break;
+        case PIC_FLIP_Transpose:
+            conv->transpose = 1;
+            break;
+        case PIC_FLIP_InvTranspose:
+            conv->fx = conv->fy = conv->transpose = 1;
+            break;
+        default:
+            break;
+    }
+
+    setup_planes(conv);
+    set_crop(conv, crop);
+    for (i = 0; i < conv->nb_planes; i++) {
+        if (wplane_init(conv, &conv->planes[i]) < 0) {
+            goto fail;
+        }
+    }
+
+    /*RGB to YUV is at the full resolution, then the chroma is subsampled*/
+    if (conv->space == SPACE_RGB && !is_rgb(dst)) {
+        if (is_packed_422(dst) && plane_alloc(&conv->yuv[0], dw, dh) < 0) {
+            goto fail;
+        }
+        if (has_chroma(dst) && dst != PIC_FMT_YUV444 &&
+            (plane_alloc(&conv->yuv[1], dw, dh) < 0 || plane_alloc(&conv->yuv[2], dw, dh) < 0)) {
+            goto fail;
+        }
+    }
+    if (setup_bands(conv, 1) < 0) {
+        goto fail;
+    }
+
+    conv->dest_size = PicConvCpuPicSize(dst, dw, dh);
+    return conv;
+
+fail:
+    printf("pic_conv: failed to allocate the converter of %dx%d to %dx%d\n",
+            crop->w, crop->h, dw, dh);
+    release(conv);
+    return NULL;
+}
+
+PIC_CONV_HANDLE_t PicConvCpuInit(PicSetting_t *config)
+{
+    picconv_cpu_t *conv;
+    PicCropRect_t crop;
+
+    if (config == NULL) {
+        return NULL;
+    }
+    if (config->src.format >= PIC_FMT_JPEG || config->dest.format >= PIC_FMT_JPEG) {
+        printf("pic_conv: the cpu converter does not do the jpeg format\n");
+        return NULL;
+    }
+    if (!config->src.width || !config->src.height ||
+        config->flip >= PIC_FLIP_MAX || config->interp >= PIC_INTERP_MAX) {
+        printf("pic_conv: invalid setting\n");
+        return NULL;
+    }
+
+    /*a handle without a destination converts rois only*/
+    if (!config->dest.width && !config->dest.height) {
+        conv = (picconv_cpu_t *)calloc(1, sizeof(picconv_cpu_t));
+        if (conv == NULL) {
+            return NULL;
+        }
+        conv->cfg = *config;
+        conv->cfg.cropping = NULL;
+        conv->k = picconv_kernels_find(NULL);
+        return (PIC_CONV_HANDLE_t)conv;
+    }
+
+    if (config->cropping) {
+        crop = *config->cropping;
+    } else {
+        crop.x = crop.y = 0;
+        crop.w = config->src.width;
+        crop.h = config->src.height;
+    }
+    if (check_geometry(config, &crop, &config->dest) < 0) {
+        return NULL;
+    }
+
+    return (PIC_CONV_HANDLE_t)conv_create(config, &crop);
+}
+
+unsigned int PicConvCpuTensorSize(const PicTensor_t *tensor)
+{
+    if (tensor == NULL || tensor->type >= PIC_TENSOR_MAX) {
+        return 0;
+    }
+
+    return tensor->width * tensor->height * 3 *
+           (tensor->type == PIC_TENSOR_FP32 ? sizeof(float) : sizeof(uint16_t));
+}
+
+/*round to the nearest even, the values out of the range are infinite*/
+static uint16_t float_to_half(float f)
+{
+    uint32_t x, sign, mant, h, rem, half;
+    int exp, shift;
+
+    memcpy(&x, &f, sizeof(x));
+    sign = (x >> 16) & 0x8000;
+    mant = x & 0x7fffff;
+    if (((x >> 23) & 0xff) == 0xff) {
+        return sign | 0x7c00 | (mant ? 0x200 : 0);
+    }
+    exp = (int)((x >> 23) & 0xff) - 127 + 15;
+    if (exp >= 31) {
+        return sign | 0x7c00;
+    }
+    if (exp <= 0) {
+        /*subnormal*/
+        if (exp < -10) {
+            return sign;
+        }
+        mant |= 0x800000;
+        shift = 14 - exp;
+        h = mant >> shift;
+        rem = mant & ((1u << shift) - 1);
+        half = 1u << (shift - 1);
+    } else {
+        h = ((uint32_t)exp << 10) | (mant >> 13);
+        rem = mant & 0x1fff;
+        half = 0x1000;
+    }
+    /*a carry out of the mantissa goes into the exponent*/
+    if (rem > half || (rem == half && (h & 1))) {
+        h++;
+    }
+
+    return sign | h;
+}
+
+PIC_CONV_HANDLE_t PicConvCpuTensorInit(PicSetting_t *config, const PicTensor_t *tensor)
+{
+    picconv_cpu_t *conv;
+    tensor_t *t;
+    PicSetting_t cfg;
+    PicCropRect_t crop, box;
+    double scale, v;
+    int cw, ch, c, i;
+
+    if (config == NULL || tensor == NULL) {
+        return NULL;
+    }
+    if (tensor->type >= PIC_TENSOR_MAX || !tensor->width || !tensor->height ||
+        tensor->std[0] == 0.0f || tensor->std[1] == 0.0f || tensor->std[2] == 0.0f) {
+        printf("pic_conv: invalid tensor\n");
+        return NULL;
+    }
+
+    if (config->cropping) {
+        crop = *config->cropping;
+    } else {
+        crop.x = crop.y = 0;
+        crop.w = config->src.width;
+        crop.h = config->src.height;
+    }
+
+    /*the picture keeps its aspect ratio after it is rotated*/
+    box.x = box.y = 0;
+    box.w = tensor->width;
+    box.h = tensor->height;
+    if (tensor->letterbox && crop.w > 0 && crop.h > 0) {
+        cw = crop.w;
+        ch = crop.h;
+        if (config->flip == PIC_FLIP_90 || config->flip == PIC_FLIP_270 ||
+            config->flip == PIC_FLIP_Transpose || config->flip == PIC_FLIP_InvTranspose) {
+            cw = crop.h;
+            ch = crop.w;
+        }
+        scale = (double)tensor->width / cw < (double)tensor->height / ch ?
+                (double)tensor->width / cw : (double)tensor->height / ch;
+        box.w = (int)lround(cw * scale);
+        box.h = (int)lround(ch * scale);
+        box.w = box.w < 1 ? 1 : box.w > (int)tensor->width ? (int)tensor->width : box.w;
+        box.h = box.h < 1 ? 1 : box.h > (int)tensor->height ? (int)tensor->height : box.h;
+        box.x = ((int)tensor->width - box.w) / 2;
+        box.y = ((int)tensor->height - box.h) / 2;
+    }
+
+    /*the planes are scaled to the box as for an RGB destination*/
+    cfg = *config;
+    cfg.dest.format = PIC_FMT_XRGB32;
+    cfg.dest.width = box.w;
+    cfg.dest.height = box.h;
+    conv = (picconv_cpu_t *)PicConvCpuInit(&cfg);
+    if (conv == NULL) {
+        return NULL;
+    }
+
+    t = (tensor_t *)calloc(1, sizeof(tensor_t));
+    if (t == NULL) {
+        goto fail;
+    }
+    conv->tensor = t;
+    t->param = *tensor;
+    t->box = box;
+    if (setup_bands(conv, 1) < 0) {
+        goto fail;
+    }
+
+    for (c = 0; c < 3; c++) {
+        for (i = 0; i < 256; i++) {
+            v = (i / 255.0 - tensor->mean[c]) / tensor->std[c];
+            t->lut[c][i] = (float)v;
+            t->lut16[c][i] = float_to_half((float)v);
+        }
+        v = (tensor->pad / 255.0 - tensor->mean[c]) / tensor->std[c];
+        t->pad[c] = (float)v;
+        t->pad16[c] = float_to_half((float)v);
+    }
+
+    conv->dest_size = PicConvCpuTensorSize(tensor);
+    return (PIC_CONV_HANDLE_t)conv;
+
+fail:
+    printf("pic_conv: failed to allocate the %ux%u tensor\n", tensor->width, tensor->height);
+    release(conv);
+    return NULL;
+}
+
+/*a conversion on the workers*/
+typedef struct job_t {
+    picconv_cpu_t *conv;
+    plane_t       src_raw[3];
+    plane_t       dst_raw[3];
+    plane_t       out[MAX_PLANES];   /*where the planes are converted*/
+    uint8_t       *dest;
+} job_t;
+
+/*
+* the rows y0 to y1 - 1 of src into the columns y0 to y1 - 1 of dst,
+* src->data is the row y0
+*/
+static void transpose_rows(const plane_t *dst, const plane_t *src, int y0, int y1)
+{
+    int bx, by, x, y, xe, ye;
+
+    for (by = y0; by < y1; by += TRANSPOSE_BLK) {
+        ye = by + TRANSPOSE_BLK < y1 ? by + TRANSPOSE_BLK : y1;
+        for (bx = 0; bx < src->w; bx += TRANSPOSE_BLK) {
+            xe = bx + TRANSPOSE_BLK < src->w ? bx + TRANSPOSE_BLK : src->w;
+            for (y = by; y < ye; y++) {
+                for (x = bx; x < xe; x++) {
+                    dst->data[x * dst->stride + y] = src->data[(y - y0) * src->stride + x];
+                }
+            }
+        }
+    }
+}
+
+/*
+* the cropped source rows lo to hi of a plane, view->data is the row lo,
+* the samples of an interleaved format are copied out of the rows which
+* are used into unpacked
+*/
+static void source_view(picconv_cpu_t *conv, wplane_t *wp, const plane_t raw[3],
+                        const plane_t *unpacked, int lo, int hi, plane_t *view)
+{
+    const plane_t *r = &raw[wp->raw];
+    int y;
+
+    if (wp->step == 1) {
+        view->data = r->data + (wp->crop_y + lo) * r->stride + wp->crop_x;
+        view->stride = r->stride;
+    } else {
+        for (y = lo; y <= hi; y++) {
+            if (wp->row_used[y]) {
+                conv->k->unpack(unpacked->data + (y - lo) * unpacked->stride,
+                                r->data + (wp->crop_y + y) * r->stride +
+                                wp->crop_x * wp->step + wp->off,
+                                wp->step, wp->in_w);
+            }
+        }
+        view->data = unpacked->data;
+        view->stride = unpacked->stride;
+    }
+    view->w = wp->in_w;
+    view->h = hi - lo + 1;
+}
+
+/*
+* the scaled rows y0 to y1 - 1 of a plane i, src->data is the first source
+* row of source_rows(). The horizontally scaled source row r is in the
+* row r % span of hbuf, the ones of the last band of the worker which the
+* band uses are not scaled again.
+*/
+static void scale_rows(picconv_cpu_t *conv, wplane_t *wp, scratch_t *sc, int i,
+                       const plane_t *src, const plane_t *dst, int y0, int y1)
+{
+    const picconv_kernels_t *k = conv->k;
+    const plane_t *hbuf = &sc->hbuf[i];
+    const uint8_t *rows[PICCONV_MAX_TAPS];
+    int taps = wp->vf.taps;
+    int y, t, lo, hi;
+
+    source_rows(wp, y0, y1, &lo, &hi);
+
+    if (wp->v_first) {
+        for (y = y0; y < y1; y++) {
+            for (t = 0; t < taps; t++) {
+                rows[t] = src->data + (wp->vf.pos[y] + t - lo) * src->stride;
+            }
+            if (taps > 1) {
+                k->vscale(hbuf->data, wp->in_w, rows, wp->vf.coef + y * taps, taps);
+                rows[0] = hbuf->data;
+            }
+            k->hscale(dst->data + y * dst->stride, wp->sw, rows[0],
+                      wp->hf.pos, wp->hf.coef, wp->hf.taps);
+        }
+        return;
+    }
+
+    if (wp->h_identity) {
+        for (y = y0; y < y1; y++) {
+            if (taps == 1) {
+                memcpy(dst->data + y * dst->stride,
+                       src->data + (wp->vf.pos[y] - lo) * src->stride, wp->sw);
+                continue;
+            }
+            for (t = 0; t < taps; t++) {
+                rows[t] = src->data + (wp->vf.pos[y] + t - lo) * src->stride;
+            }
+            k->vscale(dst->data + y * dst->stride, wp->sw, rows, wp->vf.coef + y * taps, taps);
+        }
+        return;
+    }
+
+    if (wp->v_identity) {
+        for (y = y0; y < y1; y++) {
+            k->hscale(dst->data + y * dst->stride, wp->sw, src->data + (y - lo) * src->stride,
+                      wp->hf.pos, wp->hf.coef, wp->hf.taps);
+        }
+        return;
+    }
+
+    for (y = lo; y <= hi; y++) {
+        if (wp->row_used[y] && (y < sc->h_lo[i] || y > sc->h_hi[i])) {
+            k->hscale(hbuf->data + (y % hbuf->h) * hbuf->stride, wp->sw,
+                      src->data + (y - lo) * src->stride,
+                      wp->hf.pos, wp->hf.coef, wp->hf.taps);
+        }
+    }
+    sc->h_lo[i] = lo;
+    sc->h_hi[i] = hi;
+
+    for (y = y0; y < y1; y++) {
+        if (taps == 1) {
+            memcpy(dst->data + y * dst->stride,
+                   hbuf->data + (wp->vf.pos[y] % hbuf->h) * hbuf->stride, wp->sw);
+            continue;
+        }
+        for (t = 0; t < taps; t++) {
+            rows[t] = hbuf->data + ((wp->vf.pos[y] + t) % hbuf->h) * hbuf->stride;
+        }
+        k->vscale(dst->data + y * dst->stride, wp->sw, rows, wp->vf.coef + y * taps, taps);
+    }
+}
+
+/*
+* where a plane is converted: the destination, its obuf or the cropped
+* source if they are the same
+*/
+static void plane_target(picconv_cpu_t *conv, wplane_t *wp, const plane_t src_raw[3],
+                         const plane_t dst_raw[3], plane_t *out)
+{
+    if (wp->dest >= 0) {
+        out->data = dst_raw[wp->dest].data;
+        out->stride = dst_raw[wp->dest].stride;
+    } else if (wp->raw >= 0 && wp->step == 1 && wp->h_identity && wp->v_identity &&
+               !conv->transpose) {
+        out->data = src_raw[wp->raw].data + wp->crop_y * src_raw[wp->raw].stride + wp->crop_x;
+        out->stride = src_raw[wp->raw].stride;
+    } else {
+        *out = wp->obuf;
+    }
+    out->w = wp->out_w;
+    out->h = wp->out_h;
+}
+
+/*
+* the rows y0 to y1 - 1 of a plane which is not transposed, into out
+*/
+static void plane_rows(picconv_cpu_t *conv, wplane_t *wp, scratch_t *sc, int i,
+                       const plane_t src_raw[3], const plane_t *out, int y0, int y1)
+{
+    plane_t src, rows;
+    int lo, hi, y;
+
+    if (wp->raw < 0) {
+        /*the obuf is filled already*/
+        if (wp->dest >= 0) {
+            for (y = y0; y < y1; y++) {
+                memset(out->data + y * out->stride, wp->constant, out->w);
+            }
+        }
+        return;
+    }
+
+    source_rows(wp, y0, y1, &lo, &hi);
+    if (wp->h_identity && wp->v_identity) {
+        /*the interleaved samples are unpacked into out, else out is the source*/
+        rows = *out;
+        rows.data += y0 * rows.stride;
+        if (wp->step > 1) {
+            source_view(conv, wp, src_raw, &rows, lo, hi, &src);
+        } else if (wp->dest >= 0) {
+            source_view(conv, wp, src_raw, NULL, lo, hi, &src);
+            for (y = 0; y < y1 - y0; y++) {
+                memcpy(rows.data + y * rows.stride, src.data + y * src.stride, src.w);
+            }
+        }
+        return;
+    }
+
+    source_view(conv, wp, src_raw, &sc->unpacked[i], lo, hi, &src);
+    scale_rows(conv, wp, sc, i, &src, out, y0, y1);
+}
+
+/*
+* the scaled rows y0 to y1 - 1 of a transposed plane, which are the
+* columns y0 to y1 - 1 of out
+*/
+static void plane_columns(picconv_cpu_t *conv, wplane_t *wp, scratch_t *sc, int i,
+                          const plane_t src_raw[3], const plane_t *out, int y0, int y1)
+{
+    plane_t src, scaled;
+    int lo, hi, x;
+
+    if (wp->raw < 0) {
+        if (wp->dest >= 0) {
+            for (x = 0; x < out->h; x++) {
+                memset(out->data + x * out->stride + y0, wp->constant, y1 - y0);
+            }
+        }
+        return;
+    }
+
+    source_rows(wp, y0, y1, &lo, &hi);
+    source_view(conv, wp, src_raw, &sc->unpacked[i], lo, hi, &src);
+    if (wp->h_identity && wp->v_identity) {
+        scaled = src;
+    } else {
+        scale_rows(conv, wp, sc, i, &src, &wp->sbuf, y0, y1);
+        scaled = wp->sbuf;
+        scaled.data += y0 * scaled.stride;
+    }
+    scaled.w = wp->sw;
+    transpose_rows(out, &scaled, y0, y1);
+}
+
+/*n values of channel c of the tensor from offset, the pad ones if src is NULL*/
+static void tensor_values(const tensor_t *t, uint8_t *dest, size_t offset, int c,
+                          const uint8_t *src, int step, int n)
+{
+    float *f;
+    uint16_t *h;
+    int x;
+
+    if (t->param.type == PIC_TENSOR_FP32) {
+        const float *lut = t->lut[c];
+
+        f = (float *)dest + offset;
+        if (src == NULL) {
+            for (x = 0; x < n; x++) {
+                f[x] = t->pad[c];
+            }
+        } else {
+            for (x = 0; x < n; x++) {
+                f[x] = lut[src[x * step]];
+            }
+        }
+    } else {
+        const uint16_t *lut = t->lut16[c];
+
+        h = (uint16_t *)dest + offset;
+        if (src == NULL) {
+            for (x = 0; x < n; x++) {
+                h[x] = t->pad16[c];
+            }
+        } else {
+            for (x = 0; x < n; x++) {
+                h[x] = lut[src[x * step]];
+            }
+        }
+    }
+}
+
+/*the padding around the box in the rows r0 to r1 - 1 of the tensor*/
+static void fill_tensor_pad(const tensor_t *t, uint8_t *dest, int r0, int r1)
+{
+    int tw = t->param.width;
+    int th = t->param.height;
+    const PicCropRect_t *b = &t->box;
+    size_t plane = (size_t)tw * th;
+    size_t row;
+    int c, y;
+
+    for (c = 0; c < 3; c++) {
+        for (y = r0; y < r1; y++) {
+            row = c * plane + (size_t)y * tw;
+            if (y < b->y || y >= b->y + b->h) {
+                tensor_values(t, dest, row, c, NULL, 0, tw);
+            } else {
+                tensor_values(t, dest, row, c, NULL, 0, b->x);
+                tensor_values(t, dest, row + b->x + b->w, c, NULL, 0, tw - b->x - b->w);
+            }
+        }
+    }
+}
+
+/*
+* the rows y0 to y1 - 1 of the converted planes, RGB or YUV, normalized
+* into the box of the tensor
+*/
+static void store_tensor_rows(picconv_cpu_t *conv, const plane_t p[MAX_PLANES],
+                              scratch_t *sc, int y0, int y1, uint8_t *dest)
+{
+    const tensor_t *t = conv->tensor;
+    size_t plane = (size_t)t->param.width * t->param.height;
+    const uint8_t *rgb[3];
+    int step, y, c;
+
+    for (y = y0; y < y1; y++) {
+        if (conv->space == SPACE_YUV) {
+            conv->k->yuv_to_rgb32(sc->rgb_row, p[0].data + y * p[0].stride,
+                                  p[1].data + y * p[1].stride, p[2].data + y * p[2].stride,
+                                  t->box.w, 0);
+            for (c = 0; c < 3; c++) {
+                rgb[c] = sc->rgb_row + c;
+            }
+            step = 4;
+        } else {
+            for (c = 0; c < 3; c++) {
+                rgb[c] = p[c].data + y * p[c].stride;
+            }
+            step = 1;
+        }
+        for (c = 0; c < 3; c++) {
+            tensor_values(t, dest, c * plane + (size_t)(t->box.y + y) * t->param.width + t->box.x,
+                          c, rgb[t->param.bgr ? 2 - c : c], step, t->box.w);
+        }
+    }
+}
+
+/*the average of 2x2 samples of the rows a and b, of 2x1 if b is a*/
+static void average_row(uint8_t *dst, int dst_w, const uint8_t *a, const uint8_t *b, int w)
+{
+    int x, x0, x1;
+
+    for (x = 0; x < dst_w; x++) {
+        x0 = x * 2;
+        x1 = x0 + 1 < w ? x0 + 1 : w - 1;
+        dst[x] = (a[x0] + a[x1] + b[x0] + b[x1] + 2) >> 2;
+    }
+}
+
+static void interleave_row(uint8_t *dst, const uint8_t *a, const uint8_t *b, int w)
+{
+    int x;
+
+    for (x = 0; x < w; x++) {
+        dst[x * 2] = a[x];
+        dst[x * 2 + 1] = b[x];
+    }
+}
+
+static void pack_422_row(uint8_t *dst, PicFormat_t format, const uint8_t *y,
+                         const uint8_t *u, const uint8_t *v, int w)
+{
+    int off[3];
+    int x;
+
+    packed_422_offsets(format, off);
+    for (x = 0; x < (w + 1) / 2; x++) {
+        dst[off[0]] = y[x * 2];
+        dst[off[0] + 2] = y[x * 2 + 1 < w ? x * 2 + 1 : w - 1];
+        dst[off[1]] = u[x];
+        dst[off[2]] = v[x];
+        dst += 4;
+    }
+}
+
+/*
+* the chroma planes at the destination size packed into its rows y0 to
+* y1 - 1, y0 is even, or subsampled if full(RGB to YUV)
+*/
+static void store_chroma(picconv_cpu_t *conv, const plane_t *y, const plane_t *u,
+                         const plane_t *v, int full, const plane_t dst_raw[3],
+                         uint8_t *row_buf, int y0, int y1)
+{
+    PicFormat_t format = conv->cfg.dest.format;
+    int dw = conv->cfg.dest.width;
+    int dh = conv->cfg.dest.height;
+    int cw = (dw + 1) / 2;
+    uint8_t *ut = row_buf;
+    uint8_t *vt = row_buf + cw;
+    const uint8_t *a, *b;
+    int r;
+
+    if (format == PIC_FMT_YUV420 && full) {
+        for (r = y0 / 2; r < (y1 + 1) / 2; r++) {
+            a = u->data + r * 2 * u->stride;
+            b = r * 2 + 1 < dh ? a + u->stride : a;
+            average_row(dst_raw[1].data + r * dst_raw[1].stride, cw, a, b, dw);
+            a = v->data + r * 2 * v->stride;
+            b = r * 2 + 1 < dh ? a + v->stride : a;
+            average_row(dst_raw[2].data + r * dst_raw[2].stride, cw, a, b, dw);
+        }
+    } else if (format == PIC_FMT_NV12 || format == PIC_FMT_NV21) {
+        if (format == PIC_FMT_NV21) {
+            const plane_t *t = u;
+
+            u = v;
+            v = t;
+        }
+        for (r = y0 / 2; r < (y1 + 1) / 2; r++) {
+            if (full) {
+                a = u->data + r * 2 * u->stride;
+                average_row(ut, cw, a, r * 2 + 1 < dh ? a + u->stride : a, dw);
+                a = v->data + r * 2 * v->stride;
+                average_row(vt, cw, a, r * 2 + 1 < dh ? a + v->stride : a, dw);
+                interleave_row(dst_raw[1].data + r * dst_raw[1].stride, ut, vt, cw);
+            } else {
+                interleave_row(dst_raw[1].data + r * dst_raw[1].stride,
+                               u->data + r * u->stride, v->data + r * v->stride, cw);
+            }
+        }
+    } else if (is_packed_422(format)) {
+        for (r = y0; r < y1; r++) {
+            if (full) {
+                a = u->data + r * u->stride;
+                average_row(ut, cw, a, a, dw);
+                a = v->data + r * v->stride;
+                average_row(vt, cw, a, a, dw);
+                pack_422_row(dst_raw[0].data + r * dst_raw[0].stride, format,
+                             y->data + r * y->stride, ut, vt, dw);
+            } else {
+                pack_422_row(dst_raw[0].data + r * dst_raw[0].stride, format,
+                             y->data + r * y->stride, u->data + r * u->stride,
+                             v->data + r * v->stride, dw);
+            }
+        }
+    }
+}
+
+/*
+* the converted planes packed into the rows y0 to y1 - 1 of the destination
+*/
+static void store_planes(picconv_cpu_t *conv, const plane_t p[MAX_PLANES], const plane_t dst_raw[3],
+                         scratch_t *sc, int y0, int y1)
+{
+    PicFormat_t dst = conv->cfg.dest.format;
+    int dw = conv->cfg.dest.width;
+    int off[4];
+    plane_t yp, up, vp;
+    uint8_t *d, *yr, *ur, *vr;
+    int x, y, i;
+
+    if (conv->space == SPACE_YUV && is_rgb(dst)) {
+        for (y = y0; y < y1; y++) {
+            conv->k->yuv_to_rgb32(dst_raw[0].data + y * dst_raw[0].stride,
+                                  p[0].data + y * p[0].stride, p[1].data + y * p[1].stride,
+                                  p[2].data + y * p[2].stride, dw, dst == PIC_FMT_ABGR32);
+        }
+    } else if (conv->space == SPACE_YUV) {
+        if (has_chroma(dst)) {
+            store_chroma(conv, &p[0], &p[1], &p[2], 0, dst_raw, sc->row_buf, y0, y1);
+        }
+    } else if (is_rgb(dst)) {
+        rgb_offsets(dst, off);
+        for (y = y0; y < y1; y++) {
+            d = dst_raw[0].data + y * dst_raw[0].stride;
+            for (i = 0; i < 4; i++) {
+                if (i < conv->nb_planes) {
+                    const uint8_t *s = p[i].data + y * p[i].stride;
+
+                    for (x = 0; x < dw; x++) {
+                        d[x * 4 + off[i]] = s[x];
+                    }
+                } else {
+                    for (x = 0; x < dw; x++) {
+                        d[x * 4 + off[i]] = 255;
+                    }
+                }
+            }
+        }
+    } else {
+        /*RGB to YUV: Y into the destination unless it is packed*/
+        yp = is_packed_422(dst) ? conv->yuv[0] : dst_raw[0];
+        up = dst == PIC_FMT_YUV444 ? dst_raw[1] : conv->yuv[1];
+        vp = dst == PIC_FMT_YUV444 ? dst_raw[2] : conv->yuv[2];
+        for (y = y0; y < y1; y++) {
+            yr = yp.data + y * yp.stride;
+            ur = has_chroma(dst) ? up.data + y * up.stride : NULL;
+            vr = has_chroma(dst) ? vp.data + y * vp.stride : NULL;
+            conv->k->rgb_to_yuv(yr, ur, vr, p[0].data + y * p[0].stride,
+                                p[1].data + y * p[1].stride, p[2].data + y * p[2].stride, dw);
+        }
+        if (has_chroma(dst) && dst != PIC_FMT_YUV444) {
+            store_chroma(conv, &yp, &up, &vp, 1, dst_raw, sc->row_buf, y0, y1);
+        }
+    }
+}
+
+/*the band of the destination, or of the tensor, from the converted planes*/
+static void store_band(job_t *job, scratch_t *sc, int band)
+{
+    picconv_cpu_t *conv = job->conv;
+    const tensor_t *t = conv->tensor;
+    int dh = conv->cfg.dest.height;
+    int y0 = band * conv->band;
+    int y1 = y0 + conv->band < dh ? y0 + conv->band : dh;
+
+    if (t) {
+        /*the first and the last bands pad the rows above and below the box*/
+        fill_tensor_pad(t, job->dest, band == 0 ? 0 : t->box.y + y0,
+                        y1 == dh ? (int)t->param.height : t->box.y + y1);
+        store_tensor_rows(conv, job->out, sc, y0, y1, job->dest);
+    } else {
+        store_planes(conv, job->out, job->dst_raw, sc, y0, y1);
+    }
+}
+
+/*a band of the planes which are not transposed and of the destination*/
+static void band_task(void *opaque, int task, int worker)
+{
+    job_t *job = (job_t *)opaque;
+    picconv_cpu_t *conv = job->conv;
+    scratch_t *sc = &conv->scratch[worker];
+    wplane_t *wp;
+    int i, y0, y1;
+
+    for (i = 0; i < conv->nb_planes; i++) {
+        wp = &conv->planes[i];
+        y0 = task * wp->band;
+        y1 = y0 + wp->band < wp->sh ? y0 + wp->band : wp->sh;
+        if (y0 < y1) {
+            plane_rows(conv, wp, sc, i, job->src_raw, &job->out[i], y0, y1);
+        }
+    }
+    store_band(job, sc, task);
+}
+
+/*a band of a transposed plane*/
+static void column_task(void *opaque, int task, int worker)
+{
+    job_t *job = (job_t *)opaque;
+    picconv_cpu_t *conv = job->conv;
+    int i = task % conv->nb_planes;
+    wplane_t *wp = &conv->planes[i];
+    int y0 = task / conv->nb_planes * wp->band;
+    int y1 = y0 + wp->band < wp->sh ? y0 + wp->band : wp->sh;
+
+    if (y0 < y1) {
+        plane_columns(conv, wp, &conv->scratch[worker], i, job->src_raw, &job->out[i], y0, y1);
+    }
+}
+
+static void store_task(void *opaque, int task, int worker)
+{
+    job_t *job = (job_t *)opaque;
+
+    store_band(job, &job->conv->scratch[worker], task);
+}
+
+static void run_tasks(picconv_cpu_t *conv, int nb_tasks, picconv_task_fn fn, job_t *job)
+{
+    int i;
+
+    if (conv->pool && nb_tasks > 1) {
+        picconv_pool_run(conv->pool, nb_tasks, fn, job);
+    } else {
+        for (i = 0; i < nb_tasks; i++) {
+            fn(job, i, 0);
+        }
+    }
+}
+
+/*
+* The bands are run on the workers of the handle. The bands of a
+* transposed plane are columns of the destination, all of them are
+* converted before the destination is stored.
+*/
+static int convert(picconv_cpu_t *conv, void *src_pic, uint8_t *dest)
+{
+    job_t job;
+    int nb_bands;
+    int i, j;
+
+    if (src_pic == NULL || dest == NULL || conv->dest_size == 0) {
+        return -1;
+    }
+
+    job.conv = conv;
+    job.dest = dest;
+    source_planes(conv, src_pic, job.src_raw);
+    if (conv->tensor) {
+        memset(job.dst_raw, 0, sizeof(job.dst_raw));
+    } else {
+        plain_planes(conv->cfg.dest.format, conv->cfg.dest.width, conv->cfg.dest.height,
+                     dest, job.dst_raw);
+    }
+    for (i = 0; i < conv->nb_planes; i++) {
+        plane_target(conv, &conv->planes[i], job.src_raw, job.dst_raw, &job.out[i]);
+    }
+    /*the rows of the last conversion in the buffers are not used*/
+    for (j = 0; j < conv->nb_scratch; j++) {
+        for (i = 0; i < MAX_PLANES; i++) {
+            conv->scratch[j].h_lo[i] = 0;
+            conv->scratch[j].h_hi[i] = -1;
+        }
+    }
+
+    nb_bands = (conv->cfg.dest.height + conv->band - 1) / conv->band;
+    if (conv->transpose) {
+        run_tasks(conv, nb_bands * conv->nb_planes, column_task, &job);
+        run_tasks(conv, nb_bands, store_task, &job);
+    } else {
+        run_tasks(conv, nb_bands, band_task, &job);
+    }
+
+    return 0;
+}
+
+int PicConvCpuProc(PIC_CONV_HANDLE_t handle, void *src_pic, void **dest_pic,
+                   unsigned int *dest_pic_sz)
+{
+    picconv_cpu_t *conv = (picconv_cpu_t *)handle;
+
+    if (conv == NULL || dest_pic == NULL || conv->dest_size == 0) {
+        return -1;
+    }
+    if (conv->dest_buf == NULL) {
+        conv->dest_buf = (uint8_t *)malloc(conv->dest_size);
+        if (conv->dest_buf == NULL) {
+            return -1;
+        }
+    }
+    if (convert(conv, src_pic, conv->dest_buf) < 0) {
+        return -1;
+    }
+
+    *dest_pic = conv->dest_buf;
+    if (dest_pic_sz) {
+        *dest_pic_sz = conv->dest_size;
+    }
+
+    return 0;
+}
+
+int PicConvCpuProc_copy(PIC_CONV_HANDLE_t handle, void *src_pic, void *dest_pic,
+                        unsigned int *dest_pic_sz)
+{
+    picconv_cpu_t *conv = (picconv_cpu_t *)handle;
+
+    if (conv == NULL || convert(conv, src_pic, (uint8_t *)dest_pic) < 0) {
+        return -1;
+    }
+    if (dest_pic_sz) {
+        *dest_pic_sz = conv->dest_size;
+    }
+
+    return 0;
+}
+
+void PicConvCpuRelease(PIC_CONV_HANDLE_t handle)
+{
+    if (handle) {
+        release((picconv_cpu_t *)handle);
+    }
+}
+
+/*
+* the converter of the roi size in the cache of the worker, the least
+* recently used one is replaced by a new one
+*/
+static picconv_cpu_t *roi_conv(picconv_cpu_t *conv, roi_cache_t *cache, const PicRoi_t *roi)
+{
+    picconv_cpu_t *rc;
+    PicSetting_t cfg;
+    int victim = 0;
+    int i;
+
+    if (check_geometry(&conv->cfg, &roi->crop, &roi->dest) < 0) {
+        return NULL;
+    }
+
+    /*the chroma of a crop depends on the parity of its offsets*/
+    cache->clock++;
+    for (i = 0; i < ROI_CACHE; i++) {
+        rc = cache->conv[i];
+        if (rc && rc->crop.w == roi->crop.w && rc->crop.h == roi->crop.h &&
+            !((rc->crop.x ^ roi->crop.x) & 1) && !((rc->crop.y ^ roi->crop.y) & 1) &&
+            rc->cfg.dest.format == roi->dest.format &&
+            rc->cfg.dest.width == roi->dest.width && rc->cfg.dest.height == roi->dest.height) {
+            cache->used[i] = cache->clock;
+            set_crop(rc, &roi->crop);
+            rc->k = conv->k;
+            return rc;
+        }
+        if (cache->used[i] < cache->used[victim]) {
+            victim = i;
+        }
+    }
+
+    cfg = conv->cfg;
+    cfg.dest = roi->dest;
+    rc = conv_create(&cfg, &roi->crop);
+    if (rc == NULL) {
+        return NULL;
+    }
+    if (cache->conv[victim]) {
+        release(cache->conv[victim]);
+    }
+    cache->conv[victim] = rc;
+    cache->used[victim] = cache->clock;
+    rc->k = conv->k;
+
+    return rc;
+}
+
+static void roi_task(void *opaque, int task, int worker)
+{
+    picconv_cpu_t *conv = (picconv_cpu_t *)opaque;
+    PicRoi_t *roi = &conv->rois[task];
+    picconv_cpu_t *rc = roi_conv(conv, &conv->roi_caches[worker], roi);
+
+    roi->dest_pic_sz = 0;
+    if (rc && convert(rc, conv->src_pic, (uint8_t *)roi->dest_pic) == 0) {
+        roi->dest_pic_sz = rc->dest_size;
+    }
+}
+
+int PicConvCpuProcRois(PIC_CONV_HANDLE_t handle, void *src_pic, PicRoi_t *rois, int nb_rois)
+{
+    picconv_cpu_t *conv = (picconv_cpu_t *)handle;
+    roi_cache_t *caches;
+    int nb_workers;
+    int failed = 0;
+    int i;
+
+    if (conv == NULL || src_pic == NULL || (rois == NULL && nb_rois > 0)) {
+        return -1;
+    }
+
+    /*a cache for each worker, which is only used by it*/
+    nb_workers = conv->pool ? picconv_pool_threads(conv->pool) : 1;
+    if (nb_workers > conv->nb_roi_caches) {
+        caches = (roi_cache_t *)realloc(conv->roi_caches, sizeof(roi_cache_t) * nb_workers);
+        if (caches == NULL) {
+            return -1;
+        }
+        memset(caches + conv->nb_roi_caches, 0,
+               sizeof(roi_cache_t) * (nb_workers - conv->nb_roi_caches));
+        conv->roi_caches = caches;
+        conv->nb_roi_caches = nb_workers;
+    }
+
+    /*each roi reads its rectangle of the source only*/
+    conv->src_pic = src_pic;
+    conv->rois = rois;
+    if (conv->pool && nb_rois > 1) {
+        picconv_pool_run(conv->pool, nb_rois, roi_task, conv);
+    } else {
+        for (i = 0; i < nb_rois; i++) {
+            roi_task(conv, i, 0);
+        }
+    }
+
+    for (i = 0; i < nb_rois; i++) {
+        failed += rois[i].dest_pic_sz == 0;
+    }
+
+    return failed ? -1 : 0;
+}
+
+int PicConvCpuSetThreads(PIC_CONV_HANDLE_t handle, int threads)
+{
+    picconv_cpu_t *conv = (picconv_cpu_t *)handle;
+
+    if (conv == NULL || threads < 0) {
+        return -1;
+    }
+    if (threads == 0) {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    picconv_pool_destroy(conv->pool);
+    conv->pool = NULL;
+    if (threads > 1) {
+        conv->pool = picconv_pool_create(threads);
+        if (conv->pool == NULL) {
+            return -1;
+        }
+    }
+
+    /*each worker has its buffers, a handle of rois only has none*/
+    if (conv->dest_size) {
+        return setup_bands(conv, conv->pool ? picconv_pool_threads(conv->pool) : 1);
+    }
+
+    return 0;
+}
+
+int PicConvCpuSetKernels(PIC_CONV_HANDLE_t handle, const char *name)
+{
+    picconv_cpu_t *conv = (picconv_cpu_t *)handle;
+    const picconv_kernels_t *k = picconv_kernels_find(name);
+
+    if (conv == NULL || k == NULL) {
+        return -1;
+    }
+    conv->k = k;
+
+    return 0;
+}
+
+int PicConvCpuTensorBox(PIC_CONV_HANDLE_t handle, PicCropRect_t *box)
+{
+    picconv_cpu_t *conv = (picconv_cpu_t *)handle;
+
+    if (conv == NULL || conv->tensor == NULL || box == NULL) {
+        return -1;
+    }
+    *box = conv->tensor->box;
+
+    return 0;
+}
+
+const char *PicConvCpuKernels(PIC_CONV_HANDLE_t handle)
+{
+    picconv_cpu_t *conv = (picconv_cpu_t *)handle;
+
+    return conv ? conv->k->name : NULL;
+}
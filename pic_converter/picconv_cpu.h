@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: picconv_cpu.h
+*
+* PURPOSE: CPU implementation of the picture converter(picconverter.h),
+*          with SSE4.1/AVX2 or NEON kernels chosen at runtime and the
+*          scalar reference kernels
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Convert many crop rectangles in one call
+* 2026-10-18  Apoidea   Tensor destination
+* 2026-10-18  Apoidea   Band-parallel conversion
+************************************************************************/
+
+#ifndef __PICCONV_CPU_H_
+#define __PICCONV_CPU_H_
+
+#include <sys/cdefs.h>
+
+#include "picconverter.h"
+
+__BEGIN_DECLS
+
+/*
+The functions do what the ones of picconverter.h do, on the CPU. They
+have their own names, so both the hardware library and the CPU one can be
+linked into a program. On the hosts without the hardware library,
+picconv_api.c gives them the names of picconverter.h.
+
+All the PicFormat_t pairs are converted except PIC_FMT_JPEG, which is
+encoded by the jpeg encoder library. The YUV formats are BT.601 limited
+range. The crop rectangle is rounded to even offsets of the chroma
+planes. PIC_INTERP_DEFAULT/SMART are bilinear, PIC_INTERP_NICEST is
+10-tap.
+
+A handle is used by one thread at a time.
+*/
+
+/*a crop rectangle of the source and its destination picture*/
+typedef struct _PicRoi_t {
+    PicCropRect_t crop;
+    PicParam_t    dest;          /*PIC_FMT_JPEG is not allowed*/
+    void          *dest_pic;     /*provided by the caller, of PicConvCpuPicSize() bytes*/
+    unsigned int  dest_pic_sz;   /*the converted bytes, 0 if the roi failed*/
+} PicRoi_t;
+
+/*element type of a tensor*/
+typedef enum {
+    PIC_TENSOR_FP32 = 0,
+    PIC_TENSOR_FP16,         /*IEEE half precision*/
+
+    PIC_TENSOR_MAX
+} PicTensorType_t;
+
+/*
+A tensor destination: the RGB planes of the picture, CHW with N of 1, of
+    value = (pixel / 255 - mean[c]) / std[c]
+where c is the channel of the tensor. If letterbox, the picture keeps its
+aspect ratio in the middle of the tensor and the rest is pad.
+*/
+typedef struct _PicTensor_t {
+    PicTensorType_t type;
+    unsigned int    width;
+    unsigned int    height;
+    int             bgr;       /*the channels are B G R, not R G B*/
+    int             letterbox; /*0: the picture is stretched to the tensor*/
+    float           mean[3];   /*of the channels of the tensor*/
+    float           std[3];    /*not 0*/
+    float           pad;       /*pixel value of the padding, 114 for yolo*/
+} PicTensor_t;
+
+PIC_CONV_HANDLE_t PicConvCpuInit(PIC_CONV_IN PicSetting_t *config);
+
+/*
+* To generate a converter of config->src to the tensor, config->dest is
+* not used. The source is converted to RGB, scaled, normalized and
+* written into the planes of the tensor in one pass over bands of rows.
+* PicConvCpuProc() and PicConvCpuProc_copy() give the tensor, of
+* PicConvCpuTensorSize() bytes.
+*/
+PIC_CONV_HANDLE_t PicConvCpuTensorInit(PIC_CONV_IN PicSetting_t *config,
+                                       PIC_CONV_IN const PicTensor_t *tensor);
+
+/*
+* Bytes of the tensor
+*/
+unsigned int PicConvCpuTensorSize(PIC_CONV_IN const PicTensor_t *tensor);
+
+/*
+* return the rectangle of the tensor where the picture is, to map the
+* detections back to the source, 0 on success, -1 if the handle has no
+* tensor
+*/
+int PicConvCpuTensorBox(PIC_CONV_IN  PIC_CONV_HANDLE_t handle,
+                        PIC_CONV_OUT PicCropRect_t *box);
+
+int PicConvCpuProc(PIC_CONV_IN  PIC_CONV_HANDLE_t handle,
+                   PIC_CONV_IN  void *src_pic,
+                   PIC_CONV_OUT void **dest_pic,
+                   PIC_CONV_OUT unsigned int *dest_pic_sz);
+
+int PicConvCpuProc_copy(PIC_CONV_IN    PIC_CONV_HANDLE_t handle,
+                        PIC_CONV_IN    void *src_pic,
+                        PIC_CONV_INOUT void *dest_pic,
+                        PIC_CONV_OUT   unsigned int *dest_pic_sz);
+
+void PicConvCpuRelease(PIC_CONV_IN PIC_CONV_HANDLE_t handle);
+
+/*
+* To crop and convert the rois of one source picture in one call, with the
+* source, the flip and the interpolation of the handle setting. A roi only
+* reads its rectangle of the source. The rois are spread over the threads
+* of PicConvCpuSetThreads().
+* A handle which converts rois only is made with config->dest of 0x0.
+* The filters of the last roi sizes are kept, the sizes which come again
+* don't make them again.
+*   return 0 on success, -1 if a roi failed: its dest_pic_sz is 0
+*/
+int PicConvCpuProcRois(PIC_CONV_IN    PIC_CONV_HANDLE_t handle,
+                       PIC_CONV_IN    void *src_pic,
+                       PIC_CONV_INOUT PicRoi_t *rois,
+                       PIC_CONV_IN    int nb_rois);
+
+/*
+* To run the conversions of the handle on threads threads, the caller is
+* one of them, 0: one for each cpu. The default is 1.
+* A picture is converted in bands of rows which are spread over the
+* threads, the result is the same for any number of them.
+*   return 0 on success, -1 on failure
+*/
+int PicConvCpuSetThreads(PIC_CONV_IN PIC_CONV_HANDLE_t handle,
+                         PIC_CONV_IN int threads);
+
+/*
+* To choose the kernels of the handle:
+*   "scalar", "sse4", "avx2", "neon", or NULL for the best ones of the CPU,
+*   which PicConvCpuInit() chooses
+*   return 0 on success, -1 if the CPU does not have them
+*/
+int PicConvCpuSetKernels(PIC_CONV_IN PIC_CONV_HANDLE_t handle,
+                         PIC_CONV_IN const char *name);
+
+/*
+* return the name of the kernels of the handle
+*/
+const char *PicConvCpuKernels(PIC_CONV_IN PIC_CONV_HANDLE_t handle);
+
+/*
+* Bytes of a picture without stride padding, 0 if the format is PIC_FMT_JPEG
+*/
+unsigned int PicConvCpuPicSize(PIC_CONV_IN PicFormat_t format,
+                               PIC_CONV_IN unsigned int width,
+                               PIC_CONV_IN unsigned int height);
+
+__END_DECLS
+
+#endif /* __PICCONV_CPU_H_ */
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: picconv_kernels.c
+*
+* PURPOSE: the scalar reference row kernels of the CPU picture converter
+*          and the runtime choice of the SIMD ones
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Detect the CPU once
+* 2026-10-18  Apoidea   Unpack kernel
+************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "picconv_kernels.h"
+
+static inline uint8_t clip_u8(int v)
+{
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+void picconv_hscale_c(uint8_t *dst, int dst_w, const uint8_t *src,
+                      const int *pos, const int16_t *coef, int taps)
+{
+    int i, t;
+    int sum;
+    const uint8_t *s;
+
+    if (taps == 1) {
+        for (i = 0; i < dst_w; i++) {
+            dst[i] = src[pos[i]];
+        }
+        return;
+    }
+
+    for (i = 0; i < dst_w; i++) {
+        s = src + pos[i];
+        sum = 1 << (PICCONV_COEF_BITS - 1);
+        for (t = 0; t < taps; t++) {
+            sum += s[t] * coef[t];
+        }
+        dst[i] = clip_u8(sum >> PICCONV_COEF_BITS);
+        coef += taps;
+    }
+}
+
+void picconv_vscale_c(uint8_t *dst, int w, const uint8_t *const *rows,
+                      const int16_t *coef, int taps)
+{
+    int x, t;
+    int sum;
+
+    for (x = 0; x < w; x++) {
+        sum = 1 << (PICCONV_COEF_BITS - 1);
+        for (t = 0; t < taps; t++) {
+            sum += rows[t][x] * coef[t];
+        }
+        dst[x] = clip_u8(sum >> PICCONV_COEF_BITS);
+    }
+}
+
+void picconv_yuv_to_rgb32_c(uint8_t *dst, const uint8_t *y, const uint8_t *u,
+                            const uint8_t *v, int w, int swap_rb)
+{
+    int x;
+    int c, d, e;
+    int r_off = swap_rb ? 2 : 0;
+    int b_off = swap_rb ? 0 : 2;
+
+    for (x = 0; x < w; x++) {
+        c = y[x] - 16;
+        d = u[x] - 128;
+        e = v[x] - 128;
+        dst[r_off] = clip_u8((298 * c + 409 * e + 128) >> 8);
+        dst[1]     = clip_u8((298 * c - 100 * d - 208 * e + 128) >> 8);
+        dst[b_off] = clip_u8((298 * c + 516 * d + 128) >> 8);
+        dst[3]     = 255;
+        dst += 4;
+    }
+}
+
+void picconv_rgb_to_yuv_c(uint8_t *y, uint8_t *u, uint8_t *v, const uint8_t *r,
+                          const uint8_t *g, const uint8_t *b, int w)
+{
+    int x;
+
+    for (x = 0; x < w; x++) {
+        y[x] = ((66 * r[x] + 129 * g[x] + 25 * b[x] + 128) >> 8) + 16;
+    }
+    if (u == NULL) {
+        return;
+    }
+    for (x = 0; x < w; x++) {
+        u[x] = ((-38 * r[x] - 74 * g[x] + 112 * b[x] + 128) >> 8) + 128;
+        v[x] = ((112 * r[x] - 94 * g[x] - 18 * b[x] + 128) >> 8) + 128;
+    }
+}
+
+void picconv_unpack_c(uint8_t *dst, const uint8_t *src, int step, int w)
+{
+    int x;
+
+    for (x = 0; x < w; x++) {
+        dst[x] = src[x * step];
+    }
+}
+
+const picconv_kernels_t picconv_kernels_c = {
+    .name         = "scalar",
+    .hscale       = picconv_hscale_c,
+    .vscale       = picconv_vscale_c,
+    .yuv_to_rgb32 = picconv_yuv_to_rgb32_c,
+    .rgb_to_yuv   = picconv_rgb_to_yuv_c,
+    .unpack       = picconv_unpack_c,
+};
+
+static pthread_once_t cpu_once = PTHREAD_ONCE_INIT;
+static int cpu_avx2;
+static int cpu_sse4;
+
+/*cpuid is slow in the virtual machines, it is asked once*/
+static void cpu_detect(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    cpu_avx2 = __builtin_cpu_supports("avx2");
+    cpu_sse4 = __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+/*
+* return 1 if the CPU runs the kernels
+*/
+static int cpu_has(const picconv_kernels_t *k)
+{
+    pthread_once(&cpu_once, cpu_detect);
+#if defined(__x86_64__) || defined(__i386__)
+    if (k == &picconv_kernels_avx2) {
+        return cpu_avx2;
+    }
+    if (k == &picconv_kernels_sse4) {
+        return cpu_sse4;
+    }
+#endif
+    /*NEON is in all the aarch64 CPUs*/
+    return 1;
+}
+
+const picconv_kernels_t *picconv_kernels_find(const char *name)
+{
+    /*the best first*/
+    static const picconv_kernels_t *all[] = {
+#if defined(__x86_64__) || defined(__i386__)
+        &picconv_kernels_avx2,
+        &picconv_kernels_sse4,
+#endif
+#if defined(__aarch64__)
+        &picconv_kernels_neon,
+#endif
+        &picconv_kernels_c,
+    };
+    int i;
+
+    for (i = 0; i < sizeof(all) / sizeof(all[0]); i++) {
+        if (name != NULL && strcmp(name, all[i]->name)) {
+            continue;
+        }
+        if (cpu_has(all[i])) {
+            return all[i];
+        }
+        if (name != NULL) {
+            break;
+        }
+    }
+
+    return NULL;
+}
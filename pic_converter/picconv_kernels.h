@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: picconv_kernels.h
+*
+* PURPOSE: the row kernels of the CPU picture converter, the scalar
+*          reference ones and the SIMD ones which give the same bytes
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+************************************************************************/
+
+#ifndef __PICCONV_KERNELS_H_
+#define __PICCONV_KERNELS_H_
+
+#include <stdint.h>
+
+/*the filter coefficients are fixed point, their sum is 1 << PICCONV_COEF_BITS*/
+#define PICCONV_COEF_BITS  14
+#define PICCONV_MAX_TAPS   16
+
+/*
+BT.601 limited range:
+    R = (298 * (Y - 16) + 409 * (V - 128) + 128) >> 8
+    G = (298 * (Y - 16) - 100 * (U - 128) - 208 * (V - 128) + 128) >> 8
+    B = (298 * (Y - 16) + 516 * (U - 128) + 128) >> 8
+    Y = ((  66 * R + 129 * G +  25 * B + 128) >> 8) + 16
+    U = (( -38 * R -  74 * G + 112 * B + 128) >> 8) + 128
+    V = (( 112 * R -  94 * G -  18 * B + 128) >> 8) + 128
+*/
+typedef struct picconv_kernels_t {
+    const char *name;
+
+    /*
+    * dst[i] = sum(src[pos[i] + t] * coef[i * taps + t]), t < taps,
+    * src[pos[i] + taps - 1] is in the row, taps is 1, 2, 4, 8 or 16 but
+    * for the pictures narrower than that
+    */
+    void (*hscale)(uint8_t *dst, int dst_w, const uint8_t *src,
+                   const int *pos, const int16_t *coef, int taps);
+
+    /*
+    * dst[x] = sum(rows[t][x] * coef[t]), t < taps
+    */
+    void (*vscale)(uint8_t *dst, int w, const uint8_t *const *rows,
+                   const int16_t *coef, int taps);
+
+    /*
+    * to RGBA, or BGRA if swap_rb, the alpha is 255
+    */
+    void (*yuv_to_rgb32)(uint8_t *dst, const uint8_t *y, const uint8_t *u,
+                         const uint8_t *v, int w, int swap_rb);
+
+    /*
+    * u and v are NULL for the luma only
+    */
+    void (*rgb_to_yuv)(uint8_t *y, uint8_t *u, uint8_t *v, const uint8_t *r,
+                       const uint8_t *g, const uint8_t *b, int w);
+
+    /*
+    * dst[x] = src[x * step], step is 2 or 4
+    */
+    void (*unpack)(uint8_t *dst, const uint8_t *src, int step, int w);
+} picconv_kernels_t;
+
+/*the scalar reference, also used by the SIMD kernels for the cases they don't do*/
+void picconv_hscale_c(uint8_t *dst, int dst_w, const uint8_t *src,
+                      const int *pos, const int16_t *coef, int taps);
+void picconv_vscale_c(uint8_t *dst, int w, const uint8_t *const *rows,
+                      const int16_t *coef, int taps);
+void picconv_yuv_to_rgb32_c(uint8_t *dst, const uint8_t *y, const uint8_t *u,
+                            const uint8_t *v, int w, int swap_rb);
+void picconv_rgb_to_yuv_c(uint8_t *y, uint8_t *u, uint8_t *v, const uint8_t *r,
+                          const uint8_t *g, const uint8_t *b, int w);
+void picconv_unpack_c(uint8_t *dst, const uint8_t *src, int step, int w);
+
+extern const picconv_kernels_t picconv_kernels_c;
+#if defined(__x86_64__) || defined(__i386__)
+extern const picconv_kernels_t picconv_kernels_sse4;
+extern const picconv_kernels_t picconv_kernels_avx2;
+#endif
+#if defined(__aarch64__)
+extern const picconv_kernels_t picconv_kernels_neon;
+#endif
+
+/*
+* The kernels of name, NULL: the best ones of the CPU
+*   return NULL if they are unknown or the CPU does not have them
+*/
+const picconv_kernels_t *picconv_kernels_find(const char *name);
+
+#endif /* __PICCONV_KERNELS_H_ */
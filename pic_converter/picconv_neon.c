@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: picconv_neon.c
+*
+* PURPOSE: NEON row kernels of the CPU picture converter on aarch64
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Bilinear horizontal filter
+* 2026-10-18  Apoidea   Unpack kernel
+************************************************************************/
+#if defined(__aarch64__)
+
+#include <stdio.h>
+#include <string.h>
+#include <arm_neon.h>
+
+#include "picconv_kernels.h"
+
+static inline uint8_t clip_u8(int v)
+{
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+/*the rounding and shift of 8 filter sums to 8 bytes*/
+static inline uint8x8_t round_sums(int32x4_t lo, int32x4_t hi)
+{
+    return vqmovun_s16(vcombine_s16(vqmovn_s32(vshrq_n_s32(lo, PICCONV_COEF_BITS)),
+                                    vqmovn_s32(vshrq_n_s32(hi, PICCONV_COEF_BITS))));
+}
+
+/*
+* bilinear: 8 outputs, the byte pairs of the inputs are in the order of
+* the coefficient pairs
+*/
+static void hscale2_neon(uint8_t *dst, int dst_w, const uint8_t *src,
+                         const int *pos, const int16_t *coef)
+{
+    int i, j;
+    uint16_t pairs[8];
+    uint8x16_t s;
+    int16x8_t lo, hi, c0, c1;
+    int32x4_t sum0, sum1;
+    const int32x4_t round = vdupq_n_s32(1 << (PICCONV_COEF_BITS - 1));
+
+    for (i = 0; i + 8 <= dst_w; i += 8) {
+        for (j = 0; j < 8; j++) {
+            memcpy(&pairs[j], src + pos[i + j], sizeof(uint16_t));
+        }
+        s = vreinterpretq_u8_u16(vld1q_u16(pairs));
+        lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(s)));
+        hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(s)));
+        c0 = vld1q_s16(coef + i * 2);
+        c1 = vld1q_s16(coef + i * 2 + 8);
+        /*the products of a pair are next to each other*/
+        sum0 = vpaddq_s32(vmull_s16(vget_low_s16(lo), vget_low_s16(c0)),
+                          vmull_s16(vget_high_s16(lo), vget_high_s16(c0)));
+        sum1 = vpaddq_s32(vmull_s16(vget_low_s16(hi), vget_low_s16(c1)),
+                          vmull_s16(vget_high_s16(hi), vget_high_s16(c1)));
+        vst1_u8(dst + i, round_sums(vaddq_s32(sum0, round), vaddq_s32(sum1, round)));
+    }
+
+    if (i < dst_w) {
+        picconv_hscale_c(dst + i, dst_w - i, src, pos + i, coef + i * 2, 2);
+    }
+}
+
+/*
+* one output at a time, the filters are padded to 4, 8 or 16 taps which
+* are all in the row
+*/
+static void hscale_neon(uint8_t *dst, int dst_w, const uint8_t *src,
+                        const int *pos, const int16_t *coef, int taps)
+{
+    int i;
+    uint32_t v;
+    int16x8_t s;
+    int32x4_t acc;
+    const uint8_t *p;
+
+    if (taps == 2) {
+        hscale2_neon(dst, dst_w, src, pos, coef);
+        return;
+    }
+    if (taps != 4 && taps != 8 && taps != 16) {
+        picconv_hscale_c(dst, dst_w, src, pos, coef, taps);
+        return;
+    }
+
+    for (i = 0; i < dst_w; i++) {
+        p = src + pos[i];
+        if (taps == 4) {
+            memcpy(&v, p, sizeof(v));
+            s = vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(v))));
+            acc = vmull_s16(vget_low_s16(s), vld1_s16(coef));
+        } else {
+            s = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)));
+            acc = vmull_s16(vget_low_s16(s), vld1_s16(coef));
+            acc = vmlal_s16(acc, vget_high_s16(s), vld1_s16(coef + 4));
+            if (taps == 16) {
+                s = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p + 8)));
+                acc = vmlal_s16(acc, vget_low_s16(s), vld1_s16(coef + 8));
+                acc = vmlal_s16(acc, vget_high_s16(s), vld1_s16(coef + 12));
+            }
+        }
+        dst[i] = clip_u8((vaddvq_s32(acc) + (1 << (PICCONV_COEF_BITS - 1))) >> PICCONV_COEF_BITS);
+        coef += taps;
+    }
+}
+
+static void vscale_neon(uint8_t *dst, int w, const uint8_t *const *rows,
+                        const int16_t *coef, int taps)
+{
+    int x, t;
+    uint8x16_t a;
+    int16x8_t lo, hi;
+    int32x4_t acc0, acc1, acc2, acc3;
+    const uint8_t *tail[PICCONV_MAX_TAPS];
+
+    for (x = 0; x + 16 <= w; x += 16) {
+        acc0 = acc1 = acc2 = acc3 = vdupq_n_s32(1 << (PICCONV_COEF_BITS - 1));
+        for (t = 0; t < taps; t++) {
+            a = vld1q_u8(rows[t] + x);
+            lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(a)));
+            hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(a)));
+            acc0 = vmlal_n_s16(acc0, vget_low_s16(lo), coef[t]);
+            acc1 = vmlal_n_s16(acc1, vget_high_s16(lo), coef[t]);
+            acc2 = vmlal_n_s16(acc2, vget_low_s16(hi), coef[t]);
+            acc3 = vmlal_n_s16(acc3, vget_high_s16(hi), coef[t]);
+        }
+        vst1q_u8(dst + x, vcombine_u8(round_sums(acc0, acc1), round_sums(acc2, acc3)));
+    }
+
+    if (x < w) {
+        for (t = 0; t < taps; t++) {
+            tail[t] = rows[t] + x;
+        }
+        picconv_vscale_c(dst + x, w - x, tail, coef, taps);
+    }
+}
+
+/*8 pixels: (a * ca + b * cb + c * cc + 128) >> 8 in int32 as the scalar kernels do it*/
+static inline int16x8_t dot3(int16x8_t a, int16x8_t b, int16x8_t c, int ca, int cb, int cc)
+{
+    int32x4_t lo = vdupq_n_s32(128);
+    int32x4_t hi = vdupq_n_s32(128);
+
+    lo = vmlal_n_s16(lo, vget_low_s16(a), ca);
+    hi = vmlal_n_s16(hi, vget_high_s16(a), ca);
+    lo = vmlal_n_s16(lo, vget_low_s16(b), cb);
+    hi = vmlal_n_s16(hi, vget_high_s16(b), cb);
+    lo = vmlal_n_s16(lo, vget_low_s16(c), cc);
+    hi = vmlal_n_s16(hi, vget_high_s16(c), cc);
+
+    return vcombine_s16(vqmovn_s32(vshrq_n_s32(lo, 8)), vqmovn_s32(vshrq_n_s32(hi, 8)));
+}
+
+static inline int16x8_t load8(const uint8_t *p, int bias)
+{
+    return vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p))), vdupq_n_s16(bias));
+}
+
+static void yuv_to_rgb32_neon(uint8_t *dst, const uint8_t *y, const uint8_t *u,
+                              const uint8_t *v, int w, int swap_rb)
+{
+    int x;
+    int16x8_t c, d, e;
+    const int16x8_t zero = vdupq_n_s16(0);
+    uint8x8_t r, b;
+    uint8x8x4_t px;
+
+    for (x = 0; x + 8 <= w; x += 8) {
+        c = load8(y + x, 16);
+        d = load8(u + x, 128);
+        e = load8(v + x, 128);
+
+        r = vqmovun_s16(dot3(c, e, zero, 298, 409, 0));
+        b = vqmovun_s16(dot3(c, d, zero, 298, 516, 0));
+        px.val[0] = swap_rb ? b : r;
+        px.val[1] = vqmovun_s16(dot3(c, d, e, 298, -100, -208));
+        px.val[2] = swap_rb ? r : b;
+        px.val[3] = vdup_n_u8(255);
+        vst4_u8(dst + x * 4, px);
+    }
+
+    if (x < w) {
+        picconv_yuv_to_rgb32_c(dst + x * 4, y + x, u + x, v + x, w - x, swap_rb);
+    }
+}
+
+static void rgb_to_yuv_neon(uint8_t *y, uint8_t *u, uint8_t *v, const uint8_t *r,
+                            const uint8_t *g, const uint8_t *b, int w)
+{
+    int x;
+    int16x8_t r16, g16, b16;
+
+    for (x = 0; x + 8 <= w; x += 8) {
+        r16 = load8(r + x, 0);
+        g16 = load8(g + x, 0);
+        b16 = load8(b + x, 0);
+
+        vst1_u8(y + x, vqmovun_s16(vaddq_s16(dot3(r16, g16, b16, 66, 129, 25),
+                                             vdupq_n_s16(16))));
+        if (u == NULL) {
+            continue;
+        }
+        vst1_u8(u + x, vqmovun_s16(vaddq_s16(dot3(r16, g16, b16, -38, -74, 112),
+                                             vdupq_n_s16(128))));
+        vst1_u8(v + x, vqmovun_s16(vaddq_s16(dot3(r16, g16, b16, 112, -94, -18),
+                                             vdupq_n_s16(128))));
+    }
+
+    if (x < w) {
+        picconv_rgb_to_yuv_c(y + x, u ? u + x : NULL, v ? v + x : NULL,
+                             r + x, g + x, b + x, w - x);
+    }
+}
+
+/*the loads stay in the samples of the row: the last one is left to the scalar loop*/
+static void unpack_neon(uint8_t *dst, const uint8_t *src, int step, int w)
+{
+    int x = 0;
+
+    if (step == 2) {
+        for (; x + 16 < w; x += 16) {
+            vst1q_u8(dst + x, vld2q_u8(src + x * 2).val[0]);
+        }
+    } else if (step == 4) {
+        for (; x + 16 < w; x += 16) {
+            vst1q_u8(dst + x, vld4q_u8(src + x * 4).val[0]);
+        }
+    }
+
+    if (x < w) {
+        picconv_unpack_c(dst + x, src + x * step, step, w - x);
+    }
+}
+
+const picconv_kernels_t picconv_kernels_neon = {
+    .name         = "neon",
+    .hscale       = hscale_neon,
+    .vscale       = vscale_neon,
+    .yuv_to_rgb32 = yuv_to_rgb32_neon,
+    .rgb_to_yuv   = rgb_to_yuv_neon,
+    .unpack       = unpack_neon,
+};
+
+#endif
@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: picconv_pool.c
+*
+* PURPOSE: persistent threads of a CPU picture converter handle, which
+*          share the tasks of a run by work stealing
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Work stealing
+************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "picconv_pool.h"
+
+/*the tasks of a worker, on a cache line of its own*/
+typedef struct worker_t {
+    uint64_t range;                 /*the next task in the low 32 bits, the end in the high ones*/
+    char     pad[56];
+} worker_t;
+
+struct picconv_pool_t {
+    pthread_t       *threads;
+    int             nb_threads;     /*with the caller*/
+
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;           /*a run starts or the pool quits*/
+    pthread_cond_t  done_cond;      /*a thread finished the run*/
+    int             quit;
+    unsigned int    generation;     /*of the run*/
+    int             nb_busy;        /*threads in the run*/
+
+    /*of the run*/
+    picconv_task_fn fn;
+    void            *opaque;
+    worker_t        *workers;       /*taken and stolen atomically*/
+};
+
+typedef struct thread_arg_t {
+    picconv_pool_t *pool;
+    int            index;
+} thread_arg_t;
+
+/*
+* steal the back half of the tasks of another worker
+*   return the stolen range, 0 if all of them are taken
+*/
+static uint64_t steal_tasks(picconv_pool_t *pool, int worker)
+{
+    uint64_t old;
+    uint32_t next, end, n;
+    int i, victim;
+
+    for (i = 1; i < pool->nb_threads; i++) {
+        victim = (worker + i) % pool->nb_threads;
+        old = __atomic_load_n(&pool->workers[victim].range, __ATOMIC_ACQUIRE);
+        while ((next = (uint32_t)old) < (end = (uint32_t)(old >> 32))) {
+            n = (end - next + 1) / 2;
+            if (__atomic_compare_exchange_n(&pool->workers[victim].range, &old,
+                                            ((uint64_t)(end - n) << 32) | next, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return ((uint64_t)end << 32) | (end - n);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*
+* A worker takes its tasks from the front of its range, the neighbouring
+* bands of a picture stay on one worker. The one which runs out steals
+* from the others, the slow tasks don't hold back the run.
+*/
+static void run_tasks(picconv_pool_t *pool, int worker)
+{
+    worker_t *own = &pool->workers[worker];
+    uint64_t old;
+    uint32_t next;
+
+    while (1) {
+        old = __atomic_load_n(&own->range, __ATOMIC_ACQUIRE);
+        next = (uint32_t)old;
+        if (next < (uint32_t)(old >> 32)) {
+            if (__atomic_compare_exchange_n(&own->range, &old, old + 1, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                pool->fn(pool->opaque, next, worker);
+            }
+            continue;
+        }
+
+        old = steal_tasks(pool, worker);
+        if (old == 0) {
+            return;
+        }
+        __atomic_store_n(&own->range, old, __ATOMIC_RELEASE);
+    }
+}
+
+static void *poolThreadEntry(void *priv)
+{
+    thread_arg_t *arg = (thread_arg_t *)priv;
+    picconv_pool_t *pool = arg->pool;
+    int index = arg->index;
+    unsigned int generation = 0;
+
+    free(arg);
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->quit && pool->generation == generation) {
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        }
+        if (pool->quit) {
+            break;
+        }
+        generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_tasks(pool, index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->nb_busy == 0) {
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+picconv_pool_t *picconv_pool_create(int nb_threads)
+{
+    picconv_pool_t *pool;
+    thread_arg_t *arg;
+    char thread_name[16];
+    int ret;
+    int i;
+
+    if (nb_threads <= 0) {
+        printf("invalid number of converter threads: %d\n", nb_threads);
+        return NULL;
+    }
+
+    pool = (picconv_pool_t *)calloc(1, sizeof(picconv_pool_t));
+    if (pool == NULL) {
+        printf("failed to malloc picconv_pool_t\n");
+        return NULL;
+    }
+    pool->threads = (pthread_t *)calloc(nb_threads, sizeof(pthread_t));
+    pool->workers = (worker_t *)aligned_alloc(sizeof(worker_t), sizeof(worker_t) * nb_threads);
+    if (pool->threads == NULL || pool->workers == NULL) {
+        printf("failed to malloc %d converter threads\n", nb_threads);
+        free(pool->threads);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+    memset(pool->workers, 0, sizeof(worker_t) * nb_threads);
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    /*the caller is the last one*/
+    pool->nb_threads = 1;
+    for (i = 0; i < nb_threads - 1; i++) {
+        arg = (thread_arg_t *)malloc(sizeof(thread_arg_t));
+        if (arg == NULL) {
+            break;
+        }
+        arg->pool = pool;
+        arg->index = i;
+
+        ret = pthread_create(&pool->threads[i], NULL, poolThreadEntry, (void *)arg);
+        if (ret != 0) {
+            printf("Failed to create converter thread(res=%d, error=%s)\n", ret, strerror(ret));
+            free(arg);
+            break;
+        }
+
+        snprintf(thread_name, sizeof(thread_name), "picconv/%d", i % 10000);
+        pthread_setname_np(pool->threads[i], thread_name);
+
+        pool->nb_threads++;
+    }
+
+    return pool;
+}
+
+int picconv_pool_threads(picconv_pool_t *pool)
+{
+    return pool->nb_threads;
+}
+
+void picconv_pool_run(picconv_pool_t *pool, int nb_tasks, picconv_task_fn fn, void *opaque)
+{
+    int i;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->opaque = opaque;
+    /*a range of neighbouring tasks for each worker*/
+    for (i = 0; i < pool->nb_threads; i++) {
+        pool->workers[i].range = ((uint64_t)((int64_t)nb_tasks * (i + 1) / pool->nb_threads) << 32) |
+                                 (uint32_t)((int64_t)nb_tasks * i / pool->nb_threads);
+    }
+    pool->nb_busy = pool->nb_threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_tasks(pool, pool->nb_threads - 1);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->nb_busy > 0) {
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void picconv_pool_destroy(picconv_pool_t *pool)
+{
+    int i;
+
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->nb_threads - 1; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->cond);
+    pthread_cond_destroy(&pool->done_cond);
+    free(pool->threads);
+    free(pool->workers);
+    free(pool);
+}
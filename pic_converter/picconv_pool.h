@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: picconv_pool.h
+*
+* PURPOSE: persistent threads of a CPU picture converter handle, which
+*          run the tasks of a conversion together with the caller,
+*          each worker starts on a range of neighbouring tasks and steals
+*          from the others when it runs out
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Work stealing
+************************************************************************/
+
+#ifndef __PICCONV_POOL_H_
+#define __PICCONV_POOL_H_
+
+/*
+* Run task number task on the worker number worker, which is below
+* picconv_pool_threads(): the tasks of a worker run one after another
+*/
+typedef void (*picconv_task_fn)(void *opaque, int task, int worker);
+
+typedef struct picconv_pool_t picconv_pool_t;
+
+/*
+* Start nb_threads - 1 threads, the caller of picconv_pool_run() is the
+* last worker
+*/
+picconv_pool_t *picconv_pool_create(int nb_threads);
+
+int picconv_pool_threads(picconv_pool_t *pool);
+
+/*
+* Run the tasks 0..nb_tasks - 1 on the workers and the caller, return
+* when all of them are done. One run at a time, the tasks are in
+* ranges: neighbouring ones mostly run on one worker.
+*/
+void picconv_pool_run(picconv_pool_t *pool, int nb_tasks, picconv_task_fn fn, void *opaque);
+
+void picconv_pool_destroy(picconv_pool_t *pool);
+
+#endif /* __PICCONV_POOL_H_ */
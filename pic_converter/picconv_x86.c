@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: picconv_x86.c
+*
+* PURPOSE: SSE4.1 and AVX2 row kernels of the CPU picture converter,
+*          built with the target attributes so the file needs no -m
+*          flags, and used only if the CPU has them
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Bilinear horizontal filter
+* 2026-10-18  Apoidea   Unpack kernel
+************************************************************************/
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <stdio.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "picconv_kernels.h"
+
+#define SSE4 __attribute__((target("sse4.1")))
+#define AVX2 __attribute__((target("avx2")))
+
+/*the rounding and shift of the filter sums, 4 int32 to 4 bytes in the low 32 bits*/
+SSE4 static inline __m128i sse4_round_sums(__m128i sum)
+{
+    sum = _mm_add_epi32(sum, _mm_set1_epi32(1 << (PICCONV_COEF_BITS - 1)));
+    sum = _mm_srai_epi32(sum, PICCONV_COEF_BITS);
+    sum = _mm_packs_epi32(sum, sum);
+    return _mm_packus_epi16(sum, sum);
+}
+
+SSE4 static inline __m128i sse4_load4(const uint8_t *p)
+{
+    int32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return _mm_cvtsi32_si128(v);
+}
+
+SSE4 static inline void sse4_store4(uint8_t *p, __m128i v)
+{
+    int32_t r = _mm_cvtsi128_si32(v);
+
+    memcpy(p, &r, sizeof(r));
+}
+
+SSE4 static inline int sse4_load2(const uint8_t *p)
+{
+    uint16_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*
+* bilinear: 8 outputs, the byte pairs of the inputs are in the order of
+* the coefficient pairs
+*/
+SSE4 static void hscale2_sse4(uint8_t *dst, int dst_w, const uint8_t *src,
+                              const int *pos, const int16_t *coef)
+{
+    int i;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(1 << (PICCONV_COEF_BITS - 1));
+    __m128i s, lo, hi;
+
+    for (i = 0; i + 8 <= dst_w; i += 8) {
+        s = _mm_setr_epi16(sse4_load2(src + pos[i]),     sse4_load2(src + pos[i + 1]),
+                           sse4_load2(src + pos[i + 2]), sse4_load2(src + pos[i + 3]),
+                           sse4_load2(src + pos[i + 4]), sse4_load2(src + pos[i + 5]),
+                           sse4_load2(src + pos[i + 6]), sse4_load2(src + pos[i + 7]));
+        lo = _mm_madd_epi16(_mm_unpacklo_epi8(s, zero),
+                            _mm_loadu_si128((const __m128i *)(coef + i * 2)));
+        hi = _mm_madd_epi16(_mm_unpackhi_epi8(s, zero),
+                            _mm_loadu_si128((const __m128i *)(coef + i * 2 + 8)));
+        lo = _mm_srai_epi32(_mm_add_epi32(lo, round), PICCONV_COEF_BITS);
+        hi = _mm_srai_epi32(_mm_add_epi32(hi, round), PICCONV_COEF_BITS);
+        s = _mm_packs_epi32(lo, hi);
+        _mm_storel_epi64((__m128i *)(dst + i), _mm_packus_epi16(s, s));
+    }
+
+    if (i < dst_w) {
+        picconv_hscale_c(dst + i, dst_w - i, src, pos + i, coef + i * 2, 2);
+    }
+}
+
+/*
+* 4 outputs at a time, the filters are padded to 4, 8 or 16 taps which
+* are all in the row
+*/
+SSE4 static void hscale_sse4(uint8_t *dst, int dst_w, const uint8_t *src,
+                             const int *pos, const int16_t *coef, int taps)
+{
+    int i, j;
+    __m128i p[4];
+    __m128i s, c;
+
+    if (taps == 2) {
+        hscale2_sse4(dst, dst_w, src, pos, coef);
+        return;
+    }
+    if (taps != 4 && taps != 8 && taps != 16) {
+        picconv_hscale_c(dst, dst_w, src, pos, coef, taps);
+        return;
+    }
+
+    for (i = 0; i + 4 <= dst_w; i += 4) {
+        if (taps == 4) {
+            /*2 outputs in a register*/
+            for (j = 0; j < 4; j += 2) {
+                s = _mm_unpacklo_epi32(sse4_load4(src + pos[i + j]),
+                                       sse4_load4(src + pos[i + j + 1]));
+                c = _mm_loadu_si128((const __m128i *)(coef + (i + j) * 4));
+                p[j] = _mm_madd_epi16(_mm_cvtepu8_epi16(s), c);
+            }
+            /*[o0a o0b o1a o1b] [o2a o2b o3a o3b]*/
+            s = _mm_hadd_epi32(p[0], p[2]);
+        } else {
+            for (j = 0; j < 4; j++) {
+                s = _mm_loadl_epi64((const __m128i *)(src + pos[i + j]));
+                c = _mm_loadu_si128((const __m128i *)(coef + (i + j) * taps));
+                p[j] = _mm_madd_epi16(_mm_cvtepu8_epi16(s), c);
+                if (taps == 16) {
+                    s = _mm_loadl_epi64((const __m128i *)(src + pos[i + j] + 8));
+                    c = _mm_loadu_si128((const __m128i *)(coef + (i + j) * taps + 8));
+                    p[j] = _mm_add_epi32(p[j], _mm_madd_epi16(_mm_cvtepu8_epi16(s), c));
+                }
+            }
+            s = _mm_hadd_epi32(_mm_hadd_epi32(p[0], p[1]), _mm_hadd_epi32(p[2], p[3]));
+        }
+        sse4_store4(dst + i, sse4_round_sums(s));
+    }
+
+    if (i < dst_w) {
+        picconv_hscale_c(dst + i, dst_w - i, src, pos + i, coef + i * taps, taps);
+    }
+}
+
+/*
+* the rows in pairs, the bytes of both interleaved are multiplied and
+* added with the coefficient pair by pmaddwd
+*/
+SSE4 static void vscale_sse4(uint8_t *dst, int w, const uint8_t *const *rows,
+                             const int16_t *coef, int taps)
+{
+    int x, t;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(1 << (PICCONV_COEF_BITS - 1));
+    __m128i a, b, c, lo, hi;
+    __m128i acc0, acc1, acc2, acc3;
+    const uint8_t *tail[PICCONV_MAX_TAPS];
+
+    for (x = 0; x + 16 <= w; x += 16) {
+        acc0 = acc1 = acc2 = acc3 = round;
+        for (t = 0; t < taps; t += 2) {
+            a = _mm_loadu_si128((const __m128i *)(rows[t] + x));
+            if (t + 1 < taps) {
+                b = _mm_loadu_si128((const __m128i *)(rows[t + 1] + x));
+                c = _mm_set1_epi32((uint16_t)coef[t] | ((uint32_t)(uint16_t)coef[t + 1] << 16));
+            } else {
+                b = zero;
+                c = _mm_set1_epi32((uint16_t)coef[t]);
+            }
+            lo = _mm_unpacklo_epi8(a, b);
+            hi = _mm_unpackhi_epi8(a, b);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), c));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), c));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), c));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), c));
+        }
+        acc0 = _mm_srai_epi32(acc0, PICCONV_COEF_BITS);
+        acc1 = _mm_srai_epi32(acc1, PICCONV_COEF_BITS);
+        acc2 = _mm_srai_epi32(acc2, PICCONV_COEF_BITS);
+        acc3 = _mm_srai_epi32(acc3, PICCONV_COEF_BITS);
+        _mm_storeu_si128((__m128i *)(dst + x),
+                         _mm_packus_epi16(_mm_packs_epi32(acc0, acc1),
+                                          _mm_packs_epi32(acc2, acc3)));
+    }
+
+    if (x < w) {
+        for (t = 0; t < taps; t++) {
+            tail[t] = rows[t] + x;
+        }
+        picconv_vscale_c(dst + x, w - x, tail, coef, taps);
+    }
+}
+
+/*
+* 8 pixels: (a * ca + b * cb + c * cc + 128) >> 8 in int32 as the scalar
+* kernels do it, the rounding 128 is multiplied by the 1 next to c
+*/
+SSE4 static inline __m128i sse4_dot3(__m128i a, __m128i b, __m128i c, int ca, int cb, int cc)
+{
+    __m128i one = _mm_set1_epi16(1);
+    __m128i k0 = _mm_set1_epi32((uint16_t)ca | ((uint32_t)(uint16_t)cb << 16));
+    __m128i k1 = _mm_set1_epi32((uint16_t)cc | ((uint32_t)128 << 16));
+    __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a, b), k0),
+                               _mm_madd_epi16(_mm_unpacklo_epi16(c, one), k1));
+    __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a, b), k0),
+                               _mm_madd_epi16(_mm_unpackhi_epi16(c, one), k1));
+
+    return _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+}
+
+SSE4 static void yuv_to_rgb32_sse4(uint8_t *dst, const uint8_t *y, const uint8_t *u,
+                                   const uint8_t *v, int w, int swap_rb)
+{
+    int x;
+    const __m128i zero = _mm_setzero_si128();
+    __m128i c, d, e, r, g, b, t, rg, ba;
+
+    for (x = 0; x + 8 <= w; x += 8) {
+        c = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(y + x))),
+                          _mm_set1_epi16(16));
+        d = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(u + x))),
+                          _mm_set1_epi16(128));
+        e = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(v + x))),
+                          _mm_set1_epi16(128));
+
+        r = sse4_dot3(c, e, zero, 298, 409, 0);
+        g = sse4_dot3(c, d, e, 298, -100, -208);
+        b = sse4_dot3(c, d, zero, 298, 516, 0);
+        r = _mm_packus_epi16(r, r);
+        g = _mm_packus_epi16(g, g);
+        b = _mm_packus_epi16(b, b);
+        if (swap_rb) {
+            t = r;
+            r = b;
+            b = t;
+        }
+
+        rg = _mm_unpacklo_epi8(r, g);
+        ba = _mm_unpacklo_epi8(b, _mm_set1_epi8((char)0xff));
+        _mm_storeu_si128((__m128i *)(dst + x * 4), _mm_unpacklo_epi16(rg, ba));
+        _mm_storeu_si128((__m128i *)(dst + x * 4 + 16), _mm_unpackhi_epi16(rg, ba));
+    }
+
+    if (x < w) {
+        picconv_yuv_to_rgb32_c(dst + x * 4, y + x, u + x, v + x, w - x, swap_rb);
+    }
+}
+
+SSE4 static void rgb_to_yuv_sse4(uint8_t *y, uint8_t *u, uint8_t *v, const uint8_t *r,
+                                 const uint8_t *g, const uint8_t *b, int w)
+{
+    int x;
+    __m128i r16, g16, b16, o;
+
+    for (x = 0; x + 8 <= w; x += 8) {
+        r16 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(r + x)));
+        g16 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(g + x)));
+        b16 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(b + x)));
+
+        o = _mm_add_epi16(sse4_dot3(r16, g16, b16, 66, 129, 25), _mm_set1_epi16(16));
+        _mm_storel_epi64((__m128i *)(y + x), _mm_packus_epi16(o, o));
+        if (u == NULL) {
+            continue;
+        }
+        o = _mm_add_epi16(sse4_dot3(r16, g16, b16, -38, -74, 112), _mm_set1_epi16(128));
+        _mm_storel_epi64((__m128i *)(u + x), _mm_packus_epi16(o, o));
+        o = _mm_add_epi16(sse4_dot3(r16, g16, b16, 112, -94, -18), _mm_set1_epi16(128));
+        _mm_storel_epi64((__m128i *)(v + x), _mm_packus_epi16(o, o));
+    }
+
+    if (x < w) {
+        picconv_rgb_to_yuv_c(y + x, u ? u + x : NULL, v ? v + x : NULL,
+                             r + x, g + x, b + x, w - x);
+    }
+}
+
+/*
+* 16 samples at a time, the loads stay in the samples of the row: the
+* last one is left to the scalar loop
+*/
+SSE4 static void unpack_sse4(uint8_t *dst, const uint8_t *src, int step, int w)
+{
+    int x = 0;
+    const __m128i even = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+                                       -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i quad = _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1,
+                                       -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i a, b, c, d;
+
+    if (step == 2) {
+        for (; x + 16 < w; x += 16) {
+            a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x * 2)), even);
+            b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x * 2 + 16)), even);
+            _mm_storeu_si128((__m128i *)(dst + x), _mm_unpacklo_epi64(a, b));
+        }
+    } else if (step == 4) {
+        for (; x + 16 < w; x += 16) {
+            a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x * 4)), quad);
+            b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x * 4 + 16)), quad);
+            c = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x * 4 + 32)), quad);
+            d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x * 4 + 48)), quad);
+            _mm_storeu_si128((__m128i *)(dst + x),
+                             _mm_unpacklo_epi64(_mm_unpacklo_epi32(a, b),
+                                                _mm_unpacklo_epi32(c, d)));
+        }
+    }
+
+    if (x < w) {
+        picconv_unpack_c(dst + x, src + x * step, step, w - x);
+    }
+}
+
+const picconv_kernels_t picconv_kernels_sse4 = {
+    .name         = "sse4",
+    .hscale       = hscale_sse4,
+    .vscale       = vscale_sse4,
+    .yuv_to_rgb32 = yuv_to_rgb32_sse4,
+    .rgb_to_yuv   = rgb_to_yuv_sse4,
+    .unpack       = unpack_sse4,
+};
+
+/*
+* AVX2: twice the pixels of the SSE4.1 kernels, the 128-bit lanes are
+* packed back into the pixel order. The gathers of the horizontal
+* filter don't get faster with 256 bits, it is the SSE4.1 one.
+*/
+AVX2 static void vscale_avx2(uint8_t *dst, int w, const uint8_t *const *rows,
+                             const int16_t *coef, int taps)
+{
+    int x, t;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi32(1 << (PICCONV_COEF_BITS - 1));
+    __m256i a, b, c, lo, hi;
+    __m256i acc0, acc1, acc2, acc3;
+    const uint8_t *tail[PICCONV_MAX_TAPS];
+
+    for (x = 0; x + 32 <= w; x += 32) {
+        acc0 = acc1 = acc2 = acc3 = round;
+        for (t = 0; t < taps; t += 2) {
+            a = _mm256_loadu_si256((const __m256i *)(rows[t] + x));
+            if (t + 1 < taps) {
+                b = _mm256_loadu_si256((const __m256i *)(rows[t + 1] + x));
+                c = _mm256_set1_epi32((uint16_t)coef[t] | ((uint32_t)(uint16_t)coef[t + 1] << 16));
+            } else {
+                b = zero;
+                c = _mm256_set1_epi32((uint16_t)coef[t]);
+            }
+            /*per lane: lo has the pixels 0..7 of it, hi 8..15*/
+            lo = _mm256_unpacklo_epi8(a, b);
+            hi = _mm256_unpackhi_epi8(a, b);
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi8(lo, zero), c));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, zero), c));
+            acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, zero), c));
+            acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, zero), c));
+        }
+        acc0 = _mm256_srai_epi32(acc0, PICCONV_COEF_BITS);
+        acc1 = _mm256_srai_epi32(acc1, PICCONV_COEF_BITS);
+        acc2 = _mm256_srai_epi32(acc2, PICCONV_COEF_BITS);
+        acc3 = _mm256_srai_epi32(acc3, PICCONV_COEF_BITS);
+        /*the packs work in the lanes, which keeps the pixel order*/
+        _mm256_storeu_si256((__m256i *)(dst + x),
+                            _mm256_packus_epi16(_mm256_packs_epi32(acc0, acc1),
+                                                _mm256_packs_epi32(acc2, acc3)));
+    }
+
+    if (x < w) {
+        for (t = 0; t < taps; t++) {
+            tail[t] = rows[t] + x;
+        }
+        vscale_sse4(dst + x, w - x, tail, coef, taps);
+    }
+}
+
+/*16 int16 in the pixel order from 16 bytes*/
+AVX2 static inline __m256i avx2_load16(const uint8_t *p, int bias)
+{
+    return _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p)),
+                            _mm256_set1_epi16(bias));
+}
+
+AVX2 static inline __m256i avx2_dot3(__m256i a, __m256i b, __m256i c, int ca, int cb, int cc)
+{
+    __m256i one = _mm256_set1_epi16(1);
+    __m256i k0 = _mm256_set1_epi32((uint16_t)ca | ((uint32_t)(uint16_t)cb << 16));
+    __m256i k1 = _mm256_set1_epi32((uint16_t)cc | ((uint32_t)128 << 16));
+    __m256i lo = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), k0),
+                                  _mm256_madd_epi16(_mm256_unpacklo_epi16(c, one), k1));
+    __m256i hi = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), k0),
+                                  _mm256_madd_epi16(_mm256_unpackhi_epi16(c, one), k1));
+
+    /*unpack and pack in the same lanes: back in the pixel order*/
+    return _mm256_packs_epi32(_mm256_srai_epi32(lo, 8), _mm256_srai_epi32(hi, 8));
+}
+
+AVX2 static void yuv_to_rgb32_avx2(uint8_t *dst, const uint8_t *y, const uint8_t *u,
+                                   const uint8_t *v, int w, int swap_rb)
+{
+    int x;
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i c, d, e, r, g, b, t, rg, ba, lo, hi;
+
+    for (x = 0; x + 16 <= w; x += 16) {
+        c = avx2_load16(y + x, 16);
+        d = avx2_load16(u + x, 128);
+        e = avx2_load16(v + x, 128);
+
+        r = avx2_dot3(c, e, zero, 298, 409, 0);
+        g = avx2_dot3(c, d, e, 298, -100, -208);
+        b = avx2_dot3(c, d, zero, 298, 516, 0);
+        if (swap_rb) {
+            t = r;
+            r = b;
+            b = t;
+        }
+
+        /*per lane: the 8 bytes of r then the 8 of g, of b then the alpha*/
+        rg = _mm256_packus_epi16(r, g);
+        ba = _mm256_packus_epi16(b, _mm256_set1_epi16(255));
+        rg = _mm256_unpacklo_epi8(rg, _mm256_srli_si256(rg, 8));
+        ba = _mm256_unpacklo_epi8(ba, _mm256_srli_si256(ba, 8));
+        /*lo: pixels 0..3 and 8..11, hi: 4..7 and 12..15*/
+        lo = _mm256_unpacklo_epi16(rg, ba);
+        hi = _mm256_unpackhi_epi16(rg, ba);
+        _mm256_storeu_si256((__m256i *)(dst + x * 4), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + x * 4 + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    if (x < w) {
+        yuv_to_rgb32_sse4(dst + x * 4, y + x, u + x, v + x, w - x, swap_rb);
+    }
+}
+
+/*the 16 bytes of 16 int16 in the pixel order*/
+AVX2 static inline void avx2_store16(uint8_t *p, __m256i v)
+{
+    v = _mm256_packus_epi16(v, v);
+    v = _mm256_permute4x64_epi64(v, 0x08);
+    _mm_storeu_si128((__m128i *)p, _mm256_castsi256_si128(v));
+}
+
+AVX2 static void rgb_to_yuv_avx2(uint8_t *y, uint8_t *u, uint8_t *v, const uint8_t *r,
+                                 const uint8_t *g, const uint8_t *b, int w)
+{
+    int x;
+    __m256i r16, g16, b16;
+
+    for (x = 0; x + 16 <= w; x += 16) {
+        r16 = avx2_load16(r + x, 0);
+        g16 = avx2_load16(g + x, 0);
+        b16 = avx2_load16(b + x, 0);
+
+        avx2_store16(y + x, _mm256_add_epi16(avx2_dot3(r16, g16, b16, 66, 129, 25),
+                                             _mm256_set1_epi16(16)));
+        if (u == NULL) {
+            continue;
+        }
+        avx2_store16(u + x, _mm256_add_epi16(avx2_dot3(r16, g16, b16, -38, -74, 112),
+                                             _mm256_set1_epi16(128)));
+        avx2_store16(v + x, _mm256_add_epi16(avx2_dot3(r16, g16, b16, 112, -94, -18),
+                                             _mm256_set1_epi16(128)));
+    }
+
+    if (x < w) {
+        rgb_to_yuv_sse4(y + x, u ? u + x : NULL, v ? v + x : NULL,
+                        r + x, g + x, b + x, w - x);
+    }
+}
+
+const picconv_kernels_t picconv_kernels_avx2 = {
+    .name         = "avx2",
+    .hscale       = hscale_sse4,
+    .vscale       = vscale_avx2,
+    .yuv_to_rgb32 = yuv_to_rgb32_avx2,
+    .rgb_to_yuv   = rgb_to_yuv_avx2,
+    .unpack       = unpack_sse4,
+};
+
+#endif
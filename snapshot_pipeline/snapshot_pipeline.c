@@ -0,0 +1,1044 @@
+/*
+ * Copyright (c) 2022 Apoidea Technology
+ *
+ * This file is part of Jeson Example Codes.
+ *
+ * It is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+/***********************************************************************
+* FILE NAME: snapshot_pipeline.c
+*
+* PURPOSE: the example code of taking jpeg snapshots of a video stream:
+*          decode, convert and encode in one process, the AVFrames are
+*          passed between the stage threads by bounded queues
+*
+* DEVELOPMENT HISTORY:
+* Date        Name       Description
+* ---------   ---------- -----------------------------------------------
+* 2026-10-18  Apoidea   Initial creating
+* 2026-10-18  Apoidea   Output path patterns are not used as printf formats
+* 2026-10-18  Apoidea   Restart the sampling grid when the pts jumps back
+************************************************************************/
+
+/*
+example:
+one snapshot per second of the camera into the latest.jpg
+./snapshot_pipeline -i rtsp://10.0.1.188 -r 1 -o latest.jpg
+
+100 snapshots of 640x360, 1 every 5 seconds, into snap_0.jpg ... snap_99.jpg
+./snapshot_pipeline -i rtsp://10.0.1.188 -r 0.2 -c 100 -s 640,360 -o snap_%d.jpg
+
+keep the latest 3600 snapshots of the camera in the directory /data/cam0,
+the oldest one is deleted for every new one
+./snapshot_pipeline -i rtsp://10.0.1.188 -r 1 -o /data/cam0/ -m 3600
+*/
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+
+#include "dec_backend.h"
+#include "frame_pool.h"
+#include "hdr_hist.h"
+#include "path_pattern.h"
+#include "picconverter.h"
+#include "jpegenc.h"
+
+#define FRAME_QUEUE_DEPTH  4    /*frames waiting for the converter, and for the encoder*/
+#define FRAME_POOL_FRAMES  16
+#define FRAME_POOL_BUFFERS 16   /*pictures referenced by the decoder and the queues*/
+#define IO_TIMEOUT         10   /*seconds, deadline of one open or read*/
+#define LATENCY_MAX_US     (10LL * 1000000)
+#define SNAPSHOT_PATH_SIZE 1024
+
+typedef enum {
+    STAGE_CONVERT = 0,
+    STAGE_ENCODE,
+    STAGE_WRITE,
+
+    STAGE_MAX
+} stage_t;
+
+static const char *stage_names[STAGE_MAX] = {
+    "convert", "encode", "write"
+};
+
+/*
+Bounded queue of AVFrames between two stage threads. When it is full,
+the producer waits in the block mode, or the oldest frame is dropped
+so that a live stream is never held up by a slow consumer.
+*/
+typedef struct frame_queue_t {
+    AVFrame         *frames[FRAME_QUEUE_DEPTH];
+    int             head;
+    int             count;
+    int             closed;
+    uint64_t        nb_dropped;
+
+    frame_pool_t    *pool;  /*the dropped frames go back to it*/
+
+    pthread_mutex_t lock;
+    pthread_cond_t  not_empty;
+    pthread_cond_t  not_full;
+} frame_queue_t;
+
+typedef struct pipeline_t {
+    const char           *url;
+    int                  live;              /*network stream, drop rather than wait*/
+
+    /*decode stage*/
+    AVFormatContext      *ff_input_ctx;
+    AVCodecContext       *ff_video_ctx;
+    int                  video_stream_index;
+    dec_backend_config_t backend;
+    frame_pool_t         *pool;
+    int64_t              io_deadline_us;
+
+    double               sample_fps;        /*0: all the frames*/
+    int64_t              sample_interval;   /*in the stream time base*/
+    int64_t              sample_next_pts;
+    int                  count;             /*snapshots to take, 0: until the end*/
+
+    /*convert stage*/
+    int                  conv_w;            /*0: the size of the stream*/
+    int                  conv_h;
+    PicSetting_t         conv_setting;
+    PIC_CONV_HANDLE_t    conv;
+    AVBufferPool         *conv_bufs;        /*pictures of the converted frames*/
+
+    /*encode stage*/
+    int                  quality;
+    JpegEnSetting_t      jpeg_setting;
+    JPEGEN_HANDLE_t      jpeg;
+
+    const char           *output;
+    int                  output_is_dir;
+    int                  output_is_pattern; /*a file for each snapshot in place of the %d*/
+    int                  max_files;         /*rotation, 0: keep all the files*/
+
+    frame_queue_t        conv_queue;
+    frame_queue_t        jpeg_queue;
+
+    pthread_t            dec_thread;
+    pthread_t            conv_thread;
+    pthread_t            jpeg_thread;
+
+    /*each counter is written by one stage thread only*/
+    uint64_t             nb_decoded;
+    uint64_t             nb_sampled;
+    uint64_t             nb_converted;
+    uint64_t             nb_conv_errors;
+    uint64_t             nb_written;
+    uint64_t             nb_jpeg_errors;
+    uint64_t             nb_jpeg_bytes;
+
+    hdr_hist_t           *lat[STAGE_MAX];
+} pipeline_t;
+
+static volatile sig_atomic_t g_quit = 0;
+
+
+static void usage(char *programname)
+{
+    printf("%s (compiled %s)\n", programname, __DATE__);
+    printf(("Usage %s [OPTION]\n"
+        " -i <video streaem url>                 : video stream in rtsp/http/file ...\n"
+        " -o <jpeg file or directory>            : output jpeg file, '%%d' is replaced by the snapshot number,\n"
+        "                                          a directory (ending with '/') gets snap_<number>.jpg\n"
+        " -c <number of snapshots>(default: 0)   : stop after the snapshots, 0: until the end\n"
+        " -r <fps>(default: 1)                   : snapshots per second of the stream, 0: every frame\n"
+        " -s <(width),(height)>                  : scale the snapshots, default: the size of the stream\n"
+        " -q <quality>(default: 75)              : jpeg quality, 1 - 100\n"
+        " -m <number of files>(default: 0)       : keep the latest files only, the oldest one is\n"
+        "                                          deleted for every new one, 0: keep all\n"
+        " -b <auto/hw/sw>(default: auto)         : decoder backend, auto falls back to the software decoder\n"
+        " -n <number of threads>(default: 0)     : threads of a software decoder, 0: number of cpu cores\n"
+        " -h, --help                             : print this help and exit\n"),
+        programname);
+}
+
+static void ff_print_error(const char *filename, int err)
+{
+    char errbuf[128];
+    const char *errbuf_ptr = errbuf;
+
+    if (av_strerror(err, errbuf, sizeof(errbuf)) < 0) {
+        errbuf_ptr = strerror(AVUNERROR(err));
+    }
+
+    printf("%s: %s\n", filename, errbuf_ptr);
+}
+
+static int64_t get_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sigint_handler(int sig)
+{
+    g_quit = 1;
+}
+
+static int frame_queue_init(frame_queue_t *q, frame_pool_t *pool) {
+    memset(q, 0, sizeof(frame_queue_t));
+    q->pool = pool;
+
+    if (pthread_mutex_init(&q->lock, NULL) ||
+        pthread_cond_init(&q->not_empty, NULL) ||
+        pthread_cond_init(&q->not_full, NULL)) {
+        printf("failed to init the frame queue\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static void frame_queue_destroy(frame_queue_t *q) {
+    while (q->count) {
+        frame_pool_put(q->pool, &q->frames[q->head]);
+        q->head = (q->head + 1) % FRAME_QUEUE_DEPTH;
+        q->count--;
+    }
+
+    pthread_cond_destroy(&q->not_full);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_mutex_destroy(&q->lock);
+}
+
+/*
+* Hand the frame over to the queue, it is dropped if the queue is closed
+*   block: wait for a free slot, or drop the oldest frame
+*/
+static void frame_queue_push(frame_queue_t *q, AVFrame *frm, int block) {
+    AVFrame *old = NULL;
+
+    pthread_mutex_lock(&q->lock);
+
+    while (block && q->count == FRAME_QUEUE_DEPTH && !q->closed) {
+        pthread_cond_wait(&q->not_full, &q->lock);
+    }
+
+    if (q->closed) {
+        pthread_mutex_unlock(&q->lock);
+        frame_pool_put(q->pool, &frm);
+        return;
+    }
+
+    if (q->count == FRAME_QUEUE_DEPTH) {
+        old = q->frames[q->head];
+        q->head = (q->head + 1) % FRAME_QUEUE_DEPTH;
+        q->count--;
+        q->nb_dropped++;
+    }
+
+    q->frames[(q->head + q->count) % FRAME_QUEUE_DEPTH] = frm;
+    q->count++;
+
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+
+    if (old) {
+        frame_pool_put(q->pool, &old);
+    }
+}
+
+/*
+* Wait for the next frame
+*   return NULL when the queue is closed and empty
+*/
+static AVFrame *frame_queue_pop(frame_queue_t *q) {
+    AVFrame *frm = NULL;
+
+    pthread_mutex_lock(&q->lock);
+
+    while (!q->count && !q->closed) {
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    }
+
+    if (q->count) {
+        frm = q->frames[q->head];
+        q->frames[q->head] = NULL;
+        q->head = (q->head + 1) % FRAME_QUEUE_DEPTH;
+        q->count--;
+
+        pthread_cond_signal(&q->not_full);
+    }
+
+    pthread_mutex_unlock(&q->lock);
+
+    return frm;
+}
+
+/*
+* No more frames from the producer, the consumer gets the queued ones
+* first. A consumer closes it to release a blocked producer.
+*/
+static void frame_queue_close(frame_queue_t *q) {
+    pthread_mutex_lock(&q->lock);
+    q->closed = 1;
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_cond_broadcast(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static int input_interrupt_cb(void *ctx) {
+    pipeline_t *pl = (pipeline_t *)ctx;
+
+    if (pl->io_deadline_us && get_time_us() > pl->io_deadline_us) {
+        return 1;
+    }
+
+    return g_quit;
+}
+
+/*the next blocking call on the input has to finish in IO_TIMEOUT*/
+static void set_io_deadline(pipeline_t *pl) {
+    pl->io_deadline_us = get_time_us() + IO_TIMEOUT * 1000000LL;
+}
+
+static int open_input(pipeline_t *pl) {
+    AVDictionary *avfmt_dict = NULL;
+    AVStream *st = NULL;
+    int err;
+    int i;
+
+    pl->ff_input_ctx = avformat_alloc_context();
+    if (!pl->ff_input_ctx) {
+        printf("Failed to allocate avformat context\n");
+        return -1;
+    }
+
+    pl->ff_input_ctx->interrupt_callback.callback = input_interrupt_cb;
+    pl->ff_input_ctx->interrupt_callback.opaque   = pl;
+
+    if (!strncmp(pl->url, "rtsp:", 5)) {
+        av_dict_set_int(&avfmt_dict, "stimeout", IO_TIMEOUT * 1000 * 1000, 0);
+    }
+
+    set_io_deadline(pl);
+    err = avformat_open_input(&pl->ff_input_ctx, pl->url, NULL, &avfmt_dict);
+    av_dict_free(&avfmt_dict);
+    if (err < 0) {
+        ff_print_error(pl->url, err);
+        printf("avformat_open_input(%s) -- Failure!\n", pl->url);
+        return -1;
+    }
+
+    set_io_deadline(pl);
+    err = avformat_find_stream_info(pl->ff_input_ctx, NULL);
+    if (err < 0) {
+        printf("%s: could not find codec parameters\n", pl->url);
+        return -1;
+    }
+
+    for (i = 0; i < pl->ff_input_ctx->nb_streams; i++) {
+        if (pl->ff_input_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            st = pl->ff_input_ctx->streams[i];
+            break;
+        }
+    }
+
+    if (!st) {
+        printf("%s: no video stream\n", pl->url);
+        return -1;
+    }
+
+    pl->video_stream_index = st->index;
+
+    pl->ff_video_ctx = dec_backend_open(&pl->backend, st->codecpar, pl->pool, 0);
+    if (!pl->ff_video_ctx) {
+        return -1;
+    }
+
+    pl->sample_next_pts = AV_NOPTS_VALUE;
+    if (pl->sample_fps > 0) {
+        pl->sample_interval = av_rescale_q((int64_t)(AV_TIME_BASE / pl->sample_fps + 0.5),
+                                           AV_TIME_BASE_Q, st->time_base);
+        if (pl->sample_interval <= 0) {
+            pl->sample_interval = 1;
+        }
+    }
+
+    return 0;
+}
+
+static void close_input(pipeline_t *pl) {
+    dec_backend_close(&pl->ff_video_ctx);
+
+    if (pl->ff_input_ctx) {
+        avformat_close_input(&pl->ff_input_ctx);
+    }
+}
+
+/*
+* Return 1 if the frame is taken as a snapshot: keep the snapshots on
+* the grid of the interval, restart it after a gap or a jump back of
+* the pts (a wrap or a restarted source)
+*/
+static int sample_frame(pipeline_t *pl, AVFrame *frm) {
+    int64_t pts = frm->best_effort_timestamp;
+
+    if (!pl->sample_interval || pts == AV_NOPTS_VALUE) {
+        return 1;
+    }
+
+    if (pl->sample_next_pts != AV_NOPTS_VALUE && pts < pl->sample_next_pts &&
+        pts >= pl->sample_next_pts - pl->sample_interval) {
+        return 0;
+    }
+
+    if (pl->sample_next_pts == AV_NOPTS_VALUE || pts < pl->sample_next_pts ||
+        pts - pl->sample_next_pts >= pl->sample_interval) {
+        pl->sample_next_pts = pts + pl->sample_interval;
+    } else {
+        pl->sample_next_pts += pl->sample_interval;
+    }
+
+    return 1;
+}
+
+/*the snapshots dropped by the full queue are not counted*/
+static int done_sampling(pipeline_t *pl) {
+    return g_quit || (pl->count && pl->nb_sampled - pl->conv_queue.nb_dropped >= pl->count);
+}
+
+/*
+* Receive the decoded frames, the snapshots are handed over to the
+* converter by reference, the other frames are dropped at once
+*   return AVERROR(EAGAIN) when the decoder needs more packets
+*/
+static int receive_frames(pipeline_t *pl) {
+    AVFrame *frm;
+    int ret;
+
+    while (!done_sampling(pl)) {
+        frm = frame_pool_get(pl->pool);
+        if (!frm) {
+            printf("failed to get a frame from the pool\n");
+            return AVERROR(ENOMEM);
+        }
+
+        ret = avcodec_receive_frame(pl->ff_video_ctx, frm);
+        if (ret < 0) {
+            frame_pool_put(pl->pool, &frm);
+            return ret;
+        }
+
+        pl->nb_decoded++;
+
+        if (!sample_frame(pl, frm)) {
+            frame_pool_put(pl->pool, &frm);
+            continue;
+        }
+
+        pl->nb_sampled++;
+        frame_queue_push(&pl->conv_queue, frm, !pl->live);
+    }
+
+    return 0;
+}
+
+static void *decThreadEntry(void *priv) {
+    pipeline_t *pl = (pipeline_t *)priv;
+    AVPacket pkt;
+    int ret;
+
+    av_init_packet(&pkt);
+
+    while (!done_sampling(pl)) {
+        set_io_deadline(pl);
+        ret = av_read_frame(pl->ff_input_ctx, &pkt);
+        if (ret < 0) {
+            if (ret != AVERROR_EOF) {
+                ff_print_error(pl->url, ret);
+            }
+            break;
+        }
+
+        if (pkt.stream_index != pl->video_stream_index) {
+            av_packet_unref(&pkt);
+            continue;
+        }
+
+        ret = avcodec_send_packet(pl->ff_video_ctx, &pkt);
+        av_packet_unref(&pkt);
+        if (ret < 0 && ret != AVERROR(EAGAIN)) {
+            /*a corrupt packet, the decoder resyncs on the next ones*/
+            printf("avcodec_send_packet() - [error: %s]\n", av_err2str(ret));
+            continue;
+        }
+
+        ret = receive_frames(pl);
+        if (ret < 0 && ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+            printf("avcodec_receive_frame() - [error: %s]\n", av_err2str(ret));
+        }
+    }
+
+    /*drain the frames held by the decoder*/
+    if (!done_sampling(pl)) {
+        avcodec_send_packet(pl->ff_video_ctx, NULL);
+        receive_frames(pl);
+    }
+
+    frame_queue_close(&pl->conv_queue);
+
+    return NULL;
+}
+
+static PicFormat_t pic_format(int format) {
+    switch (format) {
+        case AV_PIX_FMT_YUV420P:
+        case AV_PIX_FMT_YUVJ420P:
+            return PIC_FMT_YUV420;
+        case AV_PIX_FMT_NV12:
+            return PIC_FMT_NV12;
+        case AV_PIX_FMT_NV21:
+            return PIC_FMT_NV21;
+        case AV_PIX_FMT_UYVY422:
+            return PIC_FMT_UYVY;
+        case AV_PIX_FMT_YUYV422:
+            return PIC_FMT_YUYV;
+        case AV_PIX_FMT_YUV444P:
+        case AV_PIX_FMT_YUVJ444P:
+            return PIC_FMT_YUV444;
+        case AV_PIX_FMT_GRAY8:
+            return PIC_FMT_GRAY8;
+        default:
+            return PIC_FMT_MAX;
+    }
+}
+
+/*the jpeg encoder takes YUV420 and NV12 as they are*/
+static int need_convert(pipeline_t *pl, AVFrame *frm) {
+    if (pl->conv_w && (pl->conv_w != frm->width || pl->conv_h != frm->height)) {
+        return 1;
+    }
+
+    return frm->format != AV_PIX_FMT_YUV420P &&
+           frm->format != AV_PIX_FMT_YUVJ420P &&
+           frm->format != AV_PIX_FMT_NV12;
+}
+
+/*
+* (Re)create the converter for the frame, the stream may change its size
+*/
+static int setup_converter(pipeline_t *pl, AVFrame *frm) {
+    PicSetting_t *s = &pl->conv_setting;
+    PicFormat_t fmt = pic_format(frm->format);
+    int size;
+
+    if (fmt == PIC_FMT_MAX) {
+        printf("unsupported pixel format of the converter: %s\n",
+                av_get_pix_fmt_name(frm->format));
+        return -1;
+    }
+
+    if (pl->conv && s->src.format == fmt &&
+        s->src.width == frm->width && s->src.height == frm->height) {
+        return 0;
+    }
+
+    if (pl->conv) {
+        PicConvRelease(pl->conv);
+        pl->conv = NULL;
+    }
+    av_buffer_pool_uninit(&pl->conv_bufs);
+
+    memset(s, 0, sizeof(PicSetting_t));
+    s->src.format  = fmt;
+    s->src.width   = frm->width;
+    s->src.height  = frm->height;
+    s->dest.format = PIC_FMT_YUV420;
+    s->dest.width  = pl->conv_w ? pl->conv_w : frm->width;
+    s->dest.height = pl->conv_h ? pl->conv_h : frm->height;
+    s->pic_type    = PIC_DATA_TYPE_ffmpeg;
+    s->play_id     = 1;
+
+    pl->conv = PicConvInit(s);
+    if (pl->conv == NULL) {
+        printf("failed to do PicConvInit(%dx%d %s -> %dx%d yuv420)\n",
+                frm->width, frm->height, av_get_pix_fmt_name(frm->format),
+                s->dest.width, s->dest.height);
+        return -1;
+    }
+
+    size = av_image_get_buffer_size(AV_PIX_FMT_YUV420P, s->dest.width, s->dest.height, 1);
+    pl->conv_bufs = av_buffer_pool_init(size, NULL);
+    if (!pl->conv_bufs) {
+        printf("failed to init the buffer pool of %d bytes\n", size);
+        return -1;
+    }
+
+    printf("convert %dx%d %s -> %dx%d yuv420\n",
+            frm->width, frm->height, av_get_pix_fmt_name(frm->format),
+            s->dest.width, s->dest.height);
+
+    return 0;
+}
+
+/*
+* Convert the decoded frame into a YUV420 frame of the snapshot size.
+* The converter returns its own buffer which is reused by the next call,
+* so the picture is copied into a pooled buffer for the encoder thread.
+*/
+static AVFrame *convert_frame(pipeline_t *pl, AVFrame *frm) {
+    PicSetting_t *s = &pl->conv_setting;
+    unsigned int size = 0;
+    AVFrame *out;
+    int ret;
+
+    if (setup_converter(pl, frm)) {
+        return NULL;
+    }
+
+    out = frame_pool_get(pl->pool);
+    if (!out) {
+        printf("failed to get a frame from the pool\n");
+        return NULL;
+    }
+
+    out->buf[0] = av_buffer_pool_get(pl->conv_bufs);
+    if (!out->buf[0]) {
+        printf("failed to get a picture buffer\n");
+        frame_pool_put(pl->pool, &out);
+        return NULL;
+    }
+
+    av_image_fill_arrays(out->data, out->linesize, out->buf[0]->data,
+                         AV_PIX_FMT_YUV420P, s->dest.width, s->dest.height, 1);
+    out->format = AV_PIX_FMT_YUV420P;
+    out->width  = s->dest.width;
+    out->height = s->dest.height;
+    av_frame_copy_props(out, frm);
+
+    ret = PicConvProc_copy(pl->conv, (void *)frm, (void *)out->buf[0]->data, &size);
+    if (ret) {
+        printf("failed to convert the picture(ret: %d)\n", ret);
+        frame_pool_put(pl->pool, &out);
+        return NULL;
+    }
+
+    return out;
+}
+
+static void *convThreadEntry(void *priv) {
+    pipeline_t *pl = (pipeline_t *)priv;
+    AVFrame *frm;
+    AVFrame *out;
+    int64_t start_us;
+
+    while ((frm = frame_queue_pop(&pl->conv_queue)) != NULL) {
+        if (!need_convert(pl, frm)) {
+            frame_queue_push(&pl->jpeg_queue, frm, 1);
+            continue;
+        }
+
+        start_us = get_time_us();
+        out = convert_frame(pl, frm);
+        frame_pool_put(pl->pool, &frm);
+        if (!out) {
+            pl->nb_conv_errors++;
+            continue;
+        }
+
+        hdr_hist_record(pl->lat[STAGE_CONVERT], get_time_us() - start_us);
+        pl->nb_converted++;
+
+        /*wait for the encoder, the decoder side drops for a live stream*/
+        frame_queue_push(&pl->jpeg_queue, out, 1);
+    }
+
+    frame_queue_close(&pl->jpeg_queue);
+
+    if (pl->conv) {
+        PicConvRelease(pl->conv);
+        pl->conv = NULL;
+    }
+    av_buffer_pool_uninit(&pl->conv_bufs);
+
+    return NULL;
+}
+
+static JpegEnPicFormat_t jpeg_format(int format) {
+    return format == AV_PIX_FMT_NV12 ? JPEGEN_PIC_FMT_NV12 : JPEGEN_PIC_FMT_YUV420;
+}
+
+static int setup_encoder(pipeline_t *pl, AVFrame *frm) {
+    JpegEnSetting_t *s = &pl->jpeg_setting;
+    JpegEnPicFormat_t fmt = jpeg_format(frm->format);
+
+    if (pl->jpeg && s->fmt == fmt && s->width == frm->width && s->height == frm->height) {
+        return 0;
+    }
+
+    if (pl->jpeg) {
+        JpegEncoderRelease(pl->jpeg);
+        pl->jpeg = NULL;
+    }
+
+    memset(s, 0, sizeof(JpegEnSetting_t));
+    s->width   = frm->width;
+    s->height  = frm->height;
+    s->fmt     = fmt;
+    s->quality = pl->quality;
+    s->play_id = 1;
+
+    pl->jpeg = JpegEncoderInit(s);
+    if (pl->jpeg == NULL) {
+        printf("failed to do JpegEncoderInit(w: %d, h: %d)\n", frm->width, frm->height);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+*   return 0 on success, -1 if the path is too long
+*/
+static int make_snapshot_path(pipeline_t *pl, char *path, int size, uint64_t seq) {
+    if (pl->output_is_dir) {
+        snprintf(path, size, "%s/snap_%08llu.jpg", pl->output, (unsigned long long)seq);
+        return 0;
+    }
+
+    return path_pattern_format(path, size, pl->output, (long long)seq);
+}
+
+/*
+* Write the jpeg into a temporary file and rename it, the readers never
+* see a partial picture. Delete the file which falls out of the rotation.
+*/
+static int write_snapshot(pipeline_t *pl, const void *jpeg, int size, uint64_t seq) {
+    char path[SNAPSHOT_PATH_SIZE];
+    char tmp[SNAPSHOT_PATH_SIZE + 8];
+    int fd;
+    int ret;
+
+    if (make_snapshot_path(pl, path, sizeof(path), seq) < 0) {
+        printf("too long path of snapshot %llu\n", (unsigned long long)seq);
+        return -1;
+    }
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    fd = open(tmp, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (fd < 0) {
+        printf("failed to create jpeg file: %s(error: %s)\n", tmp, strerror(errno));
+        return -1;
+    }
+
+    ret = write(fd, jpeg, size);
+    close(fd);
+    if (ret != size) {
+        printf("failed to write %d bytes into %s(error: %s)\n", size, tmp,
+                ret < 0 ? strerror(errno) : "short write");
+        unlink(tmp);
+        return -1;
+    }
+
+    if (rename(tmp, path)) {
+        printf("failed to rename %s(error: %s)\n", tmp, strerror(errno));
+        unlink(tmp);
+        return -1;
+    }
+
+    if (pl->max_files && seq >= pl->max_files && (pl->output_is_dir || pl->output_is_pattern)) {
+        if (!make_snapshot_path(pl, path, sizeof(path), seq - pl->max_files) &&
+            unlink(path) && errno != ENOENT) {
+            printf("failed to delete %s(error: %s)\n", path, strerror(errno));
+        }
+    }
+
+    return 0;
+}
+
+static void *jpegThreadEntry(void *priv) {
+    pipeline_t *pl = (pipeline_t *)priv;
+    AVFrame *frm;
+    void *jpeg;
+    int size;
+    int ret;
+    int64_t start_us, enc_us;
+
+    while ((frm = frame_queue_pop(&pl->jpeg_queue)) != NULL) {
+        start_us = get_time_us();
+
+        ret = setup_encoder(pl, frm);
+        if (!ret) {
+            ret = JpegEncoderProc_ffmpeg(pl->jpeg, (void *)frm, &jpeg, &size);
+            if (ret) {
+                printf("failed to encode the jpeg picture(ret: %d)\n", ret);
+            }
+        }
+
+        frame_pool_put(pl->pool, &frm);
+        if (ret) {
+            pl->nb_jpeg_errors++;
+            continue;
+        }
+
+        enc_us = get_time_us();
+        hdr_hist_record(pl->lat[STAGE_ENCODE], enc_us - start_us);
+
+        if (write_snapshot(pl, jpeg, size, pl->nb_written)) {
+            pl->nb_jpeg_errors++;
+            continue;
+        }
+
+        hdr_hist_record(pl->lat[STAGE_WRITE], get_time_us() - enc_us);
+        pl->nb_written++;
+        pl->nb_jpeg_bytes += size;
+    }
+
+    if (pl->jpeg) {
+        JpegEncoderRelease(pl->jpeg);
+        pl->jpeg = NULL;
+    }
+
+    return NULL;
+}
+
+static int setup_output(pipeline_t *pl) {
+    struct stat st;
+    int len = strlen(pl->output);
+
+    if (len && pl->output[len - 1] == '/') {
+        if (mkdir(pl->output, 0755) && errno != EEXIST) {
+            printf("failed to create directory %s(error: %s)\n", pl->output, strerror(errno));
+            return -1;
+        }
+        pl->output_is_dir = 1;
+    } else if (!stat(pl->output, &st) && S_ISDIR(st.st_mode)) {
+        pl->output_is_dir = 1;
+    }
+
+    if (!pl->output_is_dir) {
+        pl->output_is_pattern = path_pattern_check(pl->output);
+        if (pl->output_is_pattern < 0) {
+            printf("invalid output path: %s, only one %%d is allowed and no other %%\n", pl->output);
+            return -1;
+        }
+    }
+
+    if (pl->max_files && !pl->output_is_dir && !pl->output_is_pattern) {
+        printf("-m is ignored, every snapshot overwrites %s\n", pl->output);
+    }
+
+    return 0;
+}
+
+static void print_summary(pipeline_t *pl, int64_t elapsed_us) {
+    int i;
+
+    printf("decoded %llu frames, %llu snapshots(%llu dropped before the converter), "
+           "%llu converted(%llu errors), %llu jpeg files of %llu bytes(%llu errors) in %.1fs\n",
+            (unsigned long long)pl->nb_decoded,
+            (unsigned long long)pl->nb_sampled,
+            (unsigned long long)pl->conv_queue.nb_dropped,
+            (unsigned long long)pl->nb_converted,
+            (unsigned long long)pl->nb_conv_errors,
+            (unsigned long long)pl->nb_written,
+            (unsigned long long)pl->nb_jpeg_bytes,
+            (unsigned long long)pl->nb_jpeg_errors,
+            elapsed_us / 1000000.0);
+
+    for (i = 0; i < STAGE_MAX; i++) {
+        if (!hdr_hist_count(pl->lat[i])) {
+            continue;
+        }
+
+        printf("    %-8s ms: p50 %.1f p99 %.1f max %.1f\n",
+                stage_names[i],
+                hdr_hist_percentile(pl->lat[i], 50) / 1000.0,
+                hdr_hist_percentile(pl->lat[i], 99) / 1000.0,
+                hdr_hist_max(pl->lat[i]) / 1000.0);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int option;
+    int ret = -1;
+    int i;
+    char *p;
+    int64_t start_us;
+    pipeline_t *pl;
+
+    pl = (pipeline_t *)malloc(sizeof(pipeline_t));
+    if (pl == NULL) {
+        printf("failed to malloc pipeline_t\n");
+        return -1;
+    }
+
+    memset(pl, 0, sizeof(pipeline_t));
+    pl->sample_fps = 1;
+    pl->quality    = 75;
+
+    /* Process options with getopt */
+    while ((option = getopt(argc, argv, "i:o:c:r:s:q:m:b:n:h")) != -1) {
+        switch (option) {
+            case 'i':
+                pl->url = optarg;
+                break;
+
+            case 'o':
+                pl->output = optarg;
+                break;
+
+            case 'c':
+                pl->count = atoi(optarg);
+                break;
+
+            case 'r':
+                pl->sample_fps = atof(optarg);
+                break;
+
+            case 's':
+                pl->conv_w = atoi(optarg);
+                p = strchr(optarg, ',');
+                pl->conv_h = p ? atoi(p + 1) : 0;
+                break;
+
+            case 'q':
+                pl->quality = atoi(optarg);
+                break;
+
+            case 'm':
+                pl->max_files = atoi(optarg);
+                break;
+
+            case 'b':
+                pl->backend.backend = dec_backend_from_name(optarg);
+                break;
+
+            case 'n':
+                pl->backend.thread_count = atoi(optarg);
+                break;
+
+            default:
+                usage(argv[0]);
+                exit(0);
+                break;
+        }
+    }
+
+    if (!pl->url || !pl->output || pl->count < 0 || pl->sample_fps < 0 ||
+        pl->max_files < 0 || pl->quality < 1 || pl->quality > 100 ||
+        ((pl->conv_w || pl->conv_h) && (pl->conv_w <= 0 || pl->conv_h <= 0 ||
+                                        (pl->conv_w & 1) || (pl->conv_h & 1))) ||
+        pl->backend.backend == DEC_BACKEND_MAX) {
+        usage(argv[0]);
+        exit(0);
+    }
+
+    if (strlen(pl->output) >= SNAPSHOT_PATH_SIZE - 32) {
+        printf("too long output path: %s\n", pl->output);
+        return -1;
+    }
+
+    /*a local file waits for the slow stages, a live stream drops the snapshots*/
+    pl->live = strstr(pl->url, "://") && strncmp(pl->url, "file:", 5);
+
+    signal(SIGINT, sigint_handler);
+    signal(SIGTERM, sigint_handler);
+
+    if (setup_output(pl)) {
+        return -1;
+    }
+
+    pl->pool = frame_pool_alloc(FRAME_POOL_FRAMES, FRAME_POOL_BUFFERS);
+    if (!pl->pool) {
+        return -1;
+    }
+
+    for (i = 0; i < STAGE_MAX; i++) {
+        pl->lat[i] = hdr_hist_alloc(LATENCY_MAX_US);
+        if (!pl->lat[i]) {
+            goto end;
+        }
+    }
+
+    if (frame_queue_init(&pl->conv_queue, pl->pool) ||
+        frame_queue_init(&pl->jpeg_queue, pl->pool)) {
+        goto end;
+    }
+
+    avformat_network_init();
+
+    start_us = get_time_us();
+
+    if (open_input(pl)) {
+        goto end;
+    }
+
+    if (pthread_create(&pl->jpeg_thread, NULL, jpegThreadEntry, pl)) {
+        printf("failed to create the jpeg encoder thread\n");
+        goto end;
+    }
+
+    if (pthread_create(&pl->conv_thread, NULL, convThreadEntry, pl)) {
+        printf("failed to create the converter thread\n");
+        frame_queue_close(&pl->jpeg_queue);
+        pthread_join(pl->jpeg_thread, NULL);
+        goto end;
+    }
+
+    if (pthread_create(&pl->dec_thread, NULL, decThreadEntry, pl)) {
+        printf("failed to create the decoder thread\n");
+        frame_queue_close(&pl->conv_queue);
+    } else {
+        pthread_join(pl->dec_thread, NULL);
+        ret = 0;
+    }
+
+    /*the stages drain their queues and stop one after the other*/
+    pthread_join(pl->conv_thread, NULL);
+    pthread_join(pl->jpeg_thread, NULL);
+
+    print_summary(pl, get_time_us() - start_us);
+
+end:
+    close_input(pl);
+
+    frame_queue_destroy(&pl->conv_queue);
+    frame_queue_destroy(&pl->jpeg_queue);
+
+    for (i = 0; i < STAGE_MAX; i++) {
+        if (pl->lat[i]) {
+            hdr_hist_free(&pl->lat[i]);
+        }
+    }
+
+    frame_pool_free(&pl->pool);
+    free(pl);
+
+    return ret;
+}